@@ -0,0 +1,72 @@
+#include "AccountId.h"
+
+// Luhn check digit for the digits of serial
+static uint64_t checkDigit(uint64_t serial) {
+    uint64_t sum = 0;
+    bool doubled = true;
+    while (serial != 0) {
+        uint64_t digit = serial % 10;
+        serial /= 10;
+        if (doubled) {
+            digit *= 2;
+            if (digit > 9) digit -= 9;
+        }
+        sum += digit;
+        doubled = !doubled;
+    }
+    return (10 - sum % 10) % 10;
+}
+
+AccountId makeAccountId(uint64_t serial) {
+    return serial * 10 + checkDigit(serial);
+}
+
+uint64_t accountSerial(AccountId id) {
+    return (id >= CHECKED_ACCOUNT_ID) ? id / 10 : 0;
+}
+
+size_t formatAccountId(AccountId id, char* buffer) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + id % 10);
+        id /= 10;
+    } while (id != 0);
+
+    buffer[0] = 'R';
+    buffer[1] = 'C';
+    for (size_t i = 0; i < count; i++) {
+        buffer[2 + i] = digits[count - 1 - i];
+    }
+    buffer[2 + count] = '\0';
+    return 2 + count;
+}
+
+string formatAccountId(AccountId id) {
+    char buffer[24];
+    size_t length = formatAccountId(id, buffer);
+    return string(buffer, length);
+}
+
+bool parseAccountId(string_view text, AccountId& id) {
+    // "RC" plus at most 19 digits, which always fits in 64 bits
+    if (text.size() < 3 || text.size() > 21 || text[0] != 'R' || text[1] != 'C') return false;
+    if (text[2] == '0') return false;
+
+    uint64_t value = 0;
+    for (size_t i = 2; i < text.size(); i++) {
+        char c = text[i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    bool legacy = value >= LEGACY_ACCOUNT_MIN && value <= LEGACY_ACCOUNT_MAX;
+    if (!legacy && (value < CHECKED_ACCOUNT_ID || makeAccountId(value / 10) != value)) return false;
+
+    id = value;
+    return true;
+}
+
+AccountId parseAccountId(string_view text) {
+    AccountId id = NO_ACCOUNT;
+    return parseAccountId(text, id) ? id : NO_ACCOUNT;
+}
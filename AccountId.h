@@ -0,0 +1,38 @@
+#ifndef ACCOUNTID_H
+#define ACCOUNTID_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Numeric identity of an account, shown to customers as "RC" + digits.
+//
+// New accounts are numbered sequentially: serial FIRST_ACCOUNT_SERIAL and
+// up, followed by a Luhn check digit, so IDs start at 8 digits and never
+// collide. Numbers issued before this scheme were random 6-digit values
+// (LEGACY_ACCOUNT_MIN to LEGACY_ACCOUNT_MAX); only those are accepted
+// without a check digit. 0 is never a valid ID.
+typedef uint64_t AccountId;
+
+const AccountId NO_ACCOUNT = 0;
+const uint64_t FIRST_ACCOUNT_SERIAL = 1000000;
+const AccountId CHECKED_ACCOUNT_ID = FIRST_ACCOUNT_SERIAL * 10;
+const AccountId LEGACY_ACCOUNT_MIN = 100000;
+const AccountId LEGACY_ACCOUNT_MAX = 999999;
+
+AccountId makeAccountId(uint64_t serial);
+// Serial an ID was issued from, or 0 for a legacy ID
+uint64_t accountSerial(AccountId id);
+
+// Writes "RC" + digits and a NUL into buffer (at least 24 bytes);
+// returns the length
+size_t formatAccountId(AccountId id, char* buffer);
+string formatAccountId(AccountId id);
+// False for anything that is not "RC" + a valid ID
+bool parseAccountId(string_view text, AccountId& id);
+// NO_ACCOUNT when text is not a valid account number
+AccountId parseAccountId(string_view text);
+
+#endif
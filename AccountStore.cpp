@@ -0,0 +1,128 @@
+#include "AccountStore.h"
+
+AccountType parseAccountType(string_view name) {
+    return (name == "Current") ? AccountType::Current : AccountType::Savings;
+}
+
+const string& accountTypeName(AccountType type) {
+    static const string SAVINGS = "Savings";
+    static const string CURRENT = "Current";
+    return (type == AccountType::Current) ? CURRENT : SAVINGS;
+}
+
+string_view AccountStore::coldField(size_t slot, ColdField field) const {
+    const ColdRef& ref = cold[slot];
+    const char* text = (ref.offset & MAPPED_TEXT) ? mappedText : coldText.data();
+    size_t offset = ref.offset & ~MAPPED_TEXT;
+    for (int i = 0; i < field; i++) {
+        offset += ref.lengths[i];
+    }
+    return string_view(text + offset, ref.lengths[field]);
+}
+
+void AccountStore::reserve(size_t count, size_t textBytes) {
+    balances.reserve(count);
+    activeFlags.reserve(count);
+    types.reserve(count);
+    ids.reserve(count);
+    cold.reserve(count);
+    coldText.reserve(textBytes);
+}
+
+void AccountStore::clear() {
+    balances.clear();
+    activeFlags.clear();
+    types.clear();
+    ids.clear();
+    cold.clear();
+    coldText.clear();
+    mappedText = nullptr;
+    for (auto& stripe : totals) {
+        for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+            stripe.balance[type].store(0, memory_order_relaxed);
+            stripe.accounts[type].store(0, memory_order_relaxed);
+        }
+    }
+}
+
+size_t AccountStore::add(AccountId id, const ColdFields& fields, AccountType type,
+                         Money balance, bool active) {
+    const string_view values[COLD_FIELDS] = {fields.holderName, fields.password, fields.creationDate};
+    ColdRef ref;
+    ref.offset = coldText.size();
+    for (int i = 0; i < COLD_FIELDS; i++) {
+        ref.lengths[i] = static_cast<uint32_t>(values[i].size());
+        coldText.append(values[i].data(), values[i].size());
+    }
+
+    ids.push_back(id);
+    balances.push_back(balance);
+    activeFlags.push_back(active ? 1 : 0);
+    types.push_back(type);
+    cold.push_back(ref);
+    size_t slot = balances.size() - 1;
+    if (active) addToTotals(slot, balance.toPaise(), 1);
+    return slot;
+}
+
+size_t AccountStore::addMapped(AccountId id, const ColdFields& fields, AccountType type,
+                               Money balance, bool active) {
+    ColdRef ref;
+    ref.offset = static_cast<uint64_t>(fields.holderName.data() - mappedText) | MAPPED_TEXT;
+    ref.lengths[NAME] = static_cast<uint32_t>(fields.holderName.size());
+    ref.lengths[PASSWORD] = static_cast<uint32_t>(fields.password.size());
+    ref.lengths[CREATED] = static_cast<uint32_t>(fields.creationDate.size());
+
+    ids.push_back(id);
+    balances.push_back(balance);
+    activeFlags.push_back(active ? 1 : 0);
+    types.push_back(type);
+    cold.push_back(ref);
+    size_t slot = balances.size() - 1;
+    if (active) addToTotals(slot, balance.toPaise(), 1);
+    return slot;
+}
+
+void AccountStore::setPassword(size_t slot, string_view password) {
+    string name(holderName(slot));
+    string created(creationDate(slot));
+    const string_view values[COLD_FIELDS] = {name, password, created};
+    ColdRef& ref = cold[slot];
+    ref.offset = coldText.size();
+    for (int i = 0; i < COLD_FIELDS; i++) {
+        ref.lengths[i] = static_cast<uint32_t>(values[i].size());
+        coldText.append(values[i].data(), values[i].size());
+    }
+}
+
+Money AccountStore::totalActiveBalance() const {
+    int64_t total = 0;
+    for (size_t i = 0; i < balances.size(); i++) {
+        // Branch-free so the loop vectorises
+        total += activeFlags[i] ? balances[i].toPaise() : 0;
+    }
+    return Money::fromPaise(total);
+}
+
+// Stripes are read one after another while writers may be updating
+// others, so a total taken during a transfer may count it on one side only
+void AccountStore::activeTotals(AccountType type, size_t& accounts, Money& balance) const {
+    size_t index = static_cast<size_t>(type);
+    int64_t count = 0;
+    int64_t paise = 0;
+    for (const auto& stripe : totals) {
+        count += stripe.accounts[index].load(memory_order_relaxed);
+        paise += stripe.balance[index].load(memory_order_relaxed);
+    }
+    accounts = static_cast<size_t>(count);
+    balance = Money::fromPaise(paise);
+}
+
+size_t AccountStore::memoryUsage() const {
+    return balances.capacity() * sizeof(Money) +
+           activeFlags.capacity() * sizeof(uint8_t) +
+           types.capacity() * sizeof(AccountType) +
+           ids.capacity() * sizeof(AccountId) +
+           cold.capacity() * sizeof(ColdRef) +
+           coldText.capacity();
+}
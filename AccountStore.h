@@ -0,0 +1,140 @@
+#ifndef ACCOUNTSTORE_H
+#define ACCOUNTSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Money.h"
+#include "AccountId.h"
+
+using namespace std;
+
+enum class AccountType : uint8_t {
+    Savings,
+    Current
+};
+const size_t ACCOUNT_TYPES = 2;
+
+// "Current" maps to Current; anything else is a savings account
+AccountType parseAccountType(string_view name);
+const string& accountTypeName(AccountType type);
+
+// Column store for the account table. Fields touched by every balance
+// check and scan (balance, active flag, account ID, type) live in dense
+// parallel arrays indexed by slot. The strings only needed for login,
+// display and persistence are packed end to end in one cold text buffer
+// and handed out as views, so no account owns a heap allocation.
+//
+// Slots added by addMapped() keep their cold text in a read-only mapping
+// of the table's data file instead (setMappedText()), so it is paged in by
+// the OS on first use rather than copied at startup.
+//
+// Slots are never removed, and the only cold field that changes is the
+// password when a legacy one is replaced by a hash. Callers serialise
+// access per slot; adding an account or setting a password may reallocate
+// every column (and invalidate views), so both need exclusive access.
+//
+// Active account counts and balances per account type are kept as running
+// totals, updated by every balance or status change, so they can be read
+// at any time without a scan or a lock. They are split over TOTAL_STRIPES
+// cache lines so writers on different slots rarely share one.
+class AccountStore {
+public:
+    struct ColdFields {
+        string_view holderName;
+        string_view password;
+        string_view creationDate;
+    };
+    // Read-only view of the hot columns for whole-table scans
+    struct Columns {
+        const Money* balances;
+        const uint8_t* active;
+        const AccountType* types;
+        const AccountId* ids;
+        size_t count;
+    };
+
+private:
+    enum ColdField { NAME, PASSWORD, CREATED, COLD_FIELDS };
+    // The fields are stored end to end from offset, in coldText or, with
+    // MAPPED_TEXT set, in mappedText
+    static const uint64_t MAPPED_TEXT = uint64_t(1) << 63;
+    struct ColdRef {
+        uint64_t offset;
+        uint32_t lengths[COLD_FIELDS];
+    };
+
+    vector<Money> balances;
+    vector<uint8_t> activeFlags;
+    vector<AccountType> types;
+    vector<AccountId> ids;
+    vector<ColdRef> cold;
+    string coldText;
+    const char* mappedText = nullptr;
+
+    static const size_t TOTAL_STRIPES = 64;
+    struct alignas(64) TotalStripe {
+        atomic<int64_t> balance[ACCOUNT_TYPES];
+        atomic<int64_t> accounts[ACCOUNT_TYPES];
+    };
+    vector<TotalStripe> totals = vector<TotalStripe>(TOTAL_STRIPES);
+
+    string_view coldField(size_t slot, ColdField field) const;
+    void addToTotals(size_t slot, int64_t balance, int64_t accounts) {
+        TotalStripe& stripe = totals[slot % TOTAL_STRIPES];
+        size_t type = static_cast<size_t>(types[slot]);
+        stripe.balance[type].fetch_add(balance, memory_order_relaxed);
+        stripe.accounts[type].fetch_add(accounts, memory_order_relaxed);
+    }
+
+public:
+    size_t size() const { return balances.size(); }
+    void reserve(size_t count, size_t textBytes = 0);
+    void clear();
+    size_t add(AccountId id, const ColdFields& fields, AccountType type, Money balance, bool active);
+    // The caller keeps text mapped for as long as the table is in use
+    void setMappedText(const char* text) { mappedText = text; }
+    // Like add(), but the cold fields are left where they are: they must
+    // lie end to end (name, password, creation date) in the mapped text
+    size_t addMapped(AccountId id, const ColdFields& fields, AccountType type, Money balance, bool active);
+
+    // Hot columns
+    Money balance(size_t slot) const { return balances[slot]; }
+    void setBalance(size_t slot, Money value) {
+        if (activeFlags[slot]) addToTotals(slot, value.toPaise() - balances[slot].toPaise(), 0);
+        balances[slot] = value;
+    }
+    bool isActive(size_t slot) const { return activeFlags[slot] != 0; }
+    void setActive(size_t slot, bool active) {
+        if (isActive(slot) == active) return;
+        int64_t sign = active ? 1 : -1;
+        addToTotals(slot, sign * balances[slot].toPaise(), sign);
+        activeFlags[slot] = active ? 1 : 0;
+    }
+    AccountType type(size_t slot) const { return types[slot]; }
+    AccountId id(size_t slot) const { return ids[slot]; }
+
+    // Cold fields; views stay valid until the next add()
+    string_view holderName(size_t slot) const { return coldField(slot, NAME); }
+    string_view password(size_t slot) const { return coldField(slot, PASSWORD); }
+    string_view creationDate(size_t slot) const { return coldField(slot, CREATED); }
+    // Rewrites the slot's cold fields at the end of the text buffer; the
+    // old copy stays behind until the table is next rebuilt from a file
+    void setPassword(size_t slot, string_view password);
+
+    // Sum of all active balances; reads only the balance and flag columns
+    Money totalActiveBalance() const;
+    // Running totals over active accounts of one type; no scan
+    void activeTotals(AccountType type, size_t& accounts, Money& balance) const;
+    Columns columns() const {
+        return Columns{balances.data(), activeFlags.data(), types.data(), ids.data(), balances.size()};
+    }
+    size_t textBytes() const { return coldText.size(); }
+    // Bytes allocated by the columns and the cold text buffer; mapped text
+    // is not counted
+    size_t memoryUsage() const;
+};
+
+#endif
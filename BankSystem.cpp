@@ -1,12 +1,19 @@
 #include "BankSystem.h"
+#include "Metrics.h"
 #include <random>
 #include <chrono>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <atomic>
+#include <filesystem>
+#include <thread>
 
 // BankAccount class implementation
 BankAccount::BankAccount() : accountNumber(""), accountHolderName(""), password(""), 
-                            balance(0.0), accountType("Savings"), creationDate(""), isActive(true) {}
+                            balance(), accountType("Savings"), creationDate(""), isActive(true) {}
 
-BankAccount::BankAccount(string accNo, string name, string pass, double bal, string type) 
+BankAccount::BankAccount(string accNo, string name, string pass, Money bal, string type) 
     : accountNumber(accNo), accountHolderName(name), password(pass), balance(bal), 
       accountType(type), isActive(true) {
     creationDate = getCurrentDate();
@@ -15,635 +22,2347 @@ BankAccount::BankAccount(string accNo, string name, string pass, double bal, str
 void BankAccount::setAccountNumber(const string& accNo) { accountNumber = accNo; }
 void BankAccount::setAccountHolderName(const string& name) { accountHolderName = name; }
 void BankAccount::setPassword(const string& pass) { password = pass; }
-void BankAccount::setBalance(double bal) { balance = bal; }
+void BankAccount::setBalance(Money bal) { balance = bal; }
 void BankAccount::setAccountType(const string& type) { accountType = type; }
 void BankAccount::setCreationDate(const string& date) { creationDate = date; }
 void BankAccount::setActiveStatus(bool status) { isActive = status; }
 
-string BankAccount::getAccountNumber() const { return accountNumber; }
-string BankAccount::getAccountHolderName() const { return accountHolderName; }
-string BankAccount::getPassword() const { return password; }
-double BankAccount::getBalance() const { return balance; }
-string BankAccount::getAccountType() const { return accountType; }
-string BankAccount::getCreationDate() const { return creationDate; }
+const string& BankAccount::getAccountNumber() const { return accountNumber; }
+const string& BankAccount::getAccountHolderName() const { return accountHolderName; }
+const string& BankAccount::getPassword() const { return password; }
+Money BankAccount::getBalance() const { return balance; }
+const string& BankAccount::getAccountType() const { return accountType; }
+const string& BankAccount::getCreationDate() const { return creationDate; }
 bool BankAccount::getActiveStatus() const { return isActive; }
 
+// Same text as ctime() without the trailing newline, but safe to call
+// from several threads at once. Statements format many rows from the same
+// day, so each thread keeps the last day's text and only fills in the time
+// of day while rows stay inside it.
+static void localTime(time_t when, tm& local) {
+#ifdef _WIN32
+    localtime_s(&local, &when);
+#else
+    localtime_r(&when, &local);
+#endif
+}
+
+static size_t writeDate(time_t when, char* buffer) {
+    thread_local time_t dayStart = 1;
+    thread_local time_t dayEnd = 0;
+    thread_local char dayText[32];
+    thread_local size_t dayLength = 0;
+    
+    if (when < dayStart || when >= dayEnd) {
+        tm local;
+        localTime(when, local);
+        dayLength = strftime(dayText, sizeof(dayText), "%a %b %e %H:%M:%S %Y", &local);
+        tm midnight = local;
+        midnight.tm_hour = midnight.tm_min = midnight.tm_sec = 0;
+        midnight.tm_isdst = -1;
+        dayStart = mktime(&midnight);
+        midnight.tm_mday++;
+        midnight.tm_hour = midnight.tm_min = midnight.tm_sec = 0;
+        midnight.tm_isdst = -1;
+        dayEnd = mktime(&midnight);
+        // Days with a clock change are formatted one row at a time
+        if (dayStart == -1 || dayEnd - dayStart != 86400) {
+            dayStart = 1;
+            dayEnd = 0;
+            memcpy(buffer, dayText, dayLength + 1);
+            return dayLength;
+        }
+    }
+    
+    // "Sat Oct 18 01:12:00 2026": the time of day is always at offset 11
+    int seconds = static_cast<int>(when - dayStart);
+    char* clock = dayText + 11;
+    clock[0] = static_cast<char>('0' + seconds / 36000);
+    clock[1] = static_cast<char>('0' + seconds / 3600 % 10);
+    clock[3] = static_cast<char>('0' + seconds / 600 % 6);
+    clock[4] = static_cast<char>('0' + seconds / 60 % 10);
+    clock[6] = static_cast<char>('0' + seconds % 60 / 10);
+    clock[7] = static_cast<char>('0' + seconds % 10);
+    memcpy(buffer, dayText, dayLength + 1);
+    return dayLength;
+}
+
+static string formatDate(time_t when) {
+    char buffer[32];
+    return string(buffer, writeDate(when, buffer));
+}
+
 string BankAccount::getCurrentDate() const {
-    time_t now = time(0);
-    char* dt = ctime(&now);
-    string dateStr(dt);
-    dateStr.pop_back(); // Remove newline character
-    return dateStr;
+    return formatDate(time(0));
 }
 
 bool BankAccount::validatePassword(const string& pass) const {
-    return password == pass;
+    return verifyPassword(pass, password);
+}
+
+// Transaction text, built only when a row is displayed or logged. Transfer
+// names are prefixes followed by the counterparty's account number.
+static const char* const TRANSACTION_TYPE_NAMES[] = {
+    "Account Opening",
+    "Deposit",
+    "Withdrawal",
+    "Transfer Out to ",
+    "Transfer In from ",
+    "Account Deactivated",
+    "Other"
+};
+
+static bool isTransfer(TransactionType type) {
+    return type == TransactionType::TransferOut || type == TransactionType::TransferIn;
+}
+
+static char* appendText(char* out, const char* text) {
+    size_t length = strlen(text);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+static size_t writeDescription(const Transaction& trans, char* buffer) {
+    char* out = appendText(buffer, TRANSACTION_TYPE_NAMES[static_cast<int>(trans.type)]);
+    if (isTransfer(trans.type)) {
+        out += formatAccountId(trans.counterparty, out);
+    }
+    return out - buffer;
+}
+
+string Transaction::description() const {
+    char buffer[64];
+    return string(buffer, writeDescription(*this, buffer));
+}
+
+string Transaction::dateText() const {
+    return formatDate(static_cast<time_t>(timestamp));
 }
 
 // BankingSystem class implementation
-BankingSystem::BankingSystem() {
-    loadAccountsFromFile();
-    loadTransactionsFromFile();
+static atomic<size_t> lazyCacheBytes(0);
+
+void setLazyLoading(size_t cacheBytes) {
+    lazyCacheBytes = cacheBytes;
 }
 
-BankingSystem::~BankingSystem() {
-    saveAccountsToFile();
-    saveTransactionsToFile();
+static atomic<unsigned> textLoadThreads(0);
+
+void setLoadThreads(unsigned threads) {
+    textLoadThreads = threads;
 }
 
-void BankingSystem::displayHeader() {
-    cout << "\n";
-    cout << "╔══════════════════════════════════════════════════════════════╗\n";
-    cout << "║              RIDDHI'S ADVANCED BANKING SYSTEM                ║\n";
-    cout << "║                   Enhanced Version 2.0                      ║\n";
-    cout << "║                                                              ║\n";
-    cout << "║  Developer: Riddhi Chakraborty                               ║\n";
-    cout << "║  Professional Banking Management System                      ║\n";
-    cout << "╚══════════════════════════════════════════════════════════════╝\n";
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
 }
 
-void BankingSystem::displayFooter() {
-    cout << "\n╔══════════════════════════════════════════════════════════════╗\n";
-    cout << "║                                                              ║\n";
-    cout << "║           Thank you for using Riddhi's Banking System!      ║\n";
-    cout << "║                    Banking made simple & secure             ║\n";
-    cout << "╚══════════════════════════════════════════════════════════════╝\n";
+BankingSystem::BankingSystem(const string& directory)
+    : nextAccountSerial(FIRST_ACCOUNT_SERIAL), serialStride(1), serialOffset(0),
+      dataDirectory(directory), ledgerCacheBytes(lazyCacheBytes.load()), loadThreads(textLoadThreads.load()),
+      startup(), wal(WAL_FILE), checkpointedTransactions(0), legacyLedgerFile(false), nextLogGeneration(1),
+      tornLogGroup(false), damagedLog(false), sessions(SESSION_TTL_SECONDS),
+      checkpointDue(false), stopping(false) {
+    if (!dataDirectory.empty()) {
+        filesystem::create_directories(dataDirectory);
+    }
+    auto loadStart = chrono::steady_clock::now();
+    auto phaseStart = loadStart;
+    if (!loadAccountsFromBinaryFile()) {
+        loadAccountsFromFile();
+        startup.text = true;
+    }
+    startup.accountsSeconds = secondsSince(phaseStart);
+    phaseStart = chrono::steady_clock::now();
+    if (!loadTransactionsFromBinaryFile()) {
+        loadTransactionsFromFile();
+        startup.text = true;
+    }
+    startup.ledgerSeconds = secondsSince(phaseStart);
+    phaseStart = chrono::steady_clock::now();
+    loadIdempotencyKeys();
+    replayWriteAheadLog();
+    startup.replaySeconds = secondsSince(phaseStart);
+    startup.totalSeconds = secondsSince(loadStart);
+    startup.accounts = accounts.size();
+    startup.rows = transactions.size();
+    wal.open();
+    if (!sealedLogs.empty() || tornLogGroup || damagedLog || wal.size() > WAL_CHECKPOINT_BYTES) {
+        checkpoint();
+    }
+    checkpointer = thread(&BankingSystem::runCheckpointer, this);
 }
 
-void BankingSystem::displayMainMenu() {
-    clearScreen();
-    displayHeader();
-    cout << "\n┌─────────────────── MAIN MENU ───────────────────┐\n";
-    cout << "│  1. Create New Account                          │\n";
-    cout << "│  2. Deposit Money                               │\n";
-    cout << "│  3. Withdraw Money                              │\n";
-    cout << "│  4. Check Balance                               │\n";
-    cout << "│  5. View Account Details                        │\n";
-    cout << "│  6. Transfer Money                              │\n";
-    cout << "│  7. Transaction History                         │\n";
-    cout << "│  8. Generate Account Statement                  │\n";
-    cout << "│  9. Deactivate Account                          │\n";
-    cout << "│  0. Exit System                                 │\n";
-    cout << "└─────────────────────────────────────────────────┘\n";
-    cout << "\n➤ Enter your choice: ";
+// Every change is already in the log; only fold it into the data files
+// once the log has grown large enough to slow down the next startup
+BankingSystem::~BankingSystem() {
+    {
+        lock_guard<mutex> wakeLock(checkpointerMutex);
+        stopping = true;
+    }
+    checkpointWake.notify_one();
+    checkpointer.join();
+    {
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        wal.sync();
+    }
+    if (wal.size() > WAL_CHECKPOINT_BYTES) {
+        checkpoint();
+    }
 }
 
-void BankingSystem::clearScreen() {
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
+// Background checkpoints: one each interval while there are logged
+// changes, or sooner once the log passes WAL_CHECKPOINT_BYTES, so a
+// restart replays at most a short log tail
+void BankingSystem::runCheckpointer() {
+    unique_lock<mutex> wakeLock(checkpointerMutex);
+    while (!stopping) {
+        checkpointWake.wait_for(wakeLock, chrono::seconds(CHECKPOINT_INTERVAL_SECONDS),
+                                [this]() { return stopping || checkpointDue; });
+        if (stopping) break;
+        checkpointDue = false;
+        wakeLock.unlock();
+        
+        bool logged;
+        {
+            lock_guard<mutex> ledgerLock(ledgerMutex);
+            logged = wal.size() > 0;
+        }
+        if (logged && checkpoint()) {
+            compactLedger();
+        }
+        wakeLock.lock();
+    }
 }
 
-void BankingSystem::pauseScreen() {
-    cout << "\nPress Enter to continue...";
-    cin.ignore();
-    cin.get();
+string BankingSystem::dataPath(const string& name) const {
+    return dataDirectory.empty() ? name : dataDirectory + "/" + name;
 }
 
-string BankingSystem::generateAccountNumber() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> dis(100000, 999999);
-    
-    string accNo;
-    bool unique = false;
-    
-    while (!unique) {
-        accNo = "RC" + to_string(dis(gen));
-        unique = (findAccountIndex(accNo) == -1);
+// Serials only move forward, so a new ID is one step with no retries; the
+// index check guards against hand-edited data files. Deactivated accounts
+// stay in the index, so their numbers are never reissued.
+AccountId BankingSystem::generateAccountId() {
+    for (;;) {
+        uint64_t serial = nextAccountSerial++;
+        if (serial % serialStride != serialOffset) continue;
+        AccountId id = makeAccountId(serial);
+        if (accountIndex.find(id) == accountIndex.end()) return id;
     }
-    
-    return accNo;
+}
+
+void BankingSystem::partitionAccountSerials(uint64_t partition, uint64_t partitions) {
+    unique_lock<shared_mutex> tableLock(accountsMutex);
+    serialStride = max<uint64_t>(partitions, 1);
+    serialOffset = partition % serialStride;
 }
 
 bool BankingSystem::isValidAccountNumber(const string& accountNo) {
     return findAccountIndex(accountNo) != -1;
 }
 
+// Slot of an account whether or not it is active; caller holds accountsMutex
+// Timed here, so every operation's lookup is counted, not only the
+// console's findAccountIndex()
+int BankingSystem::findSlot(AccountId id) const {
+    MetricTimer timer(Metric::FindAccount);
+    auto it = accountIndex.find(id);
+    return (it == accountIndex.end()) ? -1 : static_cast<int>(it->second);
+}
+
 int BankingSystem::findAccountIndex(const string& accountNo) {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return -1;
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    return accounts.isActive(slot) ? slot : -1;
+}
+
+void BankingSystem::indexAccount(size_t slot) {
+    if (accounts.id(slot) == NO_ACCOUNT) return;
+    auto result = accountIndex.emplace(accounts.id(slot), slot);
+    // Older data files may hold a reissued number; the active holder wins
+    if (!result.second && !accounts.isActive(result.first->second)) {
+        result.first->second = slot;
+    }
+}
+
+void BankingSystem::rebuildAccountIndex() {
+    accountIndex.clear();
+    accountIndex.reserve(accounts.size());
     for (size_t i = 0; i < accounts.size(); i++) {
-        if (accounts[i].getAccountNumber() == accountNo && accounts[i].getActiveStatus()) {
-            return i;
-        }
+        indexAccount(i);
     }
-    return -1;
 }
 
-bool BankingSystem::authenticateUser(string& accountNo) {
-    cout << "\n┌─────────── USER AUTHENTICATION ───────────┐\n";
-    cout << "│ Account Number: ";
-    cin >> accountNo;
-    
-    int index = findAccountIndex(accountNo);
-    if (index == -1) {
-        cout << "│ ❌ Invalid account number!                │\n";
-        cout << "└────────────────────────────────────────────┘\n";
-        return false;
+// Caller holds accountsMutex exclusively
+size_t BankingSystem::addAccount(const BankAccount& acc) {
+    AccountId id = parseAccountId(acc.getAccountNumber());
+    nextAccountSerial = max(nextAccountSerial, accountSerial(id) + 1);
+    
+    AccountStore::ColdFields fields;
+    fields.holderName = acc.getAccountHolderName();
+    fields.password = acc.getPassword();
+    fields.creationDate = acc.getCreationDate();
+    return accounts.add(id, fields, parseAccountType(acc.getAccountType()),
+                        acc.getBalance(), acc.getActiveStatus());
+}
+
+// Caller holds the slot's account lock
+BankAccount BankingSystem::accountAt(size_t slot) const {
+    BankAccount acc;
+    acc.setAccountNumber(formatAccountId(accounts.id(slot)));
+    acc.setAccountHolderName(string(accounts.holderName(slot)));
+    acc.setPassword(string(accounts.password(slot)));
+    acc.setBalance(accounts.balance(slot));
+    acc.setAccountType(accountTypeName(accounts.type(slot)));
+    acc.setCreationDate(string(accounts.creationDate(slot)));
+    acc.setActiveStatus(accounts.isActive(slot));
+    return acc;
+}
+
+Transaction BankingSystem::makeTransaction(AccountId accountId, TransactionType type, Money amount,
+                                           Money newBalance, int64_t timestamp, AccountId counterparty) {
+    Transaction trans;
+    trans.accountId = accountId;
+    trans.counterparty = counterparty;
+    trans.timestamp = timestamp;
+    trans.amount = amount;
+    trans.balanceAfter = newBalance;
+    trans.type = type;
+    trans.transferId = 0;
+    return trans;
+}
+
+ErrorCode BankingSystem::checkDebit(Money balance, Money amount) const {
+    if (amount > balance) return ErrorCode::InsufficientBalance;
+    if ((balance - amount) < MIN_BALANCE) return ErrorCode::MinimumBalance;
+    return ErrorCode::Success;
+}
+
+// Set by deferLogSync() for the calling thread only
+static thread_local bool logSyncDeferred = false;
+// Last record the calling thread logged and has not waited for yet
+static thread_local uint64_t uncommittedLsn = 0;
+// Set when the log refused one of the calling thread's records
+static thread_local bool logRefused = false;
+
+BankingSystem::StripeScan::StripeScan(const BankingSystem& owner) : bank(owner) {
+    for (auto& stripe : bank.accountLocks) {
+        stripe.lock.lock();
     }
-    
-    string password;
-    cout << "│ Password: ";
-    cin >> password;
-    
-    if (!accounts[index].validatePassword(password)) {
-        cout << "│ ❌ Incorrect password!                    │\n";
-        cout << "└────────────────────────────────────────────┘\n";
+}
+
+BankingSystem::StripeScan::~StripeScan() {
+    for (auto it = bank.accountLocks.rbegin(); it != bank.accountLocks.rend(); ++it) {
+        it->lock.unlock();
+    }
+}
+
+// Declared ahead of an operation's locks so it runs after they are
+// released: waits for the records the operation logged to reach disk, so
+// other threads keep appending while this one waits for the log writer
+class LogCommit {
+private:
+    WriteAheadLog& log;
+
+public:
+    explicit LogCommit(WriteAheadLog& wal) : log(wal) {}
+    ~LogCommit() {
+        if (uncommittedLsn != 0) log.commit(uncommittedLsn);
+        uncommittedLsn = 0;
+        logRefused = false;
+    }
+    LogCommit(const LogCommit&) = delete;
+    LogCommit& operator=(const LogCommit&) = delete;
+
+    // Runs an operation that takes its own locks, then waits for what it
+    // logged. Nothing is acknowledged that is not on disk: a failed log
+    // refuses the operation up front, and a record it refused or could not
+    // write turns a success into IoError.
+    template <typename Operation>
+    Result run(Operation operation) {
+        if (log.failed()) return Result(ErrorCode::IoError);
+        Result result = operation();
+        bool durable = !logRefused && (uncommittedLsn == 0 || log.commit(uncommittedLsn));
+        uncommittedLsn = 0;
+        logRefused = false;
+        return (durable || !result.ok()) ? result : Result(ErrorCode::IoError);
+    }
+};
+
+// Caller holds ledgerMutex, which keeps log records in ledger order. The
+// append itself never waits for disk. False if the log has failed.
+bool BankingSystem::logRecord(string_view record, bool deferSync) {
+    uint64_t lsn = wal.append(record, true);
+    if (lsn == 0) {
+        logRefused = true;
         return false;
     }
-    
-    cout << "│ ✅ Authentication successful!             │\n";
-    cout << "└────────────────────────────────────────────┘\n";
+    if (!deferSync && !logSyncDeferred) uncommittedLsn = lsn;
     return true;
 }
 
-void BankingSystem::addTransaction(const string& accountNo, const string& type, double amount, double newBalance) {
-    Transaction trans;
-    trans.accountNo = accountNo;
-    trans.type = type;
-    trans.amount = amount;
-    trans.balanceAfter = newBalance;
-    
-    time_t now = time(0);
-    char* dt = ctime(&now);
-    string dateStr(dt);
-    dateStr.pop_back();
-    trans.date = dateStr;
-    
+// Caller holds ledgerMutex. Rows for one account are appended while its
+// account lock is held, so ledger order matches balance order.
+bool BankingSystem::appendLedgerRow(const Transaction& trans, bool deferSync) {
+    MetricTimer timer(Metric::LedgerAppend);
+    char record[TRANSACTION_RECORD_MAX + 32];
+    char* out = record;
+    *out++ = 'T';
+    *out++ = '|';
+    out = to_chars(out, out + 24, transactions.size()).ptr;
+    *out++ = '|';
+    out += formatTransactionRecord(trans, out);
+    bool logged = logRecord(string_view(record, out - record), deferSync);
+    transactionIndex[trans.accountId].push_back(transactions.size());
     transactions.push_back(trans);
+    
+    if (wal.size() > WAL_CHECKPOINT_BYTES) {
+        lock_guard<mutex> wakeLock(checkpointerMutex);
+        if (!checkpointDue) {
+            checkpointDue = true;
+            checkpointWake.notify_one();
+        }
+    }
+    return logged;
 }
 
-void BankingSystem::createNewAccount() {
-    clearScreen();
-    displayHeader();
-    cout << "\n┌─────────── CREATE NEW ACCOUNT ───────────┐\n";
-    
-    string name, password, accountType;
-    double initialDeposit;
-    
-    cin.ignore();
-    cout << "│ Account Holder Name: ";
-    getline(cin, name);
+void BankingSystem::addTransaction(AccountId accountId, TransactionType type, Money amount, Money newBalance) {
+    Transaction trans = makeTransaction(accountId, type, amount, newBalance, time(0));
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    appendLedgerRow(trans);
+}
+
+void BankingSystem::rebuildTransactionIndex() {
+    transactionIndex.clear();
+    for (size_t i = transactions.firstResident(); i < transactions.size(); i++) {
+        transactionIndex[transactions[i].accountId].push_back(i);
+    }
+}
+
+time_t BankingSystem::parseTransactionDate(const string& date) {
+    tm parsed = {};
+    istringstream ss(date);
+    ss >> get_time(&parsed, "%a %b %d %H:%M:%S %Y");
+    if (ss.fail()) return -1;
+    parsed.tm_isdst = -1;
+    return mktime(&parsed);
+}
+
+// Inverse of Transaction::description(); unknown text becomes Other
+bool BankingSystem::parseTransactionType(string_view text, TransactionType& type, AccountId& counterparty) {
+    counterparty = NO_ACCOUNT;
+    for (int i = 0; i < static_cast<int>(TransactionType::Other); i++) {
+        TransactionType candidate = static_cast<TransactionType>(i);
+        string_view name = TRANSACTION_TYPE_NAMES[i];
+        if (isTransfer(candidate)) {
+            if (text.substr(0, name.size()) != name) continue;
+            counterparty = parseAccountId(text.substr(name.size()));
+        } else if (text != name) {
+            continue;
+        }
+        type = candidate;
+        return true;
+    }
+    type = TransactionType::Other;
+    return false;
+}
+
+// Rebuilds the cold list from ledgerSegments: every row before the first
+// resident one, each taken from the first segment holding it
+void BankingSystem::refreshColdSegments() {
+    size_t coldEnd = transactions.firstResident();
+    size_t rows = 0;
+    coldSegments.clear();
+    for (const auto& segment : ledgerSegments) {
+        size_t first = max(rows, segment.first);
+        size_t end = min(segment.end, coldEnd);
+        if (first >= end) continue;
+        coldSegments.push_back({segment.path, first, end, first - segment.first});
+        rows = end;
+    }
+}
+
+bool BankingSystem::coldSpan(const ColdSegment& cold, int64_t& minTimestamp, int64_t& maxTimestamp) const {
+    if (ledgerCache->span(cold.path, minTimestamp, maxTimestamp)) return true;
+    ledgerCache->get(cold.path, cold.skip, cold.skip + cold.end - cold.first);
+    return ledgerCache->span(cold.path, minTimestamp, maxTimestamp);
+}
+
+// Null when the segment is known to hold no rows in [fromTime, toTime]
+shared_ptr<const CachedSegment> BankingSystem::loadColdSegment(const ColdSegment& cold, int64_t fromTime,
+                                                               int64_t toTime) const {
+    int64_t minTimestamp;
+    int64_t maxTimestamp;
+    if (ledgerCache->span(cold.path, minTimestamp, maxTimestamp) &&
+        (maxTimestamp < fromTime || minTimestamp > toTime)) {
+        return nullptr;
+    }
+    return ledgerCache->get(cold.path, cold.skip, cold.skip + cold.end - cold.first);
+}
+
+// Calls visit(row) for every cold row in a day partition that may hold
+// rows in [fromTime, toTime], oldest first. Callers hold coldMutex shared.
+template <typename Visit>
+void BankingSystem::visitColdRows(int64_t fromTime, int64_t toTime, Visit visit) const {
+    for (const auto& cold : coldSegments) {
+        shared_ptr<const CachedSegment> segment = loadColdSegment(cold, fromTime, toTime);
+        if (!segment) continue;
+        for (const auto& partition : segment->rows.partitionsBetween(fromTime, toTime)) {
+            for (size_t i = partition.first; i < partition.end; i++) {
+                visit(segment->rows[i]);
+            }
+        }
+    }
+}
+
+// Returns one account's rows, oldest first. A zero fromDate/toDate leaves
+// that end of the range open; a non-zero limit keeps only the most recent
+// rows. The ledger's day partitions give the span of rows that can fall in
+// the date range; the account's postings are cut to that span by binary
+// search and each remaining row's timestamp is checked, so late rows that
+// arrived out of time order are still found.
+//
+// In lazy mode older rows may still be on disk. Cold segments are then
+// searched newest first, through the segment cache, until the limit is
+// met or the account's opening row is found.
+vector<Transaction> BankingSystem::findAccountTransactions(AccountId accountId, time_t fromDate,
+                                                           time_t toDate, size_t limit) {
+    int64_t fromTime = fromDate ? static_cast<int64_t>(fromDate) : INT64_MIN;
+    int64_t toTime = toDate ? static_cast<int64_t>(toDate) : INT64_MAX;
+    auto wanted = [&](const Transaction& trans) {
+        return trans.timestamp >= fromTime && trans.timestamp <= toTime;
+    };
+    // Collected newest first so a limit stops the walk early
+    vector<Transaction> history;
+    bool opened = false;
+    {
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        auto it = transactionIndex.find(accountId);
+        if (it != transactionIndex.end()) {
+            const vector<size_t>& postings = it->second;
+            opened = transactions[postings.front()].type == TransactionType::AccountOpening;
+            auto first = postings.begin();
+            auto last = postings.end();
+            if (fromDate != 0 || toDate != 0) {
+                vector<LedgerPartition> candidates = transactions.partitionsBetween(fromTime, toTime);
+                if (candidates.empty()) {
+                    first = last;
+                } else {
+                    first = lower_bound(first, last, candidates.front().first);
+                    last = lower_bound(first, last, candidates.back().end);
+                }
+            }
+            history.reserve(limit ? min(limit, static_cast<size_t>(last - first)) : last - first);
+            for (auto pos = last; pos != first && (limit == 0 || history.size() < limit);) {
+                const Transaction& trans = transactions[*--pos];
+                if (wanted(trans)) history.push_back(trans);
+            }
+        }
+    }
     
-    cout << "│ Create Password: ";
-    cin >> password;
+    if (ledgerCache && !opened) {
+        shared_lock<shared_mutex> coldLock(coldMutex);
+        for (auto cold = coldSegments.rbegin(); cold != coldSegments.rend() && !opened; ++cold) {
+            if (limit != 0 && history.size() >= limit) break;
+            shared_ptr<const CachedSegment> segment = loadColdSegment(*cold, fromTime, toTime);
+            if (!segment) continue;
+            auto found = segment->postings.find(accountId);
+            if (found == segment->postings.end()) continue;
+            const vector<uint32_t>& postings = found->second;
+            for (auto pos = postings.rbegin(); pos != postings.rend(); ++pos) {
+                if (limit != 0 && history.size() >= limit) break;
+                const Transaction& trans = segment->rows[*pos];
+                if (wanted(trans)) history.push_back(trans);
+            }
+            opened = segment->rows[postings.front()].type == TransactionType::AccountOpening;
+        }
+    }
+    reverse(history.begin(), history.end());
+    return history;
+}
+
+const char* errorMessage(ErrorCode code) {
+    switch (code) {
+        case ErrorCode::Success: return "Success";
+        case ErrorCode::AccountNotFound: return "Account not found!";
+        case ErrorCode::AccountInactive: return "Account is not active!";
+        case ErrorCode::InvalidAmount: return "Invalid amount!";
+        case ErrorCode::InsufficientBalance: return "Insufficient balance!";
+        case ErrorCode::MinimumBalance: return "Minimum balance required!";
+        case ErrorCode::SameAccount: return "Cannot transfer to same account!";
+        case ErrorCode::AuthenticationFailed: return "Incorrect password!";
+        case ErrorCode::AmountOverflow: return "Amount too large!";
+        case ErrorCode::IoError: return "File error!";
+        case ErrorCode::BadRequest: return "Malformed request!";
+        case ErrorCode::IdempotencyConflict: return "Idempotency key already used for another request!";
+        case ErrorCode::TransferHeld: return "Transfer could not be credited or returned; held for recovery!";
+    }
+    return "Unknown error!";
+}
+
+Result BankingSystem::openAccount(const string& name, const string& password,
+                                  const string& accountType, Money initialDeposit) {
+    if (initialDeposit < MIN_BALANCE) return Result(ErrorCode::MinimumBalance);
+    
+    string credential;
+    {
+        MetricTimer timer(Metric::PasswordHash);
+        credential = hashPassword(password);
+    }
+    return openAccountWithCredential(name, password, credential, accountType, initialDeposit);
+}
+
+Result BankingSystem::openAccountWithCredential(const string& name, const string& password, const string& credential,
+                                                const string& accountType, Money initialDeposit) {
+    if (initialDeposit < MIN_BALANCE) return Result(ErrorCode::MinimumBalance);
+    
+    LogCommit commit(wal);
+    return commit.run([&]() {
+        // Held until the opening row is logged so no other operation can
+        // reach the account before it exists in the ledger
+        unique_lock<shared_mutex> tableLock(accountsMutex);
+        AccountId id = generateAccountId();
+        string accountNo = formatAccountId(id);
+        BankAccount newAccount(accountNo, name, credential, initialDeposit, accountType);
+        indexAccount(addAccount(newAccount));
+        
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        logRecord("A|" + formatAccountRecord(newAccount));
+        appendLedgerRow(makeTransaction(id, TransactionType::AccountOpening, initialDeposit, initialDeposit,
+                                        time(0)));
+        // Whoever opened the account is logged in to it
+        sessions.remember(id, password);
+        
+        Result result(ErrorCode::Success, initialDeposit);
+        result.accountNo = accountNo;
+        return result;
+    });
+}
+
+// A login verified within the session TTL is answered from the cache;
+// otherwise the password is checked against the stored scrypt hash with no
+// lock held. A legacy plaintext password is replaced by a hash on success.
+Result BankingSystem::authenticate(const string& accountNo, const string& password) {
+    MetricTimer timer(Metric::Authenticate);
+    bool cached;
+    string stored;
+    Result result = beginLogin(accountNo, password, cached, stored);
+    if (!result.ok() || cached) return result;
+    
+    string upgraded;
+    if (!verifyLogin(password, stored, upgraded)) return Result(ErrorCode::AuthenticationFailed);
+    return finishLogin(accountNo, password, stored, upgraded);
+}
+
+Result BankingSystem::beginLogin(const string& accountNo, const string& password, bool& cached, string& stored) {
+    cached = false;
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
+    cached = sessions.check(accounts.id(slot), password);
+    if (!cached) stored = string(accounts.password(slot));
+    return Result(ErrorCode::Success, accounts.balance(slot));
+}
+
+bool BankingSystem::verifyLogin(const string& password, const string& stored, string& upgraded) {
+    MetricTimer timer(Metric::PasswordHash);
+    upgraded.clear();
+    if (!verifyPassword(password, stored)) return false;
+    if (!isPasswordHash(stored)) upgraded = hashPassword(password);
+    return true;
+}
+
+Result BankingSystem::finishLogin(const string& accountNo, const string& password, const string& stored,
+                                  const string& upgraded) {
+    AccountId id = parseAccountId(accountNo);
+    if (!upgraded.empty()) upgradePassword(id, stored, upgraded);
+    sessions.remember(id, password);
+    return getBalance(accountNo);
+}
+
+void BankingSystem::upgradePassword(AccountId accountId, const string& legacy, const string& hash) {
+    LogCommit commit(wal);
+    unique_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountId);
+    if (slot == -1 || accounts.password(slot) != legacy) return;
+    
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    logRecord("P|" + formatAccountId(accountId) + "|" + hash);
+    accounts.setPassword(slot, hash);
+}
+
+Result BankingSystem::postDeposit(const string& accountNo, Money amount) {
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
     
-    cout << "│ Account Type (1-Savings/2-Current): ";
-    int typeChoice;
-    cin >> typeChoice;
-    accountType = (typeChoice == 1) ? "Savings" : "Current";
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
     
-    cout << "│ Initial Deposit (Min ₹" << MIN_BALANCE << "): ₹";
-    cin >> initialDeposit;
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
     
-    if (initialDeposit < MIN_BALANCE) {
-        cout << "│ ❌ Minimum deposit required: ₹" << MIN_BALANCE << "\n";
-        cout << "└────────────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    Money newBalance;
+    if (!Money::tryAdd(accounts.balance(slot), amount, newBalance)) {
+        return Result(ErrorCode::AmountOverflow, accounts.balance(slot));
     }
+    accounts.setBalance(slot, newBalance);
+    addTransaction(accounts.id(slot), TransactionType::Deposit, amount, newBalance);
+    return Result(ErrorCode::Success, newBalance);
+}
+
+Result BankingSystem::deposit(const string& accountNo, Money amount) {
+    MetricTimer timer(Metric::Deposit);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postDeposit(accountNo, amount); });
+}
+
+Result BankingSystem::postWithdrawal(const string& accountNo, Money amount) {
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
     
-    string accountNo = generateAccountNumber();
-    BankAccount newAccount(accountNo, name, password, initialDeposit, accountType);
-    accounts.push_back(newAccount);
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
     
-    addTransaction(accountNo, "Account Opening", initialDeposit, initialDeposit);
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
     
-    cout << "│ ✅ Account created successfully!          │\n";
-    cout << "│ Your Account Number: " << accountNo << "           │\n";
-    cout << "│ Please note down your account number!     │\n";
-    cout << "└────────────────────────────────────────────┘\n";
+    Money currentBalance = accounts.balance(slot);
+    ErrorCode check = checkDebit(currentBalance, amount);
+    if (check != ErrorCode::Success) return Result(check, currentBalance);
     
-    pauseScreen();
+    Money newBalance = currentBalance - amount;
+    accounts.setBalance(slot, newBalance);
+    addTransaction(accounts.id(slot), TransactionType::Withdrawal, amount, newBalance);
+    return Result(ErrorCode::Success, newBalance);
+}
+
+Result BankingSystem::withdraw(const string& accountNo, Money amount) {
+    MetricTimer timer(Metric::Withdraw);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postWithdrawal(accountNo, amount); });
 }
 
-void BankingSystem::depositMoney() {
-    clearScreen();
-    displayHeader();
+// Both account locks are taken in stripe order, so two opposite transfers
+// can never wait on each other. Both rows go into the ledger together.
+Result BankingSystem::postTransfer(const string& fromAccount, const string& toAccount, Money amount) {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int fromSlot = findSlot(fromAccount);
+    int toSlot = findSlot(toAccount);
+    if (fromSlot == -1 || toSlot == -1) return Result(ErrorCode::AccountNotFound);
+    if (fromSlot == toSlot) return Result(ErrorCode::SameAccount);
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
+    
+    size_t firstStripe = min(fromSlot % ACCOUNT_LOCK_STRIPES, toSlot % ACCOUNT_LOCK_STRIPES);
+    size_t secondStripe = max(fromSlot % ACCOUNT_LOCK_STRIPES, toSlot % ACCOUNT_LOCK_STRIPES);
+    unique_lock<mutex> firstLock(accountLock(firstStripe));
+    unique_lock<mutex> secondLock;
+    if (secondStripe != firstStripe) {
+        secondLock = unique_lock<mutex>(accountLock(secondStripe));
+    }
     
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+    if (!accounts.isActive(fromSlot) || !accounts.isActive(toSlot)) {
+        return Result(ErrorCode::AccountInactive);
     }
     
-    int index = findAccountIndex(accountNo);
-    double amount;
+    Money fromBalance = accounts.balance(fromSlot);
+    ErrorCode check = checkDebit(fromBalance, amount);
+    if (check != ErrorCode::Success) return Result(check, fromBalance);
+    Money toBalance;
+    if (!Money::tryAdd(accounts.balance(toSlot), amount, toBalance)) {
+        return Result(ErrorCode::AmountOverflow, fromBalance);
+    }
     
-    cout << "\n┌─────────── DEPOSIT MONEY ───────────┐\n";
-    cout << "│ Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    cout << "│ Enter deposit amount: ₹";
-    cin >> amount;
+    accounts.setBalance(fromSlot, fromBalance - amount);
+    accounts.setBalance(toSlot, toBalance);
+    
+    AccountId fromId = accounts.id(fromSlot);
+    AccountId toId = accounts.id(toSlot);
+    int64_t now = time(0);
+    Transaction debit = makeTransaction(fromId, TransactionType::TransferOut, amount, fromBalance - amount, now, toId);
+    Transaction credit = makeTransaction(toId, TransactionType::TransferIn, amount, toBalance, now, fromId);
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    appendLedgerRow(debit);
+    appendLedgerRow(credit);
+    return Result(ErrorCode::Success, fromBalance - amount);
+}
+
+Result BankingSystem::transfer(const string& fromAccount, const string& toAccount, Money amount) {
+    MetricTimer timer(Metric::Transfer);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postTransfer(fromAccount, toAccount, amount); });
+}
+
+// FNV-1a over the source and every leg, in order
+static uint64_t transferFingerprint(AccountId fromId, const vector<TransferLeg>& legs) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    };
+    mix(fromId);
+    for (const auto& leg : legs) {
+        mix(leg.toAccount);
+        mix(static_cast<uint64_t>(leg.amount.toPaise()));
+    }
+    return hash;
+}
+
+// Takes the table exclusively, like applyBatch(), so the legs are checked
+// and applied with no other operation in between. The group record ahead
+// of the rows carries the row count and the idempotency key.
+Result BankingSystem::postMultiTransfer(const string& fromAccount, const vector<TransferLeg>& legs,
+                                        const string& idempotencyKey) {
+    if (legs.empty() || idempotencyKey.size() > MAX_IDEMPOTENCY_KEY ||
+        idempotencyKey.find_first_of("|\r\n") != string::npos) {
+        return Result(ErrorCode::BadRequest);
+    }
     
-    if (amount <= 0) {
-        cout << "│ ❌ Invalid amount!                  │\n";
-        cout << "└─────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    unique_lock<shared_mutex> tableLock(accountsMutex);
+    int fromSlot = findSlot(fromAccount);
+    if (fromSlot == -1) return Result(ErrorCode::AccountNotFound);
+    // A closed source answers a retry too, rather than replaying its success
+    if (!accounts.isActive(fromSlot)) return Result(ErrorCode::AccountInactive);
+    AccountId fromId = accounts.id(fromSlot);
+    uint64_t fingerprint = transferFingerprint(fromId, legs);
+    if (!idempotencyKey.empty()) {
+        lock_guard<mutex> keyLock(idempotencyMutex);
+        auto it = idempotencyKeys.find(idempotencyKey);
+        if (it != idempotencyKeys.end()) {
+            if (it->second.fingerprint != fingerprint) return Result(ErrorCode::IdempotencyConflict);
+            return Result(ErrorCode::Success, it->second.balance);
+        }
     }
     
-    double newBalance = accounts[index].getBalance() + amount;
-    accounts[index].setBalance(newBalance);
+    // An account may appear in several legs, so credits are checked
+    // against its balance with the earlier legs already added
+    vector<int> slots(legs.size());
+    unordered_map<int, Money> credited;
+    credited.reserve(legs.size());
+    Money total;
+    for (size_t i = 0; i < legs.size(); i++) {
+        const TransferLeg& leg = legs[i];
+        int slot = findSlot(leg.toAccount);
+        ErrorCode code = ErrorCode::Success;
+        if (leg.amount <= Money()) {
+            code = ErrorCode::InvalidAmount;
+        } else if (slot == -1) {
+            code = ErrorCode::AccountNotFound;
+        } else if (slot == fromSlot) {
+            code = ErrorCode::SameAccount;
+        } else if (!accounts.isActive(slot)) {
+            code = ErrorCode::AccountInactive;
+        } else {
+            Money& balance = credited.emplace(slot, accounts.balance(slot)).first->second;
+            if (!Money::tryAdd(total, leg.amount, total) || !Money::tryAdd(balance, leg.amount, balance)) {
+                code = ErrorCode::AmountOverflow;
+            }
+        }
+        if (code != ErrorCode::Success) {
+            Result failed(code, accounts.balance(fromSlot));
+            failed.accountNo = formatAccountId(leg.toAccount);
+            return failed;
+        }
+        slots[i] = slot;
+    }
+    Money fromBalance = accounts.balance(fromSlot);
+    ErrorCode check = checkDebit(fromBalance, total);
+    if (check != ErrorCode::Success) return Result(check, fromBalance);
+    
+    IdempotentResult outcome{time(0), fingerprint, fromBalance - total};
+    char group[128];
+    char* out = group;
+    out = appendText(out, "G|");
+    out = to_chars(out, out + 24, legs.size() * 2).ptr;
+    *out++ = '|';
+    out = to_chars(out, out + 24, outcome.created).ptr;
+    *out++ = '|';
+    out = to_chars(out, out + 24, outcome.balance.toPaise()).ptr;
+    *out++ = '|';
+    out = to_chars(out, out + 24, outcome.fingerprint).ptr;
+    *out++ = '|';
+    
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    logRecord(string(group, out - group) + idempotencyKey);
+    Money balance = fromBalance;
+    for (size_t i = 0; i < legs.size(); i++) {
+        const TransferLeg& leg = legs[i];
+        balance = balance - leg.amount;
+        Money toBalance = accounts.balance(slots[i]) + leg.amount;
+        accounts.setBalance(slots[i], toBalance);
+        appendLedgerRow(makeTransaction(fromId, TransactionType::TransferOut, leg.amount, balance,
+                                        outcome.created, leg.toAccount));
+        appendLedgerRow(makeTransaction(leg.toAccount, TransactionType::TransferIn, leg.amount, toBalance,
+                                        outcome.created, fromId));
+    }
+    accounts.setBalance(fromSlot, balance);
+    if (!idempotencyKey.empty()) rememberIdempotencyKey(idempotencyKey, outcome);
+    return Result(ErrorCode::Success, balance);
+}
+
+Result BankingSystem::transferToMany(const string& fromAccount, const vector<TransferLeg>& legs,
+                                     const string& idempotencyKey) {
+    MetricTimer timer(Metric::MultiTransfer);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postMultiTransfer(fromAccount, legs, idempotencyKey); });
+}
+
+Result BankingSystem::postDebitTransfer(const string& fromAccount, AccountId toAccount, Money amount, int64_t timestamp,
+                                        uint32_t transferId) {
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
+    
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(fromAccount);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
+    
+    Money currentBalance = accounts.balance(slot);
+    ErrorCode check = checkDebit(currentBalance, amount);
+    if (check != ErrorCode::Success) return Result(check, currentBalance);
+    
+    Money newBalance = currentBalance - amount;
+    accounts.setBalance(slot, newBalance);
+    Transaction debit = makeTransaction(accounts.id(slot), TransactionType::TransferOut, amount, newBalance,
+                                        timestamp, toAccount);
+    debit.transferId = transferId;
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    appendLedgerRow(debit);
+    return Result(ErrorCode::Success, newBalance);
+}
+
+Result BankingSystem::debitTransfer(const string& fromAccount, AccountId toAccount, Money amount, int64_t timestamp,
+                                    uint32_t transferId) {
+    MetricTimer timer(Metric::Transfer);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postDebitTransfer(fromAccount, toAccount, amount, timestamp, transferId); });
+}
+
+Result BankingSystem::postCreditTransfer(const string& toAccount, AccountId fromAccount, Money amount, int64_t timestamp,
+                                         uint32_t transferId) {
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
     
-    addTransaction(accountNo, "Deposit", amount, newBalance);
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(toAccount);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
     
-    cout << "│ ✅ Deposit successful!              │\n";
-    cout << "│ New Balance: ₹" << fixed << setprecision(2) << newBalance << "\n";
-    cout << "└─────────────────────────────────────┘\n";
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
     
-    pauseScreen();
+    Money newBalance;
+    if (!Money::tryAdd(accounts.balance(slot), amount, newBalance)) {
+        return Result(ErrorCode::AmountOverflow, accounts.balance(slot));
+    }
+    accounts.setBalance(slot, newBalance);
+    Transaction credit = makeTransaction(accounts.id(slot), TransactionType::TransferIn, amount, newBalance,
+                                         timestamp, fromAccount);
+    credit.transferId = transferId;
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    appendLedgerRow(credit);
+    return Result(ErrorCode::Success, newBalance);
 }
 
-void BankingSystem::withdrawMoney() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+Result BankingSystem::creditTransfer(const string& toAccount, AccountId fromAccount, Money amount, int64_t timestamp,
+                                     uint32_t transferId) {
+    MetricTimer timer(Metric::Transfer);
+    LogCommit commit(wal);
+    return commit.run([&]() { return postCreditTransfer(toAccount, fromAccount, amount, timestamp, transferId); });
+}
+
+Result BankingSystem::getBalance(const string& accountNo) {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
+    return Result(ErrorCode::Success, accounts.balance(slot));
+}
+
+// History stays readable after an account is deactivated
+Result BankingSystem::getTransactionHistory(const string& accountNo, vector<Transaction>& history,
+                                            time_t fromDate, time_t toDate, size_t limit) {
+    MetricTimer timer(Metric::History);
+    AccountId id = parseAccountId(accountNo);
+    {
+        shared_lock<shared_mutex> tableLock(accountsMutex);
+        if (findSlot(id) == -1) return Result(ErrorCode::AccountNotFound);
     }
-    
-    int index = findAccountIndex(accountNo);
-    double amount;
-    
-    cout << "\n┌─────────── WITHDRAW MONEY ───────────┐\n";
-    cout << "│ Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    cout << "│ Enter withdrawal amount: ₹";
-    cin >> amount;
-    
-    if (amount <= 0) {
-        cout << "│ ❌ Invalid amount!                   │\n";
-        cout << "└──────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    history = findAccountTransactions(id, fromDate, toDate, limit);
+    return Result(ErrorCode::Success);
+}
+
+// Statement text for one account, shared by the single-account screen and
+// the bulk month-end job so both write identical files
+static void renderStatement(string& out, AccountId id, string_view holderName, const string& accountType,
+                            Money balance, const string& generated, const string& period,
+                            const Transaction* rows, size_t count) {
+    char money[32];
+    char accountNo[24];
+    out += "RIDDHI'S BANKING SYSTEM - ACCOUNT STATEMENT\n";
+    out += "==========================================\n\n";
+    out += "Account Number: ";
+    out.append(accountNo, formatAccountId(id, accountNo));
+    out += "\nAccount Holder: ";
+    out += holderName;
+    out += "\nAccount Type: ";
+    out += accountType;
+    out += "\nCurrent Balance: ₹";
+    out += balance.format(money);
+    out += "\nStatement Generated: ";
+    out += generated;
+    if (!period.empty()) {
+        out += "\nStatement Period: ";
+        out += period;
+    }
+    out += "\n\nTRANSACTION HISTORY:\n";
+    out += "-------------------\n";
+    
+    char line[256];
+    for (size_t i = 0; i < count; i++) {
+        const Transaction& trans = rows[i];
+        char* end = line + writeDate(static_cast<time_t>(trans.timestamp), line);
+        end = appendText(end, " | ");
+        end += writeDescription(trans, end);
+        end = appendText(end, " | ₹");
+        end = appendText(end, trans.amount.format(money));
+        end = appendText(end, " | Balance: ₹");
+        end = appendText(end, trans.balanceAfter.format(money));
+        *end++ = '\n';
+        out.append(line, end - line);
+    }
+}
+
+static bool writeTextFile(const string& path, const string& text) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && written;
+}
+
+Result BankingSystem::writeAccountStatement(const string& accountNo, string& filename) {
+    MetricTimer timer(Metric::Statement);
+    BankAccount account;
+    Result result = getAccountDetails(accountNo, account);
+    if (!result.ok()) return result;
+    
+    vector<Transaction> history = findAccountTransactions(parseAccountId(accountNo));
+    string text;
+    renderStatement(text, parseAccountId(accountNo), account.getAccountHolderName(), account.getAccountType(),
+                    account.getBalance(), account.getCurrentDate(), "", history.data(), history.size());
+    
+    filename = "statement_" + accountNo + ".txt";
+    return writeTextFile(filename, text) ? result : Result(ErrorCode::IoError);
+}
+
+// Ledger rows never move and are never changed once appended, so only the
+// chunk list and row count are copied under the ledger lock
+static vector<const Transaction*> chunkList(const LedgerStore& ledger) {
+    vector<const Transaction*> chunks;
+    chunks.reserve(ledger.chunkCount());
+    for (size_t i = 0; i < ledger.chunkCount(); i++) {
+        chunks.push_back(ledger.chunk(i));
+    }
+    return chunks;
+}
+
+// Month-end statements for every active account. Balances, the row spans
+// to read and the ledger's chunk list are copied out under the shared table
+// lock, every account stripe and the ledger lock; rows past those spans
+// are not in the balances and are left out. With the locks released, the
+// rows are grouped by account with a counting sort. In lazy mode the cold
+// segments are read once, under coldMutex alone, and their rows kept as
+// they go by. The files are then rendered and written by a pool of
+// threads, each claiming a run of accounts at a time and reusing one text
+// buffer. A date range reads only the ledger's day partitions that can
+// hold rows in it.
+Result BankingSystem::writeAllStatements(const string& directory, unsigned threads, StatementRunSummary& summary,
+                                         time_t fromDate, time_t toDate) {
+    const uint32_t NO_STATEMENT = UINT32_MAX;
+    const size_t STATEMENTS_PER_CLAIM = 64;
+    auto start = chrono::steady_clock::now();
+    string generated = formatDate(time(0));
+    int64_t fromTime = fromDate ? static_cast<int64_t>(fromDate) : INT64_MIN;
+    int64_t toTime = toDate ? static_cast<int64_t>(toDate) : INT64_MAX;
+    string period;
+    if (fromDate != 0 || toDate != 0) {
+        period = (fromDate ? formatDate(fromDate) : string("first posting")) + " to " +
+                 (toDate ? formatDate(toDate) : generated);
     }
     
-    double currentBalance = accounts[index].getBalance();
-    if (amount > currentBalance) {
-        cout << "│ ❌ Insufficient balance!             │\n";
-        cout << "└──────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    struct StatementAccount {
+        AccountId id;
+        AccountType type;
+        Money balance;
+        size_t nameOffset;
+        size_t nameLength;
+    };
+    vector<StatementAccount> statements;
+    string names;
+    // Statement number of each active account
+    unordered_map<AccountId, uint32_t> statementOf;
+    // Resident row spans to read, in ledger order
+    vector<pair<size_t, size_t>> spans;
+    vector<const Transaction*> chunks;
+    {
+        shared_lock<shared_mutex> tableLock(accountsMutex);
+        StripeScan stripes(*this);
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        
+        statementOf.reserve(accounts.size());
+        for (size_t slot = 0; slot < accounts.size(); slot++) {
+            if (!accounts.isActive(slot)) continue;
+            string_view name = accounts.holderName(slot);
+            statementOf.emplace(accounts.id(slot), static_cast<uint32_t>(statements.size()));
+            statements.push_back({accounts.id(slot), accounts.type(slot), accounts.balance(slot),
+                                  names.size(), name.size()});
+            names += name;
+        }
+        
+        if (fromDate == 0 && toDate == 0) {
+            spans.push_back({transactions.firstResident(), transactions.size()});
+        } else {
+            for (const auto& partition : transactions.partitionsBetween(fromTime, toTime)) {
+                if (!spans.empty() && spans.back().second == partition.first) {
+                    spans.back().second = partition.end;
+                } else {
+                    spans.push_back({partition.first, partition.end});
+                }
+            }
+        }
+        chunks = chunkList(transactions);
     }
     
-    if ((currentBalance - amount) < MIN_BALANCE) {
-        cout << "│ ❌ Minimum balance ₹" << MIN_BALANCE << " required! │\n";
-        cout << "└──────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    const size_t CHUNK_MASK = LedgerStore::CHUNK_ROWS - 1;
+    auto residentRow = [&chunks, CHUNK_MASK](size_t i) -> const Transaction& {
+        return chunks[i >> LedgerStore::CHUNK_SHIFT][i & CHUNK_MASK];
+    };
+    auto statementOfRow = [&](const Transaction& trans) {
+        if (trans.timestamp < fromTime || trans.timestamp > toTime) return NO_STATEMENT;
+        auto it = statementOf.find(trans.accountId);
+        return (it == statementOf.end()) ? NO_STATEMENT : it->second;
+    };
+    
+    // Rows of statement i are rows[firstRow[i] .. firstRow[i + 1]); cold
+    // rows come first, as they are older than every resident row
+    vector<size_t> firstRow(statements.size() + 1, 0);
+    vector<Transaction> coldRows;
+    vector<uint32_t> coldStatement;
+    if (ledgerCache) {
+        shared_lock<shared_mutex> coldLock(coldMutex);
+        visitColdRows(fromTime, toTime, [&](const Transaction& trans) {
+            uint32_t statement = statementOfRow(trans);
+            if (statement == NO_STATEMENT) return;
+            coldRows.push_back(trans);
+            coldStatement.push_back(statement);
+            firstRow[statement + 1]++;
+        });
+    }
+    size_t spanRows = 0;
+    for (const auto& span : spans) {
+        spanRows += span.second - span.first;
+    }
+    vector<uint32_t> rowStatement;
+    rowStatement.reserve(spanRows);
+    for (const auto& span : spans) {
+        for (size_t i = span.first; i < span.second; i++) {
+            uint32_t statement = statementOfRow(residentRow(i));
+            rowStatement.push_back(statement);
+            if (statement != NO_STATEMENT) firstRow[statement + 1]++;
+        }
+    }
+    for (size_t i = 1; i < firstRow.size(); i++) {
+        firstRow[i] += firstRow[i - 1];
     }
     
-    double newBalance = currentBalance - amount;
-    accounts[index].setBalance(newBalance);
+    vector<Transaction> rows(firstRow.back());
+    vector<size_t> nextRow(firstRow.begin(), firstRow.end() - 1);
+    for (size_t i = 0; i < coldRows.size(); i++) {
+        rows[nextRow[coldStatement[i]]++] = coldRows[i];
+    }
+    coldRows = vector<Transaction>();
+    size_t position = 0;
+    for (const auto& span : spans) {
+        for (size_t i = span.first; i < span.second; i++, position++) {
+            if (rowStatement[position] != NO_STATEMENT) {
+                rows[nextRow[rowStatement[position]]++] = residentRow(i);
+            }
+        }
+    }
     
-    addTransaction(accountNo, "Withdrawal", amount, newBalance);
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    error_code ignored;
+    filesystem::create_directories(directory, ignored);
+    atomic<size_t> nextStatement(0);
+    atomic<bool> failed(false);
+    
+    auto writeStatements = [&]() {
+        string text;
+        string path = directory + "/statement_";
+        size_t prefixLength = path.size();
+        char accountNo[24];
+        for (;;) {
+            size_t first = nextStatement.fetch_add(STATEMENTS_PER_CLAIM);
+            if (first >= statements.size()) break;
+            size_t last = min(first + STATEMENTS_PER_CLAIM, statements.size());
+            for (size_t i = first; i < last; i++) {
+                const StatementAccount& statement = statements[i];
+                text.clear();
+                renderStatement(text, statement.id, string_view(names).substr(statement.nameOffset, statement.nameLength),
+                                accountTypeName(statement.type), statement.balance, generated, period,
+                                rows.data() + firstRow[i], firstRow[i + 1] - firstRow[i]);
+                path.resize(prefixLength);
+                path.append(accountNo, formatAccountId(statement.id, accountNo));
+                path += ".txt";
+                if (!writeTextFile(path, text)) failed = true;
+            }
+        }
+    };
     
-    cout << "│ ✅ Withdrawal successful!            │\n";
-    cout << "│ New Balance: ₹" << fixed << setprecision(2) << newBalance << "\n";
-    cout << "└──────────────────────────────────────┘\n";
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) {
+        workers.emplace_back(writeStatements);
+    }
+    writeStatements();
+    for (auto& worker : workers) {
+        worker.join();
+    }
     
-    pauseScreen();
+    summary.files = statements.size();
+    summary.rows = rows.size();
+    summary.threads = threads;
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return Result(failed ? ErrorCode::IoError : ErrorCode::Success);
 }
 
-void BankingSystem::checkBalance() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
+// Applies a settlement batch with the same rules as the single-operation
+// calls. The account table is held exclusively while the batch is applied
+// and its ledger rows go in, so no per-account locks are needed; the table
+// is released before the one log sync for the batch. If the log cannot
+// take or write the rows, every operation in the batch reports IoError.
+void BankingSystem::applyBatch(const vector<BatchOperation>& operations, vector<Result>& results) {
+    if (wal.failed()) {
+        results.assign(operations.size(), Result(ErrorCode::IoError));
         return;
     }
+    results.assign(operations.size(), Result());
+    vector<Transaction> rows;
+    rows.reserve(operations.size() * 2);
+    int64_t now = time(0);
+    
+    unique_lock<shared_mutex> tableLock(accountsMutex);
+    for (size_t i = 0; i < operations.size(); i++) {
+        const BatchOperation& op = operations[i];
+        Result& result = results[i];
+        
+        if (op.amount <= Money()) {
+            result.code = ErrorCode::InvalidAmount;
+            continue;
+        }
+        int slot = findSlot(op.accountId);
+        if (slot == -1) {
+            result.code = ErrorCode::AccountNotFound;
+            continue;
+        }
+        if (!accounts.isActive(slot)) {
+            result.code = ErrorCode::AccountInactive;
+            continue;
+        }
+        
+        Money balance = accounts.balance(slot);
+        if (op.type == BatchOperationType::Deposit) {
+            Money newBalance;
+            if (!Money::tryAdd(balance, op.amount, newBalance)) {
+                result.code = ErrorCode::AmountOverflow;
+                continue;
+            }
+            accounts.setBalance(slot, newBalance);
+            rows.push_back(makeTransaction(op.accountId, TransactionType::Deposit, op.amount, newBalance, now));
+        } else if (op.type == BatchOperationType::Withdraw) {
+            result.code = checkDebit(balance, op.amount);
+            if (!result.ok()) continue;
+            accounts.setBalance(slot, balance - op.amount);
+            rows.push_back(makeTransaction(op.accountId, TransactionType::Withdrawal, op.amount,
+                                           balance - op.amount, now));
+        } else {
+            int toSlot = findSlot(op.toAccount);
+            if (toSlot == -1) {
+                result.code = ErrorCode::AccountNotFound;
+                continue;
+            }
+            if (toSlot == slot) {
+                result.code = ErrorCode::SameAccount;
+                continue;
+            }
+            if (!accounts.isActive(toSlot)) {
+                result.code = ErrorCode::AccountInactive;
+                continue;
+            }
+            result.code = checkDebit(balance, op.amount);
+            if (!result.ok()) continue;
+            Money toBalance;
+            if (!Money::tryAdd(accounts.balance(toSlot), op.amount, toBalance)) {
+                result.code = ErrorCode::AmountOverflow;
+                continue;
+            }
+            accounts.setBalance(slot, balance - op.amount);
+            accounts.setBalance(toSlot, toBalance);
+            rows.push_back(makeTransaction(op.accountId, TransactionType::TransferOut, op.amount,
+                                           balance - op.amount, now, op.toAccount));
+            rows.push_back(makeTransaction(op.toAccount, TransactionType::TransferIn, op.amount,
+                                           toBalance, now, op.accountId));
+        }
+        result.balance = accounts.balance(slot);
+    }
     
-    int index = findAccountIndex(accountNo);
-    
-    cout << "\n┌─────────── BALANCE INQUIRY ───────────┐\n";
-    cout << "│ Account Number: " << accounts[index].getAccountNumber() << "\n";
-    cout << "│ Account Holder: " << accounts[index].getAccountHolderName() << "\n";
-    cout << "│ Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    cout << "│ Account Type: " << accounts[index].getAccountType() << "\n";
-    cout << "└────────────────────────────────────────┘\n";
-    
-    pauseScreen();
+    bool written = true;
+    {
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        for (const auto& row : rows) {
+            written = appendLedgerRow(row, true) && written;
+        }
+    }
+    tableLock.unlock();
+    logRefused = false;
+    if (!wal.sync() || !written) {
+        for (auto& result : results) {
+            if (result.ok()) result = Result(ErrorCode::IoError);
+        }
+    }
 }
 
-void BankingSystem::viewAccountDetails() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+// Copies one active account out under its lock
+Result BankingSystem::getAccountDetails(const string& accountNo, BankAccount& details) {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
+    details = accountAt(slot);
+    return Result(ErrorCode::Success, details.getBalance());
+}
+
+Result BankingSystem::postDeactivation(const string& accountNo) {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    int slot = findSlot(accountNo);
+    if (slot == -1) return Result(ErrorCode::AccountNotFound);
+    
+    lock_guard<mutex> lock(accountLock(slot));
+    if (!accounts.isActive(slot)) return Result(ErrorCode::AccountInactive);
+    
+    accounts.setActive(slot, false);
+    Transaction closing = makeTransaction(accounts.id(slot), TransactionType::AccountDeactivated, Money(),
+                                          accounts.balance(slot), time(0));
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    logRecord("D|" + formatAccountId(accounts.id(slot)));
+    appendLedgerRow(closing);
+    return Result(ErrorCode::Success, accounts.balance(slot));
+}
+
+Result BankingSystem::deactivate(const string& accountNo) {
+    LogCommit commit(wal);
+    return commit.run([&]() { return postDeactivation(accountNo); });
+}
+
+string BankingSystem::formatAccountRecord(const BankAccount& acc) {
+    char amount[32];
+    string record;
+    record.reserve(128);
+    record += acc.getAccountNumber();
+    record += '|';
+    record += acc.getAccountHolderName();
+    record += '|';
+    record += acc.getPassword();
+    record += '|';
+    record += acc.getBalance().format(amount);
+    record += '|';
+    record += acc.getAccountType();
+    record += '|';
+    record += acc.getCreationDate();
+    record += '|';
+    record += acc.getActiveStatus() ? '1' : '0';
+    return record;
+}
+
+// Field splitting for the pipe-delimited records, as views into the line;
+// a missing field reads as empty and an unparseable amount as zero, as
+// the stream reads did
+static string_view takeField(string_view line, size_t& pos) {
+    size_t end = line.find('|', pos);
+    if (end == string_view::npos) end = line.size();
+    string_view field = line.substr(pos, end - pos);
+    pos = (end < line.size()) ? end + 1 : end;
+    return field;
+}
+
+static Money takeAmount(string_view line, size_t& pos) {
+    string_view field = takeField(line, pos);
+    Money amount;
+    if (!Money::parse(field.data(), field.data() + field.size(), amount)) amount = Money();
+    return amount;
+}
+
+// One accounts.dat line; the text fields still point into the line
+struct AccountLine {
+    AccountId id;
+    AccountStore::ColdFields fields;
+    AccountType type;
+    Money balance;
+    bool active;
+};
+
+static AccountLine parseAccountLine(string_view line, string_view& accNo, string_view& type) {
+    size_t pos = 0;
+    AccountLine account;
+    accNo = takeField(line, pos);
+    account.id = parseAccountId(accNo);
+    account.fields.holderName = takeField(line, pos);
+    account.fields.password = takeField(line, pos);
+    account.balance = takeAmount(line, pos);
+    type = takeField(line, pos);
+    account.type = parseAccountType(type);
+    account.fields.creationDate = takeField(line, pos);
+    account.active = (pos < line.size() && line[pos] == '1');
+    return account;
+}
+
+BankAccount BankingSystem::parseAccountRecord(string_view line) {
+    string_view accNo;
+    string_view type;
+    AccountLine parsed = parseAccountLine(line, accNo, type);
+    
+    BankAccount acc(string(accNo), string(parsed.fields.holderName), string(parsed.fields.password),
+                    parsed.balance, string(type));
+    acc.setCreationDate(string(parsed.fields.creationDate));
+    acc.setActiveStatus(parsed.active);
+    return acc;
+}
+
+// Writes the record into buffer (TRANSACTION_RECORD_MAX bytes) without
+// allocating and returns its length. The date is written as epoch seconds,
+// and a cross-shard transfer's ID follows the balance.
+size_t BankingSystem::formatTransactionRecord(const Transaction& trans, char* buffer) {
+    char amount[32];
+    char* out = buffer;
+    out += formatAccountId(trans.accountId, out);
+    *out++ = '|';
+    out += writeDescription(trans, out);
+    *out++ = '|';
+    out = appendText(out, trans.amount.format(amount));
+    *out++ = '|';
+    out = to_chars(out, out + 24, trans.timestamp).ptr;
+    *out++ = '|';
+    out = appendText(out, trans.balanceAfter.format(amount));
+    if (trans.transferId != 0) {
+        *out++ = '|';
+        out = to_chars(out, out + 12, trans.transferId).ptr;
     }
-    
-    int index = findAccountIndex(accountNo);
-    
-    cout << "\n┌─────────── ACCOUNT DETAILS ───────────┐\n";
-    cout << "│ Account Number: " << accounts[index].getAccountNumber() << "\n";
-    cout << "│ Account Holder: " << accounts[index].getAccountHolderName() << "\n";
-    cout << "│ Account Type: " << accounts[index].getAccountType() << "\n";
-    cout << "│ Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    cout << "│ Account Created: " << accounts[index].getCreationDate() << "\n";
-    cout << "│ Status: " << (accounts[index].getActiveStatus() ? "Active" : "Inactive") << "\n";
-    cout << "└────────────────────────────────────────┘\n";
-    
-    pauseScreen();
+    return out - buffer;
 }
 
-void BankingSystem::transferMoney() {
-    clearScreen();
-    displayHeader();
-    
-    string fromAccount;
-    if (!authenticateUser(fromAccount)) {
-        pauseScreen();
-        return;
+string BankingSystem::formatTransactionRecord(const Transaction& trans) {
+    char record[TRANSACTION_RECORD_MAX];
+    return string(record, formatTransactionRecord(trans, record));
+}
+
+// Older files hold the ctime text; consecutive rows usually share it, so
+// the last conversion is remembered
+static int64_t legacyTimestamp(string_view date) {
+    thread_local string lastDate;
+    thread_local int64_t lastTime = -1;
+    if (date != lastDate) {
+        lastDate = date;
+        lastTime = BankingSystem::parseTransactionDate(lastDate);
     }
-    
-    string toAccount;
-    double amount;
-    
-    cout << "\n┌─────────── MONEY TRANSFER ───────────┐\n";
-    cout << "│ Transfer to Account Number: ";
-    cin >> toAccount;
-    
-    int fromIndex = findAccountIndex(fromAccount);
-    int toIndex = findAccountIndex(toAccount);
-    
-    if (toIndex == -1) {
-        cout << "│ ❌ Recipient account not found!      │\n";
-        cout << "└───────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    return lastTime;
+}
+
+static int64_t takeTimestamp(string_view line, size_t& pos) {
+    string_view field = takeField(line, pos);
+    int64_t timestamp = 0;
+    auto parsed = from_chars(field.data(), field.data() + field.size(), timestamp);
+    if (parsed.ec == errc() && parsed.ptr == field.data() + field.size()) return timestamp;
+    return legacyTimestamp(field);
+}
+
+Transaction BankingSystem::parseTransactionRecord(string_view line) {
+    size_t pos = 0;
+    Transaction trans;
+    trans.accountId = parseAccountId(takeField(line, pos));
+    parseTransactionType(takeField(line, pos), trans.type, trans.counterparty);
+    trans.amount = takeAmount(line, pos);
+    trans.timestamp = takeTimestamp(line, pos);
+    trans.balanceAfter = takeAmount(line, pos);
+    // Only rows of a cross-shard transfer have the sixth field
+    string_view transfer = takeField(line, pos);
+    trans.transferId = 0;
+    from_chars(transfer.data(), transfer.data() + transfer.size(), trans.transferId);
+    return trans;
+}
+
+// The text files are mapped and cut into one range per parser thread,
+// each ending just past a newline so no line straddles two. Ranges are
+// parsed into separate vectors and appended in file order, so the result
+// is the same as a single front-to-back read.
+static const size_t MIN_TEXT_BYTES_PER_THREAD = 1 << 20;
+
+static vector<pair<size_t, size_t>> splitAtLines(const char* text, size_t length, unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t parts = max<size_t>(1, min<size_t>(threads, length / MIN_TEXT_BYTES_PER_THREAD));
+    vector<pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+    for (size_t part = 1; part <= parts && begin < length; part++) {
+        size_t end = length * part / parts;
+        if (end < begin) end = begin;
+        const void* newline = memchr(text + end, '\n', length - end);
+        end = newline ? static_cast<const char*>(newline) - text + 1 : length;
+        ranges.push_back({begin, end});
+        begin = end;
     }
-    
-    if (fromAccount == toAccount) {
-        cout << "│ ❌ Cannot transfer to same account!  │\n";
-        cout << "└───────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    return ranges;
+}
+
+// Runs parse(part, begin, end) for each range, the last on this thread
+template <typename Parse>
+static void parseRanges(const vector<pair<size_t, size_t>>& ranges, Parse parse) {
+    vector<thread> workers;
+    for (size_t part = 0; part + 1 < ranges.size(); part++) {
+        workers.emplace_back(parse, part, ranges[part].first, ranges[part].second);
+    }
+    if (!ranges.empty()) parse(ranges.size() - 1, ranges.back().first, ranges.back().second);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Calls visit with each non-empty line of [begin, end), without the newline
+template <typename Visit>
+static void forEachLine(const char* text, size_t begin, size_t end, Visit visit) {
+    while (begin < end) {
+        const void* newline = memchr(text + begin, '\n', end - begin);
+        size_t lineEnd = newline ? static_cast<const char*>(newline) - text : end;
+        if (lineEnd > begin) visit(string_view(text + begin, lineEnd - begin));
+        begin = lineEnd + 1;
+    }
+}
+
+void BankingSystem::loadAccountsFromFile() {
+    MetricTimer timer(Metric::LoadAccounts);
+    MappedFile file;
+    if (!file.open(ACCOUNTS_FILE)) return;
+    
+    auto ranges = splitAtLines(file.begin(), file.size(), loadThreads);
+    vector<vector<AccountLine>> parsed(ranges.size());
+    parseRanges(ranges, [&](size_t part, size_t begin, size_t end) {
+        string_view accNo;
+        string_view type;
+        forEachLine(file.begin(), begin, end, [&](string_view line) {
+            parsed[part].push_back(parseAccountLine(line, accNo, type));
+        });
+    });
+    
+    size_t count = 0;
+    size_t textBytes = 0;
+    for (const auto& lines : parsed) {
+        count += lines.size();
+        for (const auto& account : lines) {
+            textBytes += account.fields.holderName.size() + account.fields.password.size() +
+                         account.fields.creationDate.size();
+        }
     }
+    accounts.reserve(accounts.size() + count, textBytes);
+    for (const auto& lines : parsed) {
+        for (const auto& account : lines) {
+            nextAccountSerial = max(nextAccountSerial, accountSerial(account.id) + 1);
+            accounts.add(account.id, account.fields, account.type, account.balance, account.active);
+        }
+    }
+    startup.threads = static_cast<unsigned>(ranges.size());
     
-    cout << "│ Transfer Amount: ₹";
-    cin >> amount;
+    rebuildAccountIndex();
+}
+
+// Written to a temporary file and renamed so a crash never leaves a
+// half-written account table behind
+bool BankingSystem::saveAccountsToFile() {
+    MetricTimer timer(Metric::SaveAccounts);
+    string tempFile = ACCOUNTS_FILE + ".tmp";
+    ofstream file(tempFile);
+    if (!file) return false;
     
-    if (amount <= 0) {
-        cout << "│ ❌ Invalid amount!                   │\n";
-        cout << "└───────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    for (size_t i = 0; i < accounts.size(); i++) {
+        file << formatAccountRecord(accountAt(i)) << "\n";
     }
+    file.close();
     
-    double fromBalance = accounts[fromIndex].getBalance();
-    if (amount > fromBalance || (fromBalance - amount) < MIN_BALANCE) {
-        cout << "│ ❌ Insufficient balance!             │\n";
-        cout << "└───────────────────────────────────────┘\n";
-        pauseScreen();
-        return;
+    return file && rename(tempFile.c_str(), ACCOUNTS_FILE.c_str()) == 0;
+}
+
+void BankingSystem::loadTransactionsFromFile() {
+    MetricTimer timer(Metric::LoadLedger);
+    MappedFile file;
+    if (!file.open(TRANSACTIONS_FILE)) return;
+    
+    // A final row with no newline is torn from an interrupted append
+    size_t length = file.size();
+    while (length > 0 && file.begin()[length - 1] != '\n') length--;
+    
+    auto ranges = splitAtLines(file.begin(), length, loadThreads);
+    vector<vector<Transaction>> parsed(ranges.size());
+    parseRanges(ranges, [&](size_t part, size_t begin, size_t end) {
+        forEachLine(file.begin(), begin, end, [&](string_view line) {
+            parsed[part].push_back(parseTransactionRecord(line));
+        });
+    });
+    for (auto& rows : parsed) {
+        for (const auto& trans : rows) {
+            transactions.push_back(trans);
+        }
+        vector<Transaction>().swap(rows);
     }
+    startup.threads = max(startup.threads, static_cast<unsigned>(ranges.size()));
     
-    // Perform transfer
-    accounts[fromIndex].setBalance(fromBalance - amount);
-    accounts[toIndex].setBalance(accounts[toIndex].getBalance() + amount);
+    rebuildTransactionIndex();
+}
+
+void BankingSystem::saveTransactionsToFile() {
+    MetricTimer timer(Metric::SaveLedger);
+    ofstream file(TRANSACTIONS_FILE);
+    if (!file) return;
     
-    // Record transactions
-    addTransaction(fromAccount, "Transfer Out to " + toAccount, amount, accounts[fromIndex].getBalance());
-    addTransaction(toAccount, "Transfer In from " + fromAccount, amount, accounts[toIndex].getBalance());
+    if (ledgerCache) {
+        shared_lock<shared_mutex> coldLock(coldMutex);
+        visitColdRows(INT64_MIN, INT64_MAX, [&file](const Transaction& trans) {
+            file << formatTransactionRecord(trans) << "\n";
+        });
+    }
+    for (size_t i = transactions.firstResident(); i < transactions.size(); i++) {
+        file << formatTransactionRecord(transactions[i]) << "\n";
+    }
+    file.close();
+}
+
+// Version 1 data files held amounts as double rupees in the same field
+static Money recordAmount(int64_t field, uint32_t version) {
+    if (version >= 2) return Money::fromPaise(field);
+    double rupees;
+    memcpy(&rupees, &field, sizeof(rupees));
+    return Money::fromPaise(llround(rupees * 100.0));
+}
+
+// Versions before 3 held the account number as a string in the same field
+static AccountId recordAccountId(const DataFileReader::Block& block, uint64_t field, uint32_t version) {
+    if (version >= 3) return field;
+    StringRef ref;
+    memcpy(&ref, &field, sizeof(ref));
+    return parseAccountId(DataFileReader::getView(block, ref));
+}
+
+// Binary records are used in place from the mapped file; the only per-row
+// work is copying strings out of the block's heap. In lazy mode the file
+// stays mapped and the cold text is not copied at all, as long as each
+// record's name, password and creation date lie end to end.
+bool BankingSystem::loadAccountsFromBinaryFile() {
+    MetricTimer timer(Metric::LoadAccounts);
+    DataFileReader loadReader;
+    DataFileReader& reader = ledgerCacheBytes ? mappedAccounts : loadReader;
+    if (!reader.open(ACCOUNTS_BINARY_FILE, "RCBANKA")) return false;
+    if (reader.recordSize() != sizeof(AccountRecord)) {
+        throw runtime_error("Unsupported data file version: " + ACCOUNTS_BINARY_FILE);
+    }
     
-    cout << "│ ✅ Transfer successful!              │\n";
-    cout << "│ Transferred ₹" << fixed << setprecision(2) << amount << " to " << toAccount << "\n";
-    cout << "│ Your new balance: ₹" << accounts[fromIndex].getBalance() << "\n";
-    cout << "└───────────────────────────────────────┘\n";
+    bool mapped = ledgerCacheBytes && reader.version() >= 3;
+    size_t textBytes = 0;
+    for (const auto& block : reader.blocks()) {
+        textBytes += block.heapSize;
+    }
+    accounts.reserve(accounts.size() + reader.recordCount(), mapped ? 0 : textBytes);
+    if (mapped) accounts.setMappedText(reader.data());
+    for (const auto& block : reader.blocks()) {
+        const AccountRecord* records = reinterpret_cast<const AccountRecord*>(block.records);
+        for (size_t i = 0; i < block.count; i++) {
+            const AccountRecord& rec = records[i];
+            AccountStore::ColdFields fields;
+            fields.holderName = DataFileReader::getView(block, rec.holderName);
+            fields.password = DataFileReader::getView(block, rec.password);
+            fields.creationDate = DataFileReader::getView(block, rec.creationDate);
+            AccountId id = recordAccountId(block, rec.accountId, reader.version());
+            nextAccountSerial = max(nextAccountSerial, accountSerial(id) + 1);
+            AccountType type = parseAccountType(DataFileReader::getView(block, rec.accountType));
+            Money balance = recordAmount(rec.balance, reader.version());
+            if (mapped && fields.password.data() == fields.holderName.data() + fields.holderName.size() &&
+                fields.creationDate.data() == fields.password.data() + fields.password.size()) {
+                accounts.addMapped(id, fields, type, balance, rec.active != 0);
+            } else {
+                accounts.add(id, fields, type, balance, rec.active != 0);
+            }
+        }
+    }
     
-    pauseScreen();
+    rebuildAccountIndex();
+    return true;
 }
 
-void BankingSystem::viewTransactionHistory() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+// Rewritten as a single block in a temporary file, then renamed into place
+bool BankingSystem::saveAccountsToBinaryFile(const AccountStore& table) {
+    MetricTimer timer(Metric::SaveAccounts);
+    DataBlockWriter block;
+    block.reserve(table.size(), sizeof(AccountRecord), table.size() * 64);
+    for (size_t i = 0; i < table.size(); i++) {
+        AccountRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.accountId = table.id(i);
+        // The cold fields end to end, so a lazy load can use them in place
+        rec.holderName = block.addString(table.holderName(i));
+        rec.password = block.addString(table.password(i));
+        rec.creationDate = block.addString(table.creationDate(i));
+        rec.accountType = block.addString(accountTypeName(table.type(i)));
+        rec.balance = table.balance(i).toPaise();
+        rec.active = table.isActive(i);
+        block.addRecord(&rec, sizeof(rec));
     }
     
-    cout << "\n┌─────────── TRANSACTION HISTORY ───────────┐\n";
-    cout << "│ Account: " << accountNo << "\n";
-    cout << "├────────────────────────────────────────────┤\n";
+    string tempFile = ACCOUNTS_BINARY_FILE + ".tmp";
+    FILE* file = fopen(tempFile.c_str(), "wb");
+    if (!file) return false;
+    bool written = block.writeTo(file, "RCBANKA", sizeof(AccountRecord)) && syncFile(file);
+    fclose(file);
     
-    bool hasTransactions = false;
-    for (const auto& trans : transactions) {
-        if (trans.accountNo == accountNo) {
-            hasTransactions = true;
-            cout << "│ " << trans.date << "\n";
-            cout << "│ Type: " << trans.type << "\n";
-            cout << "│ Amount: ₹" << fixed << setprecision(2) << trans.amount << "\n";
-            cout << "│ Balance After: ₹" << trans.balanceAfter << "\n";
-            cout << "├────────────────────────────────────────────┤\n";
+    return written && rename(tempFile.c_str(), ACCOUNTS_BINARY_FILE.c_str()) == 0;
+}
+
+// Copy of the account table for a checkpoint. The shared table lock only
+// holds off new accounts; balances and status are copied one lock stripe
+// at a time, so an operation waits for at most one stripe's copy.
+AccountStore BankingSystem::snapshotAccounts() const {
+    AccountStore snapshot;
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    snapshot.reserve(accounts.size(), accounts.textBytes());
+    for (size_t slot = 0; slot < accounts.size(); slot++) {
+        AccountStore::ColdFields fields;
+        fields.holderName = accounts.holderName(slot);
+        fields.password = accounts.password(slot);
+        fields.creationDate = accounts.creationDate(slot);
+        snapshot.add(accounts.id(slot), fields, accounts.type(slot), Money(), false);
+    }
+    for (size_t stripe = 0; stripe < ACCOUNT_LOCK_STRIPES; stripe++) {
+        lock_guard<mutex> lock(accountLocks[stripe].lock);
+        for (size_t slot = stripe; slot < accounts.size(); slot += ACCOUNT_LOCK_STRIPES) {
+            snapshot.setBalance(slot, accounts.balance(slot));
+            snapshot.setActive(slot, accounts.isActive(slot));
         }
     }
-    
-    if (!hasTransactions) {
-        cout << "│ No transactions found.                     │\n";
+    return snapshot;
+}
+
+// Rows written before version 4 carry their type and date as strings
+static void loadLegacyTransactionBlock(const DataFileReader::Block& block, uint32_t version,
+                                       size_t first, size_t end, LedgerStore& into) {
+    const LegacyTransactionRecord* records = reinterpret_cast<const LegacyTransactionRecord*>(block.records);
+    for (size_t i = first; i < end; i++) {
+        const LegacyTransactionRecord& rec = records[i];
+        Transaction trans;
+        trans.accountId = recordAccountId(block, rec.accountId, version);
+        BankingSystem::parseTransactionType(DataFileReader::getView(block, rec.type), trans.type, trans.counterparty);
+        trans.timestamp = legacyTimestamp(DataFileReader::getString(block, rec.date));
+        trans.amount = recordAmount(rec.amount, version);
+        trans.balanceAfter = recordAmount(rec.balanceAfter, version);
+        trans.transferId = 0;
+        into.push_back(trans);
     }
-    
-    cout << "└────────────────────────────────────────────┘\n";
-    pauseScreen();
 }
 
-void BankingSystem::generateAccountStatement() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+// Appends rows [skip, end) of one ledger file to into; end past the last
+// row reads to the end of the file
+static void loadLedgerFile(const string& path, size_t skip, size_t end, LedgerStore& into) {
+    DataFileReader reader;
+    if (!reader.open(path, "RCBANKT")) {
+        throw runtime_error("Missing ledger file: " + path);
     }
-    
-    int index = findAccountIndex(accountNo);
-    string filename = "statement_" + accountNo + ".txt";
-    
-    ofstream file(filename);
-    if (!file) {
-        cout << "❌ Error creating statement file!\n";
-        pauseScreen();
-        return;
+    bool legacy = reader.version() < 4;
+    if (reader.recordSize() != (legacy ? sizeof(LegacyTransactionRecord) : sizeof(TransactionRecord))) {
+        throw runtime_error("Unsupported data file version: " + path);
     }
     
-    file << "RIDDHI'S BANKING SYSTEM - ACCOUNT STATEMENT\n";
-    file << "==========================================\n\n";
-    file << "Account Number: " << accounts[index].getAccountNumber() << "\n";
-    file << "Account Holder: " << accounts[index].getAccountHolderName() << "\n";
-    file << "Account Type: " << accounts[index].getAccountType() << "\n";
-    file << "Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    file << "Statement Generated: " << accounts[index].getCurrentDate() << "\n\n";
-    file << "TRANSACTION HISTORY:\n";
-    file << "-------------------\n";
-    
-    for (const auto& trans : transactions) {
-        if (trans.accountNo == accountNo) {
-            file << trans.date << " | " << trans.type << " | ₹" << trans.amount 
-                 << " | Balance: ₹" << trans.balanceAfter << "\n";
+    end = min(end, reader.recordCount());
+    into.reserve(into.size() + end - min(skip, end));
+    size_t blockStart = 0;
+    for (const auto& block : reader.blocks()) {
+        size_t first = min(skip, blockStart + block.count) - min(skip, blockStart);
+        size_t last = min(end, blockStart + block.count) - min(end, blockStart);
+        blockStart += block.count;
+        if (legacy) {
+            loadLegacyTransactionBlock(block, reader.version(), first, last, into);
+            continue;
+        }
+        const TransactionRecord* records = reinterpret_cast<const TransactionRecord*>(block.records);
+        for (size_t i = first; i < last; i++) {
+            const TransactionRecord& rec = records[i];
+            Transaction trans;
+            trans.accountId = rec.accountId;
+            trans.counterparty = rec.counterparty;
+            trans.timestamp = rec.timestamp;
+            trans.amount = Money::fromPaise(rec.amount);
+            trans.balanceAfter = Money::fromPaise(rec.balanceAfter);
+            trans.type = static_cast<TransactionType>(rec.type);
+            trans.transferId = rec.transferId;
+            into.push_back(trans);
         }
     }
-    
-    file.close();
-    
-    cout << "\n✅ Account statement generated successfully!\n";
-    cout << "File saved as: " << filename << "\n";
-    pauseScreen();
 }
 
-void BankingSystem::deactivateAccount() {
-    clearScreen();
-    displayHeader();
-    
-    string accountNo;
-    if (!authenticateUser(accountNo)) {
-        pauseScreen();
-        return;
+// Segment names carry the rows they hold: ledger_<first>_<end>.bin
+static bool parseSegmentName(const string& name, const string& prefix, size_t& first, size_t& end) {
+    const char* p = name.data() + prefix.size();
+    const char* last = name.data() + name.size();
+    if (name.compare(0, prefix.size(), prefix) != 0) return false;
+    auto parsed = from_chars(p, last, first);
+    if (parsed.ec != errc() || parsed.ptr == last || *parsed.ptr != '_') return false;
+    parsed = from_chars(parsed.ptr + 1, last, end);
+    return parsed.ec == errc() && string_view(parsed.ptr, last - parsed.ptr) == ".bin" && first < end;
+}
+
+// The ledger on disk is a run of sealed segment files. Files that an
+// interrupted compaction left behind lie inside the merged file that
+// replaced them and are deleted here. Before the first segmented checkpoint
+// the whole ledger is the single TRANSACTIONS_BINARY_FILE.
+bool BankingSystem::loadTransactionsFromBinaryFile() {
+    MetricTimer timer(Metric::LoadLedger);
+    vector<LedgerSegment> segments;
+    error_code error;
+    for (const auto& entry : filesystem::directory_iterator(dataPath("."), error)) {
+        LedgerSegment segment;
+        string name = entry.path().filename().string();
+        if (parseSegmentName(name, LEDGER_SEGMENT_PREFIX, segment.first, segment.end)) {
+            segment.path = dataPath(name);
+            segments.push_back(segment);
+        }
     }
     
-    int index = findAccountIndex(accountNo);
-    
-    cout << "\n┌─────────── DEACTIVATE ACCOUNT ───────────┐\n";
-    cout << "│ ⚠️  WARNING: This action is irreversible! │\n";
-    cout << "│ Current Balance: ₹" << fixed << setprecision(2) << accounts[index].getBalance() << "\n";
-    cout << "│ Confirm deactivation (Y/N): ";
-    
-    char confirm;
-    cin >> confirm;
-    
-    if (confirm == 'Y' || confirm == 'y') {
-        accounts[index].setActiveStatus(false);
-        addTransaction(accountNo, "Account Deactivated", 0, accounts[index].getBalance());
-        
-        cout << "│ ✅ Account deactivated successfully!     │\n";
-        cout << "│ Please visit branch for balance refund.  │\n";
-    } else {
-        cout << "│ ❌ Deactivation cancelled.               │\n";
+    if (segments.empty()) {
+        if (!filesystem::exists(TRANSACTIONS_BINARY_FILE, error)) return false;
+        loadLedgerFile(TRANSACTIONS_BINARY_FILE, 0, SIZE_MAX, transactions);
+        // Rewritten as the first segment at the next checkpoint
+        legacyLedgerFile = true;
+        checkpointedTransactions = 0;
+        rebuildTransactionIndex();
+        return true;
     }
     
-    cout << "└───────────────────────────────────────────┘\n";
-    pauseScreen();
+    sort(segments.begin(), segments.end(), [](const LedgerSegment& a, const LedgerSegment& b) {
+        return a.first != b.first ? a.first < b.first : a.end > b.end;
+    });
+    ledgerSegments.clear();
+    size_t rows = 0;
+    for (const auto& segment : segments) {
+        if (segment.end <= rows) {
+            remove(segment.path.c_str());
+            continue;
+        }
+        if (segment.first > rows) {
+            throw runtime_error("Ledger rows missing before " + segment.path);
+        }
+        if (!ledgerCacheBytes) {
+            loadLedgerFile(segment.path, rows - segment.first, SIZE_MAX, transactions);
+        }
+        rows = segment.end;
+        ledgerSegments.push_back(segment);
+    }
+    // Lazy mode: only rows logged after the last checkpoint are resident
+    if (ledgerCacheBytes) {
+        transactions.startAt(rows);
+        ledgerCache.reset(new LedgerCache(ledgerCacheBytes, [](const string& path, size_t first, size_t end,
+                                                               LedgerStore& into) {
+            loadLedgerFile(path, first, end, into);
+        }));
+        refreshColdSegments();
+    }
+    remove(TRANSACTIONS_BINARY_FILE.c_str());
+    checkpointedTransactions = transactions.size();
+    rebuildTransactionIndex();
+    return true;
 }
 
-void BankingSystem::loadAccountsFromFile() {
-    ifstream file(ACCOUNTS_FILE);
-    if (!file) return;
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
+static void addLedgerRecord(DataBlockWriter& block, const Transaction& trans) {
+    TransactionRecord rec;
+    rec.accountId = trans.accountId;
+    rec.counterparty = trans.counterparty;
+    rec.timestamp = trans.timestamp;
+    rec.amount = trans.amount.toPaise();
+    rec.balanceAfter = trans.balanceAfter.toPaise();
+    rec.type = static_cast<uint32_t>(trans.type);
+    rec.transferId = trans.transferId;
+    block.addRecord(&rec, sizeof(rec));
+}
+
+string BankingSystem::ledgerSegmentPath(size_t first, size_t end) const {
+    char name[64];
+    snprintf(name, sizeof(name), "%012zu_%012zu.bin", first, end);
+    return dataPath(LEDGER_SEGMENT_PREFIX + name);
+}
+
+// Written under a temporary name and renamed, so a file with a segment
+// name is always complete; it is never modified after that
+bool BankingSystem::writeLedgerSegment(const DataBlockWriter& block, size_t first, size_t end) {
+    MetricTimer timer(Metric::SaveLedger);
+    string path = ledgerSegmentPath(first, end);
+    string tempFile = path + ".tmp";
+    FILE* file = fopen(tempFile.c_str(), "wb");
+    if (!file) return false;
+    bool written = block.writeTo(file, "RCBANKT", sizeof(TransactionRecord)) && syncFile(file);
+    fclose(file);
+    
+    return written && rename(tempFile.c_str(), path.c_str()) == 0;
+}
+
+// Re-applies logged changes on top of the checkpoint. Replay is idempotent:
+// accounts that already exist are kept, and each ledger row carries its
+// position so rows already in the ledger files are skipped. Logs sealed by
+// a checkpoint that did not finish come first, oldest first; they are
+// deleted by the next checkpoint.
+void BankingSystem::replayWriteAheadLog() {
+    MetricTimer timer(Metric::ReplayLog);
+    vector<pair<uint64_t, string>> logs;
+    string prefix = filesystem::path(WAL_FILE).filename().string() + ".";
+    error_code error;
+    for (const auto& entry : filesystem::directory_iterator(dataPath("."), error)) {
+        string name = entry.path().filename().string();
+        uint64_t generation = 0;
+        const char* last = name.data() + name.size();
+        if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            from_chars(name.data() + prefix.size(), last, generation).ptr == last) {
+            logs.emplace_back(generation, dataPath(name));
+        }
+    }
+    sort(logs.begin(), logs.end());
+    for (const auto& log : logs) {
+        sealedLogs.push_back(log.second);
+        nextLogGeneration = max(nextLogGeneration, log.first + 1);
+    }
+    // A damaged record ends the valid log, later files included
+    for (const auto& log : logs) {
+        if (!replayLogFile(log.second)) return;
+    }
+    replayLogFile(WAL_FILE);
+}
+
+// Rows logged by a multi-leg transfer follow its group record; they are
+// held back until the whole group has been read, and dropped if the log
+// ends first. Replay stops at a record that fails its checksum or cannot
+// be parsed, and returns false.
+bool BankingSystem::replayLogFile(const string& path) {
+    vector<string> groupRows;
+    size_t groupSize = 0;
+    string groupKey;
+    IdempotentResult groupResult{0, 0, Money()};
+    auto applyRow = [this](const string& payload) {
+        size_t separator = payload.find('|');
+        if (separator == string::npos) return false;
+        size_t seq = 0;
+        auto parsed = from_chars(payload.data(), payload.data() + separator, seq);
+        if (parsed.ec != errc() || parsed.ptr != payload.data() + separator) return false;
+        if (seq < transactions.size()) return true;
         
-        stringstream ss(line);
-        string accNo, name, pass, type, date;
-        double balance;
-        bool active;
+        Transaction trans = parseTransactionRecord(string_view(payload).substr(separator + 1));
+        auto it = accountIndex.find(trans.accountId);
+        if (it != accountIndex.end()) {
+            accounts.setBalance(it->second, trans.balanceAfter);
+        }
+        transactionIndex[trans.accountId].push_back(transactions.size());
+        transactions.push_back(trans);
+        return true;
+    };
+    
+    bool complete;
+    for (const string& record : WriteAheadLog::readRecords(path, complete)) {
+        if (record.size() < 2 || record[1] != '|') continue;
+        string payload = record.substr(2);
         
-        getline(ss, accNo, '|');
-        getline(ss, name, '|');
-        getline(ss, pass, '|');
-        ss >> balance;
-        ss.ignore();
-        getline(ss, type, '|');
-        getline(ss, date, '|');
-        ss >> active;
+        if (groupSize > 0) {
+            // Nothing else is logged inside a group
+            if (record[0] != 'T') {
+                groupRows.clear();
+                groupSize = 0;
+            } else {
+                groupRows.push_back(payload);
+                if (groupRows.size() < groupSize) continue;
+                for (const string& row : groupRows) {
+                    if (!applyRow(row)) {
+                        damagedLog = true;
+                        return false;
+                    }
+                }
+                if (!groupKey.empty()) rememberIdempotencyKey(groupKey, groupResult);
+                groupRows.clear();
+                groupSize = 0;
+                continue;
+            }
+        }
         
-        BankAccount acc(accNo, name, pass, balance, type);
-        acc.setCreationDate(date);
-        acc.setActiveStatus(active);
-        accounts.push_back(acc);
+        if (record[0] == 'A') {
+            BankAccount acc = parseAccountRecord(payload);
+            if (accountIndex.find(parseAccountId(acc.getAccountNumber())) == accountIndex.end()) {
+                indexAccount(addAccount(acc));
+            }
+        } else if (record[0] == 'D') {
+            auto it = accountIndex.find(parseAccountId(payload));
+            if (it != accountIndex.end()) {
+                accounts.setActive(it->second, false);
+            }
+        } else if (record[0] == 'P') {
+            size_t separator = payload.find('|');
+            if (separator == string::npos) continue;
+            auto it = accountIndex.find(parseAccountId(payload.substr(0, separator)));
+            if (it != accountIndex.end()) {
+                accounts.setPassword(it->second, payload.substr(separator + 1));
+            }
+        } else if (record[0] == 'T') {
+            if (!applyRow(payload)) {
+                damagedLog = true;
+                return false;
+            }
+        } else if (record[0] == 'G') {
+            // G|rows|created|balance|fingerprint|key
+            size_t pos = 0;
+            int64_t paise = 0;
+            string_view field = takeField(payload, pos);
+            from_chars(field.data(), field.data() + field.size(), groupSize);
+            field = takeField(payload, pos);
+            from_chars(field.data(), field.data() + field.size(), groupResult.created);
+            field = takeField(payload, pos);
+            from_chars(field.data(), field.data() + field.size(), paise);
+            groupResult.balance = Money::fromPaise(paise);
+            field = takeField(payload, pos);
+            from_chars(field.data(), field.data() + field.size(), groupResult.fingerprint);
+            groupKey = payload.substr(pos);
+        }
     }
-    file.close();
+    if (groupSize > 0) tornLogGroup = true;
+    if (!complete) damagedLog = true;
+    return complete;
 }
 
-void BankingSystem::saveAccountsToFile() {
-    ofstream file(ACCOUNTS_FILE);
-    if (!file) return;
-    
-    for (const auto& acc : accounts) {
-        file << acc.getAccountNumber() << "|"
-             << acc.getAccountHolderName() << "|"
-             << acc.getPassword() << "|"
-             << acc.getBalance() << "|"
-             << acc.getAccountType() << "|"
-             << acc.getCreationDate() << "|"
-             << acc.getActiveStatus() << "\n";
+// Caller holds ledgerMutex, or is the constructor
+void BankingSystem::rememberIdempotencyKey(const string& key, const IdempotentResult& result) {
+    if (result.created + IDEMPOTENCY_TTL_SECONDS < time(0)) return;
+    lock_guard<mutex> keyLock(idempotencyMutex);
+    idempotencyKeys[key] = result;
+}
+
+// Caller holds ledgerMutex, so the copy matches the log being sealed.
+// Expired keys are dropped here.
+vector<pair<string, BankingSystem::IdempotentResult>> BankingSystem::snapshotIdempotencyKeys(int64_t now) {
+    lock_guard<mutex> keyLock(idempotencyMutex);
+    vector<pair<string, IdempotentResult>> keys;
+    keys.reserve(idempotencyKeys.size());
+    for (auto it = idempotencyKeys.begin(); it != idempotencyKeys.end();) {
+        if (it->second.created + IDEMPOTENCY_TTL_SECONDS < now) {
+            it = idempotencyKeys.erase(it);
+        } else {
+            keys.emplace_back(it->first, it->second);
+            ++it;
+        }
+    }
+    return keys;
+}
+
+// One created|fingerprint|balance|key line per key, replaced through a
+// temporary file like accounts.dat
+bool BankingSystem::saveIdempotencyKeys(const vector<pair<string, IdempotentResult>>& keys) {
+    string tempFile = IDEMPOTENCY_FILE + ".tmp";
+    ofstream file(tempFile);
+    if (!file) return false;
+    
+    for (const auto& key : keys) {
+        file << key.second.created << '|' << key.second.fingerprint << '|' << key.second.balance.toPaise()
+             << '|' << key.first << '\n';
     }
     file.close();
+    
+    return file && rename(tempFile.c_str(), IDEMPOTENCY_FILE.c_str()) == 0;
 }
 
-void BankingSystem::loadTransactionsFromFile() {
-    ifstream file(TRANSACTIONS_FILE);
+void BankingSystem::loadIdempotencyKeys() {
+    ifstream file(IDEMPOTENCY_FILE);
     if (!file) return;
     
     string line;
     while (getline(file, line)) {
-        if (line.empty()) continue;
-        
-        stringstream ss(line);
-        Transaction trans;
-        
-        getline(ss, trans.accountNo, '|');
-        getline(ss, trans.type, '|');
-        ss >> trans.amount;
-        ss.ignore();
-        getline(ss, trans.date, '|');
-        ss >> trans.balanceAfter;
+        size_t pos = 0;
+        IdempotentResult result{0, 0, Money()};
+        int64_t paise = 0;
+        string_view field = takeField(line, pos);
+        from_chars(field.data(), field.data() + field.size(), result.created);
+        field = takeField(line, pos);
+        from_chars(field.data(), field.data() + field.size(), result.fingerprint);
+        field = takeField(line, pos);
+        from_chars(field.data(), field.data() + field.size(), paise);
+        result.balance = Money::fromPaise(paise);
+        if (pos < line.size()) rememberIdempotencyKey(line.substr(pos), result);
+    }
+}
+
+// Fuzzy checkpoint. The log is sealed under the ledger lock along with a
+// copy of the ledger rows it covers; the account table is then copied one
+// stripe at a time and the files are written with no table or ledger lock
+// held, so operations keep running. Changes made after the log was sealed
+// may or may not be in the copy. Each was appended to the new log before
+// its stripe was unlocked, but may still be waiting in the log's ring
+// buffer, so the log is synced before accounts.bin is written: the file
+// never holds a balance whose record is not on disk. Replaying them is
+// idempotent. Accounts are written before the ledger segment, so a crash
+// part way through replays to the same state.
+bool BankingSystem::checkpoint() {
+    MetricTimer timer(Metric::Checkpoint);
+    lock_guard<mutex> checkpointLock(checkpointMutex);
+    vector<DataBlockWriter> blocks;
+    vector<pair<string, IdempotentResult>> keys;
+    size_t first = checkpointedTransactions;
+    size_t end;
+    {
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        string sealedLog = WAL_FILE + "." + to_string(nextLogGeneration);
+        if (!wal.rotate(sealedLog)) return false;
+        nextLogGeneration++;
+        sealedLogs.push_back(sealedLog);
         
-        transactions.push_back(trans);
+        keys = snapshotIdempotencyKeys(time(0));
+        end = transactions.size();
+        for (size_t i = first; i < end; i++) {
+            if ((i - first) % COMPACTED_SEGMENT_ROWS == 0) {
+                blocks.emplace_back();
+                blocks.back().reserve(min(end - i, COMPACTED_SEGMENT_ROWS), sizeof(TransactionRecord), 0);
+            }
+            addLedgerRecord(blocks.back(), transactions[i]);
+        }
     }
-    file.close();
+    
+    AccountStore snapshot = snapshotAccounts();
+    if (!wal.sync() || !saveAccountsToBinaryFile(snapshot)) return false;
+    size_t written = first;
+    for (const auto& block : blocks) {
+        size_t segmentEnd = written + block.recordCount();
+        if (!writeLedgerSegment(block, written, segmentEnd)) return false;
+        ledgerSegments.push_back({ledgerSegmentPath(written, segmentEnd), written, segmentEnd});
+        written = segmentEnd;
+    }
+    checkpointedTransactions = end;
+    if (legacyLedgerFile) {
+        remove(TRANSACTIONS_BINARY_FILE.c_str());
+        legacyLedgerFile = false;
+    }
+    if (!saveIdempotencyKeys(keys)) return false;
+    for (const string& log : sealedLogs) {
+        remove(log.c_str());
+    }
+    sealedLogs.clear();
+    return true;
 }
 
-void BankingSystem::saveTransactionsToFile() {
-    ofstream file(TRANSACTIONS_FILE);
-    if (!file) return;
+// Background compaction: once more than LEDGER_SEGMENT_LIMIT small
+// segments have built up at the end of the ledger, they are merged into
+// sealed files of up to COMPACTED_SEGMENT_ROWS rows. Segments are
+// immutable, so they are read with no table or ledger lock held; the
+// merged files are in place before the segments they replace are deleted.
+bool BankingSystem::compactLedger() {
+    MetricTimer timer(Metric::Compaction);
+    lock_guard<mutex> checkpointLock(checkpointMutex);
+    size_t mergeFrom = ledgerSegments.size();
+    while (mergeFrom > 0 &&
+           ledgerSegments[mergeFrom - 1].end - ledgerSegments[mergeFrom - 1].first < COMPACTED_SEGMENT_ROWS) {
+        mergeFrom--;
+    }
+    if (ledgerSegments.size() - mergeFrom <= LEDGER_SEGMENT_LIMIT) return true;
+    
+    size_t first = ledgerSegments[mergeFrom].first;
+    size_t end = ledgerSegments.back().end;
+    vector<DataBlockWriter> blocks;
+    size_t rows = 0;
+    for (size_t i = mergeFrom; i < ledgerSegments.size(); i++) {
+        DataFileReader reader;
+        if (!reader.open(ledgerSegments[i].path, "RCBANKT") || reader.recordSize() != sizeof(TransactionRecord)) {
+            return false;
+        }
+        for (const auto& part : reader.blocks()) {
+            for (size_t j = 0; j < part.count; j++, rows++) {
+                if (rows % COMPACTED_SEGMENT_ROWS == 0) {
+                    blocks.emplace_back();
+                    blocks.back().reserve(min(end - first - rows, COMPACTED_SEGMENT_ROWS),
+                                          sizeof(TransactionRecord), 0);
+                }
+                blocks.back().addRecord(part.records + j * sizeof(TransactionRecord), sizeof(TransactionRecord));
+            }
+        }
+    }
+    if (rows != end - first) return false;
+    vector<LedgerSegment> replacements;
+    size_t written = first;
+    for (const auto& block : blocks) {
+        size_t segmentEnd = written + block.recordCount();
+        if (!writeLedgerSegment(block, written, segmentEnd)) return false;
+        replacements.push_back({ledgerSegmentPath(written, segmentEnd), written, segmentEnd});
+        written = segmentEnd;
+    }
     
-    for (const auto& trans : transactions) {
-        file << trans.accountNo << "|"
-             << trans.type << "|"
-             << trans.amount << "|"
-             << trans.date << "|"
-             << trans.balanceAfter << "\n";
+    vector<LedgerSegment> merged(ledgerSegments.begin() + mergeFrom, ledgerSegments.end());
+    ledgerSegments.resize(mergeFrom);
+    ledgerSegments.insert(ledgerSegments.end(), replacements.begin(), replacements.end());
+    // Cold readers may still be paging in the old files
+    if (ledgerCache && first < transactions.firstResident()) {
+        unique_lock<shared_mutex> coldLock(coldMutex);
+        refreshColdSegments();
+        for (const auto& segment : merged) {
+            ledgerCache->erase(segment.path);
+        }
     }
-    file.close();
+    for (const auto& segment : merged) {
+        remove(segment.path.c_str());
+    }
+    return true;
+}
+
+size_t BankingSystem::ledgerSegmentCount() {
+    lock_guard<mutex> checkpointLock(checkpointMutex);
+    return ledgerSegments.size();
+}
+
+// One-shot migration: whatever was loaded at startup (the text files when
+// no binary checkpoint exists yet) is written out as a binary checkpoint
+bool BankingSystem::convertToBinaryFormat() {
+    if (!checkpoint()) {
+        cout << "❌ Error writing binary data files!\n";
+        return false;
+    }
+    cout << "✅ Converted " << accounts.size() << " accounts and "
+         << transactions.size() << " transactions to "
+         << ACCOUNTS_BINARY_FILE << " / " << LEDGER_SEGMENT_PREFIX << "*.bin\n";
+    return true;
+}
+
+// Every stripe held gives a consistent total; lookups still share the table
+Money BankingSystem::totalBalance() const {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    StripeScan stripes(*this);
+    return accounts.totalActiveBalance();
 }
 
-void BankingSystem::runBankingSystem() {
-    int choice;
-    bool exitSystem = false;
+// No lock: the totals are atomics and their stripes never move
+AccountTypeTotals BankingSystem::accountTypeTotals() const {
+    AccountTypeTotals totals;
+    for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+        accounts.activeTotals(static_cast<AccountType>(type), totals.accounts[type], totals.balance[type]);
+    }
+    return totals;
+}
+
+AccountTypeTotals BankingSystem::scanAccountTypeTotals(unsigned threads) const {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    StripeScan stripes(*this);
+    return ReportEngine::typeTotals(accounts.columns(), threads);
+}
+
+vector<AccountBalance> BankingSystem::accountsBelowMinimum(unsigned threads) const {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    StripeScan stripes(*this);
+    return ReportEngine::balancesBelow(accounts.columns(), MIN_BALANCE, threads);
+}
+
+vector<AccountBalance> BankingSystem::topBalances(size_t count, unsigned threads) const {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    StripeScan stripes(*this);
+    return ReportEngine::topBalances(accounts.columns(), count, threads);
+}
+
+// Cold segments are summed one at a time over the same days as the
+// resident rows, so open ends are resolved over all of them first
+vector<DailyFlow> BankingSystem::dailyFlows(time_t fromDate, time_t toDate, unsigned threads) const {
+    vector<const Transaction*> chunks;
+    vector<LedgerPartition> partitions;
+    {
+        lock_guard<mutex> ledgerLock(ledgerMutex);
+        partitions = transactions.partitionsBetween(fromDate ? static_cast<int64_t>(fromDate) : INT64_MIN,
+                                                    toDate ? static_cast<int64_t>(toDate) : INT64_MAX);
+        chunks = chunkList(transactions);
+    }
+    if (!ledgerCache) return ReportEngine::dailyFlows(chunks, partitions, fromDate, toDate, threads);
+    
+    shared_lock<shared_mutex> coldLock(coldMutex);
+    if (fromDate == 0 || toDate == 0) {
+        int64_t earliest = INT64_MAX;
+        int64_t latest = INT64_MIN;
+        for (const auto& partition : partitions) {
+            earliest = min(earliest, partition.minTimestamp);
+            latest = max(latest, partition.maxTimestamp);
+        }
+        for (const auto& cold : coldSegments) {
+            int64_t minTimestamp;
+            int64_t maxTimestamp;
+            if (!coldSpan(cold, minTimestamp, maxTimestamp)) continue;
+            earliest = min(earliest, minTimestamp);
+            latest = max(latest, maxTimestamp);
+        }
+        if (earliest > latest) return {};
+        if (fromDate == 0) fromDate = static_cast<time_t>(earliest);
+        if (toDate == 0) toDate = static_cast<time_t>(latest);
+    }
     
-    while (!exitSystem) {
-        displayMainMenu();
-        cin >> choice;
-        
-        switch (choice) {
-            case 1: createNewAccount(); break;
-            case 2: depositMoney(); break;
-            case 3: withdrawMoney(); break;
-            case 4: checkBalance(); break;
-            case 5: viewAccountDetails(); break;
-            case 6: transferMoney(); break;
-            case 7: viewTransactionHistory(); break;
-            case 8: generateAccountStatement(); break;
-            case 9: deactivateAccount(); break;
-            case 0:
-                clearScreen();
-                displayFooter();
-                cout << "\n🙏 Thank you for using Riddhi's Banking System!\n";
-                cout << "💫 Have a great day ahead!\n\n";
-                exitSystem = true;
-                break;
-            default:
-                cout << "\n❌ Invalid choice! Please try again.\n";
-                pauseScreen();
+    vector<DailyFlow> flows = ReportEngine::dailyFlows(chunks, partitions, fromDate, toDate, threads);
+    for (const auto& cold : coldSegments) {
+        shared_ptr<const CachedSegment> segment = loadColdSegment(cold, fromDate, toDate);
+        if (!segment) continue;
+        vector<DailyFlow> part = ReportEngine::dailyFlows(chunkList(segment->rows),
+                                                          segment->rows.partitionsBetween(fromDate, toDate),
+                                                          fromDate, toDate, threads);
+        if (flows.empty()) {
+            flows = part;
+            continue;
+        }
+        for (size_t day = 0; day < part.size(); day++) {
+            flows[day].inflow += part[day].inflow;
+            flows[day].outflow += part[day].outflow;
+            flows[day].transfers += part[day].transfers;
+            flows[day].rows += part[day].rows;
         }
     }
+    return flows;
+}
+
+// Capacities only change when an account is added, under the exclusive lock
+size_t BankingSystem::accountMemoryUsage() const {
+    shared_lock<shared_mutex> tableLock(accountsMutex);
+    return accounts.memoryUsage();
+}
+
+size_t BankingSystem::ledgerMemoryUsage() const {
+    size_t cached = ledgerCache ? ledgerCache->residentBytes() : 0;
+    lock_guard<mutex> ledgerLock(ledgerMutex);
+    return transactions.memoryUsage() + cached;
+}
+
+void BankingSystem::setWalSyncBatch(size_t records) {
+    wal.setSyncBatch(records);
+}
+
+void BankingSystem::setSessionTtl(unsigned seconds) {
+    sessions.setTtl(seconds);
+}
+
+// For callers that answer several requests at once: this thread's
+// operations stop waiting for their log records, and syncLog(), run before
+// acknowledging any of them, waits once for everything logged so far
+void BankingSystem::deferLogSync(bool defer) {
+    logSyncDeferred = defer;
+}
+
+bool BankingSystem::syncLog() {
+    bool written = wal.sync() && !logRefused;
+    logRefused = false;
+    return written;
 }
@@ -11,16 +11,102 @@
 #include <algorithm>
 #include <random>
 #include <chrono>
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+#include "WriteAheadLog.h"
+#include "BinaryStore.h"
+#include "Money.h"
+#include "AccountStore.h"
+#include "LedgerStore.h"
+#include "Credentials.h"
+#include "ReportEngine.h"
+#include "LedgerCache.h"
 
 using namespace std;
 
-// Transaction structure to store transaction history
-struct Transaction {
+// Outcome codes for the programmatic banking operations
+enum class ErrorCode {
+    Success,
+    AccountNotFound,
+    AccountInactive,
+    InvalidAmount,
+    InsufficientBalance,
+    MinimumBalance,
+    SameAccount,
+    AuthenticationFailed,
+    AmountOverflow,
+    IoError,
+    BadRequest,
+    IdempotencyConflict,
+    TransferHeld
+};
+
+const char* errorMessage(ErrorCode code);
+
+// Lazy loading for BankingSystems constructed afterwards: a non-zero cap
+// leaves sealed ledger segments on disk until first read, keeping at most
+// cacheBytes of them in memory, and reads cold account text from the
+// mapped accounts.bin. 0 (the default) loads everything at startup.
+void setLazyLoading(size_t cacheBytes);
+
+// Threads that parse accounts.dat and transactions.dat for BankingSystems
+// constructed afterwards; 0 (the default) uses every core
+void setLoadThreads(unsigned threads);
+
+// One row of a bulk settlement batch; toAccount is used by transfers only
+enum class BatchOperationType {
+    Deposit,
+    Withdraw,
+    Transfer
+};
+
+struct BatchOperation {
+    BatchOperationType type;
+    AccountId accountId;
+    AccountId toAccount;
+    Money amount;
+};
+
+// One credit of a multi-leg transfer
+struct TransferLeg {
+    AccountId toAccount;
+    Money amount;
+};
+
+// Totals for one bulk statement run
+struct StatementRunSummary {
+    size_t files;
+    size_t rows;
+    unsigned threads;
+    double seconds;
+};
+
+// Where startup time went, filled in by the constructor. Text is true
+// when the data came from the text files rather than binary checkpoints.
+struct StartupTiming {
+    double accountsSeconds;
+    double ledgerSeconds;
+    double replaySeconds;
+    double totalSeconds;
+    size_t accounts;
+    size_t rows;
+    unsigned threads;
+    bool text;
+};
+
+// Returned by every BankingSystem API call; balance is the account's
+// balance after the call and accountNo is set by openAccount
+struct Result {
+    ErrorCode code;
+    Money balance;
     string accountNo;
-    string type;
-    double amount;
-    string date;
-    double balanceAfter;
+    
+    Result(ErrorCode c = ErrorCode::Success, Money bal = Money()) : code(c), balance(bal) {}
+    bool ok() const { return code == ErrorCode::Success; }
 };
 
 class BankAccount {
@@ -28,7 +114,7 @@ private:
     string accountNumber;
     string accountHolderName;
     string password;
-    double balance;
+    Money balance;
     string accountType;
     string creationDate;
     bool isActive;
@@ -36,24 +122,24 @@ private:
 public:
     // Constructors
     BankAccount();
-    BankAccount(string accNo, string name, string pass, double bal, string type);
+    BankAccount(string accNo, string name, string pass, Money bal, string type);
     
     // Setters
     void setAccountNumber(const string& accNo);
     void setAccountHolderName(const string& name);
     void setPassword(const string& pass);
-    void setBalance(double bal);
+    void setBalance(Money bal);
     void setAccountType(const string& type);
     void setCreationDate(const string& date);
     void setActiveStatus(bool status);
     
     // Getters
-    string getAccountNumber() const;
-    string getAccountHolderName() const;
-    string getPassword() const;
-    double getBalance() const;
-    string getAccountType() const;
-    string getCreationDate() const;
+    const string& getAccountNumber() const;
+    const string& getAccountHolderName() const;
+    const string& getPassword() const;
+    Money getBalance() const;
+    const string& getAccountType() const;
+    const string& getCreationDate() const;
     bool getActiveStatus() const;
     
     // Utility functions
@@ -63,47 +149,284 @@ public:
 
 class BankingSystem {
 private:
-    vector<BankAccount> accounts;
-    vector<Transaction> transactions;
-    const string ACCOUNTS_FILE = "accounts.dat";
-    const string TRANSACTIONS_FILE = "transactions.dat";
-    const double MIN_BALANCE = 100.0;
+    AccountStore accounts;
+    LedgerStore transactions;
+    // Account ID -> slot in accounts (inactive accounts stay indexed so
+    // their numbers are never reissued)
+    unordered_map<AccountId, size_t> accountIndex;
+    // Account ID -> positions of its rows in transactions, oldest first
+    unordered_map<AccountId, vector<size_t>> transactionIndex;
+    // Next serial to issue; always past every serial already in use. A
+    // shard only issues serials equal to serialOffset modulo serialStride.
+    uint64_t nextAccountSerial;
+    uint64_t serialStride;
+    uint64_t serialOffset;
+    // Every data file lives here; empty means the working directory
+    const string dataDirectory;
+    // Segment cache cap in lazy mode; 0 loads everything at startup
+    const size_t ledgerCacheBytes;
+    // Parser threads for the text files; 0 uses every core
+    const unsigned loadThreads;
+    StartupTiming startup;
+    const string ACCOUNTS_FILE = dataPath("accounts.dat");
+    const string TRANSACTIONS_FILE = dataPath("transactions.dat");
+    const string ACCOUNTS_BINARY_FILE = dataPath("accounts.bin");
+    const string TRANSACTIONS_BINARY_FILE = dataPath("transactions.bin");
+    const string LEDGER_SEGMENT_PREFIX = "ledger_";
+    const Money MIN_BALANCE = Money::fromRupees(100);
+    const string WAL_FILE = dataPath("banking.wal");
+    const size_t WAL_CHECKPOINT_BYTES = 16 * 1024 * 1024;
+    const int CHECKPOINT_INTERVAL_SECONDS = 60;
+    const unsigned SESSION_TTL_SECONDS = 120;
+    // Segments below this many rows are merged by compaction. None is
+    // written larger, so paging one in costs a bounded amount of memory.
+    const size_t COMPACTED_SEGMENT_ROWS = 1 << 20;
+    const size_t LEDGER_SEGMENT_LIMIT = 8;
+    
+    // Changes since the last checkpoint; checkpoints are accounts.bin plus
+    // the sealed ledger segments, with the text files (or a pre-segment
+    // transactions.bin) read only until the first checkpoint is taken
+    WriteAheadLog wal;
+    size_t checkpointedTransactions;
+    bool legacyLedgerFile;
+    // Logs sealed by a checkpoint that has not finished yet
+    vector<string> sealedLogs;
+    uint64_t nextLogGeneration;
+    
+    // Successful multi-leg transfers by idempotency key, kept for
+    // IDEMPOTENCY_TTL_SECONDS. Logged with each transfer's rows and written
+    // to IDEMPOTENCY_FILE by every checkpoint, so retries are recognised
+    // across restarts. The fingerprint tells a retry from a different
+    // request that reuses the key.
+    struct IdempotentResult {
+        int64_t created;
+        uint64_t fingerprint;
+        Money balance;
+    };
+    unordered_map<string, IdempotentResult> idempotencyKeys;
+    mutable mutex idempotencyMutex;
+    const string IDEMPOTENCY_FILE = dataPath("idempotency.dat");
+    const int64_t IDEMPOTENCY_TTL_SECONDS = 24 * 60 * 60;
+    const size_t MAX_IDEMPOTENCY_KEY = 64;
+    // A log ended part way through a multi-leg group; the next appends
+    // must not land after it, so startup takes a checkpoint
+    bool tornLogGroup;
+    // Replay stopped at a damaged record; what follows it is dropped by the
+    // same startup checkpoint
+    bool damagedLog;
+    
+    // Immutable ledger files holding rows [first, end), oldest first
+    struct LedgerSegment {
+        string path;
+        size_t first;
+        size_t end;
+    };
+    vector<LedgerSegment> ledgerSegments;
+    
+    // Lazy mode: ledger rows [first, end), all before the first resident
+    // row, are rows [skip, skip + end - first) of a segment file. Cold
+    // readers hold coldMutex shared; compaction replaces the list under it.
+    struct ColdSegment {
+        string path;
+        size_t first;
+        size_t end;
+        size_t skip;
+    };
+    vector<ColdSegment> coldSegments;
+    unique_ptr<LedgerCache> ledgerCache;
+    mutable shared_mutex coldMutex;
+    // Lazy mode keeps accounts.bin mapped for the cold account text
+    DataFileReader mappedAccounts;
+    
+    // Logins verified in the last SESSION_TTL_SECONDS skip scrypt
+    SessionCache sessions;
+    
+    // checkpointMutex serialises checkpoints and compaction and guards the
+    // fields above; the checkpointer thread sleeps on checkpointWake
+    mutex checkpointMutex;
+    mutex checkpointerMutex;
+    condition_variable checkpointWake;
+    bool checkpointDue;
+    bool stopping;
+    thread checkpointer;
+    
+    // Lock order: checkpointMutex, then accountsMutex (exclusive only to
+    // add accounts or apply a batch), then account stripes in ascending
+    // order, then ledgerMutex, then coldMutex or idempotencyMutex, then
+    // checkpointerMutex
+    static const size_t ACCOUNT_LOCK_STRIPES = 1024;
+    struct alignas(64) AccountLock {
+        mutex lock;
+    };
+    mutable shared_mutex accountsMutex;
+    mutable array<AccountLock, ACCOUNT_LOCK_STRIPES> accountLocks;
+    mutable mutex ledgerMutex;
+    
+    // Holds every account stripe, in ascending order, so a scan under the
+    // shared table lock sees no balance or status change part-way
+    class StripeScan {
+    public:
+        explicit StripeScan(const BankingSystem& bank);
+        ~StripeScan();
+    private:
+        const BankingSystem& bank;
+    };
+    
+    string dataPath(const string& name) const;
+    mutex& accountLock(size_t slot) const { return accountLocks[slot % ACCOUNT_LOCK_STRIPES].lock; }
+    int findSlot(AccountId id) const;
+    int findSlot(const string& accountNo) const { return findSlot(parseAccountId(accountNo)); }
+    size_t addAccount(const BankAccount& acc);
+    BankAccount accountAt(size_t slot) const;
+    // False if the log has failed; the record is not logged
+    bool logRecord(string_view record, bool deferSync = false);
+    bool appendLedgerRow(const Transaction& trans, bool deferSync = false);
+    static Transaction makeTransaction(AccountId accountId, TransactionType type, Money amount,
+                                       Money newBalance, int64_t timestamp,
+                                       AccountId counterparty = NO_ACCOUNT);
+    ErrorCode checkDebit(Money balance, Money amount) const;
+    string ledgerSegmentPath(size_t first, size_t end) const;
+    void refreshColdSegments();
+    shared_ptr<const CachedSegment> loadColdSegment(const ColdSegment& cold, int64_t fromTime, int64_t toTime) const;
+    bool coldSpan(const ColdSegment& cold, int64_t& minTimestamp, int64_t& maxTimestamp) const;
+    template <typename Visit>
+    void visitColdRows(int64_t fromTime, int64_t toTime, Visit visit) const;
+    bool writeLedgerSegment(const DataBlockWriter& block, size_t first, size_t end);
+    AccountStore snapshotAccounts() const;
+    void rememberIdempotencyKey(const string& key, const IdempotentResult& result);
+    vector<pair<string, IdempotentResult>> snapshotIdempotencyKeys(int64_t now);
+    bool saveIdempotencyKeys(const vector<pair<string, IdempotentResult>>& keys);
+    void loadIdempotencyKeys();
+    void runCheckpointer();
+    void upgradePassword(AccountId accountId, const string& legacy, const string& hash);
+    // The logging operations, run by the public ones once their locks are
+    // released so they can wait for the log
+    Result postDeposit(const string& accountNo, Money amount);
+    Result postWithdrawal(const string& accountNo, Money amount);
+    Result postTransfer(const string& fromAccount, const string& toAccount, Money amount);
+    Result postMultiTransfer(const string& fromAccount, const vector<TransferLeg>& legs,
+                             const string& idempotencyKey);
+    Result postDebitTransfer(const string& fromAccount, AccountId toAccount, Money amount, int64_t timestamp,
+                             uint32_t transferId);
+    Result postCreditTransfer(const string& toAccount, AccountId fromAccount, Money amount, int64_t timestamp,
+                              uint32_t transferId);
+    Result postDeactivation(const string& accountNo);
     
 public:
-    BankingSystem();
+    explicit BankingSystem(const string& directory = "");
     ~BankingSystem();
     
-    // Core banking operations
-    void createNewAccount();
-    void depositMoney();
-    void withdrawMoney();
-    void checkBalance();
-    void viewAccountDetails();
-    void transferMoney();
-    void viewTransactionHistory();
-    void deactivateAccount();
-    void generateAccountStatement();
+    // Core banking operations: thread-safe, no console I/O
+    Result openAccount(const string& name, const string& password,
+                       const string& accountType, Money initialDeposit);
+    Result authenticate(const string& accountNo, const string& password);
+    // The same two operations in steps, for a caller that runs operations
+    // on one thread but hashes passwords on another (ShardedBank). The
+    // credential is hashPassword(password). beginLogin answers from the
+    // session cache when it sets cached; otherwise it returns the stored
+    // hash for verifyLogin, which takes no lock, and finishLogin then
+    // records the login.
+    Result openAccountWithCredential(const string& name, const string& password, const string& credential,
+                                     const string& accountType, Money initialDeposit);
+    Result beginLogin(const string& accountNo, const string& password, bool& cached, string& stored);
+    // False on a wrong password; a legacy plaintext one sets upgraded to
+    // the hash that replaces it
+    static bool verifyLogin(const string& password, const string& stored, string& upgraded);
+    Result finishLogin(const string& accountNo, const string& password, const string& stored,
+                       const string& upgraded);
+    Result deposit(const string& accountNo, Money amount);
+    Result withdraw(const string& accountNo, Money amount);
+    Result transfer(const string& fromAccount, const string& toAccount, Money amount);
+    // Debits fromAccount once per leg and credits each leg's account, all
+    // or nothing: every leg, and the minimum balance left on the source,
+    // is checked before any balance changes, and the rows are logged as
+    // one group that replay applies whole or not at all. A leg that fails
+    // its check is named in accountNo. A retry with the same non-empty
+    // idempotencyKey (at most MAX_IDEMPOTENCY_KEY bytes, no '|' or newline)
+    // returns the first call's result without posting again, as long as the
+    // source is still active; reusing a key for different legs fails with
+    // IdempotencyConflict. Only successful transfers are remembered, since
+    // a failed one posted nothing.
+    Result transferToMany(const string& fromAccount, const vector<TransferLeg>& legs,
+                          const string& idempotencyKey = "");
+    // The two halves of a transfer whose accounts live in different
+    // BankingSystems: a TransferOut row with the usual minimum balance
+    // check, and a TransferIn row. Both rows carry the given timestamp and
+    // the transfer's ID, so recovery can find them again.
+    Result debitTransfer(const string& fromAccount, AccountId toAccount, Money amount, int64_t timestamp,
+                         uint32_t transferId);
+    Result creditTransfer(const string& toAccount, AccountId fromAccount, Money amount, int64_t timestamp,
+                          uint32_t transferId);
+    Result getBalance(const string& accountNo);
+    Result getAccountDetails(const string& accountNo, BankAccount& details);
+    Result getTransactionHistory(const string& accountNo, vector<Transaction>& history,
+                                 time_t fromDate = 0, time_t toDate = 0, size_t limit = 0);
+    Result writeAccountStatement(const string& accountNo, string& filename);
+    // One statement_<account>.txt per active account; threads = 0 uses every
+    // core. A non-zero fromDate/toDate limits the rows to that period.
+    Result writeAllStatements(const string& directory, unsigned threads, StatementRunSummary& summary,
+                              time_t fromDate = 0, time_t toDate = 0);
+    Result deactivate(const string& accountNo);
+    void applyBatch(const vector<BatchOperation>& operations, vector<Result>& results);
+    Money getMinimumBalance() const { return MIN_BALANCE; }
+    Money totalBalance() const;
+    size_t accountMemoryUsage() const;
+    // Resident ledger rows plus cached cold segments
+    size_t ledgerMemoryUsage() const;
+    const StartupTiming& startupTiming() const { return startup; }
+    
+    // Bank-wide reports. Account type totals are running totals read in
+    // constant time; the rest are parallel column scans (threads = 0 uses
+    // every core) taken under the same locks as totalBalance()
+    AccountTypeTotals accountTypeTotals() const;
+    AccountTypeTotals scanAccountTypeTotals(unsigned threads = 0) const;
+    vector<AccountBalance> accountsBelowMinimum(unsigned threads = 0) const;
+    vector<AccountBalance> topBalances(size_t count, unsigned threads = 0) const;
+    vector<DailyFlow> dailyFlows(time_t fromDate = 0, time_t toDate = 0, unsigned threads = 0) const;
     
     // File operations
     void loadAccountsFromFile();
-    void saveAccountsToFile();
+    bool saveAccountsToFile();
     void loadTransactionsFromFile();
     void saveTransactionsToFile();
+    bool loadAccountsFromBinaryFile();
+    bool saveAccountsToBinaryFile(const AccountStore& table);
+    bool loadTransactionsFromBinaryFile();
+    void replayWriteAheadLog();
+    bool replayLogFile(const string& path);
+    bool checkpoint();
+    bool compactLedger();
+    size_t ledgerSegmentCount();
+    bool convertToBinaryFormat();
+    void setWalSyncBatch(size_t records);
+    // 0 turns the verified-login cache off
+    void setSessionTtl(unsigned seconds);
+    void deferLogSync(bool defer);
+    // False if anything logged so far failed to reach disk; requests it
+    // covers must not be acknowledged
+    bool syncLog();
+    static string formatAccountRecord(const BankAccount& acc);
+    static BankAccount parseAccountRecord(string_view line);
+    static const size_t TRANSACTION_RECORD_MAX = 160;
+    static string formatTransactionRecord(const Transaction& trans);
+    static size_t formatTransactionRecord(const Transaction& trans, char* buffer);
+    static Transaction parseTransactionRecord(string_view line);
     
     // Utility functions
-    void displayMainMenu();
-    void clearScreen();
-    void pauseScreen();
-    bool authenticateUser(string& accountNo);
     int findAccountIndex(const string& accountNo);
-    void addTransaction(const string& accountNo, const string& type, double amount, double newBalance);
+    void indexAccount(size_t slot);
+    void rebuildAccountIndex();
+    void addTransaction(AccountId accountId, TransactionType type, Money amount, Money newBalance);
+    void rebuildTransactionIndex();
+    vector<Transaction> findAccountTransactions(AccountId accountId, time_t fromDate = 0,
+                                                time_t toDate = 0, size_t limit = 0);
+    static time_t parseTransactionDate(const string& date);
+    static bool parseTransactionType(string_view text, TransactionType& type, AccountId& counterparty);
     bool isValidAccountNumber(const string& accountNo);
-    string generateAccountNumber();
-    void displayHeader();
-    void displayFooter();
-    
-    // Main System loop
-    void runBankingSystem();
+    AccountId generateAccountId();
+    // New accounts get serials equal to partition modulo partitions, so
+    // several systems can issue numbers without ever colliding
+    void partitionAccountSerials(uint64_t partition, uint64_t partitions);
 };
 
 #endif
@@ -0,0 +1,412 @@
+#include "BankingConsole.h"
+
+BankingConsole::BankingConsole(BankingSystem& system) : bank(system) {}
+
+void BankingConsole::displayHeader() {
+    cout << "\n";
+    cout << "╔══════════════════════════════════════════════════════════════╗\n";
+    cout << "║              RIDDHI'S ADVANCED BANKING SYSTEM                ║\n";
+    cout << "║                   Enhanced Version 2.0                      ║\n";
+    cout << "║                                                              ║\n";
+    cout << "║  Developer: Riddhi Chakraborty                               ║\n";
+    cout << "║  Professional Banking Management System                      ║\n";
+    cout << "╚══════════════════════════════════════════════════════════════╝\n";
+}
+
+void BankingConsole::displayFooter() {
+    cout << "\n╔══════════════════════════════════════════════════════════════╗\n";
+    cout << "║                                                              ║\n";
+    cout << "║           Thank you for using Riddhi's Banking System!      ║\n";
+    cout << "║                    Banking made simple & secure             ║\n";
+    cout << "╚══════════════════════════════════════════════════════════════╝\n";
+}
+
+void BankingConsole::displayMainMenu() {
+    clearScreen();
+    displayHeader();
+    cout << "\n┌─────────────────── MAIN MENU ───────────────────┐\n";
+    cout << "│  1. Create New Account                          │\n";
+    cout << "│  2. Deposit Money                               │\n";
+    cout << "│  3. Withdraw Money                              │\n";
+    cout << "│  4. Check Balance                               │\n";
+    cout << "│  5. View Account Details                        │\n";
+    cout << "│  6. Transfer Money                              │\n";
+    cout << "│  7. Transaction History                         │\n";
+    cout << "│  8. Generate Account Statement                  │\n";
+    cout << "│  9. Deactivate Account                          │\n";
+    cout << "│  0. Exit System                                 │\n";
+    cout << "└─────────────────────────────────────────────────┘\n";
+    cout << "\n➤ Enter your choice: ";
+}
+
+// ANSI clear + home instead of spawning a shell for every screen
+void BankingConsole::clearScreen() {
+    #ifdef _WIN32
+        system("cls");
+    #else
+        cout << "\033[2J\033[H" << flush;
+    #endif
+}
+
+void BankingConsole::pauseScreen() {
+    cout << "\nPress Enter to continue...";
+    cin.ignore();
+    cin.get();
+}
+
+bool BankingConsole::authenticateUser(string& accountNo) {
+    cout << "\n┌─────────── USER AUTHENTICATION ───────────┐\n";
+    cout << "│ Account Number: ";
+    cin >> accountNo;
+    
+    if (bank.findAccountIndex(accountNo) == -1) {
+        cout << "│ ❌ Invalid account number!                │\n";
+        cout << "└────────────────────────────────────────────┘\n";
+        return false;
+    }
+    
+    string password;
+    cout << "│ Password: ";
+    cin >> password;
+    
+    if (!bank.authenticate(accountNo, password).ok()) {
+        cout << "│ ❌ Incorrect password!                    │\n";
+        cout << "└────────────────────────────────────────────┘\n";
+        return false;
+    }
+    
+    cout << "│ ✅ Authentication successful!             │\n";
+    cout << "└────────────────────────────────────────────┘\n";
+    return true;
+}
+
+// Amounts are read as text so they reach the bank exactly; anything that
+// is not a valid amount comes back as zero and is rejected by the bank
+Money BankingConsole::readAmount() {
+    string text;
+    cin >> text;
+    Money amount;
+    if (!Money::parse(text, amount)) return Money();
+    return amount;
+}
+
+void BankingConsole::createNewAccount() {
+    clearScreen();
+    displayHeader();
+    cout << "\n┌─────────── CREATE NEW ACCOUNT ───────────┐\n";
+    
+    string name, password, accountType;
+    Money initialDeposit;
+    
+    cin.ignore();
+    cout << "│ Account Holder Name: ";
+    getline(cin, name);
+    
+    cout << "│ Create Password: ";
+    cin >> password;
+    
+    cout << "│ Account Type (1-Savings/2-Current): ";
+    int typeChoice;
+    cin >> typeChoice;
+    accountType = (typeChoice == 1) ? "Savings" : "Current";
+    
+    cout << "│ Initial Deposit (Min ₹" << bank.getMinimumBalance() << "): ₹";
+    initialDeposit = readAmount();
+    
+    Result result = bank.openAccount(name, password, accountType, initialDeposit);
+    if (!result.ok()) {
+        cout << "│ ❌ Minimum deposit required: ₹" << bank.getMinimumBalance() << "\n";
+        cout << "└────────────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "│ ✅ Account created successfully!          │\n";
+    cout << "│ Your Account Number: " << result.accountNo << "           │\n";
+    cout << "│ Please note down your account number!     │\n";
+    cout << "└────────────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::depositMoney() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    Money amount;
+    
+    cout << "\n┌─────────── DEPOSIT MONEY ───────────┐\n";
+    cout << "│ Current Balance: ₹" << bank.getBalance(accountNo).balance << "\n";
+    cout << "│ Enter deposit amount: ₹";
+    amount = readAmount();
+    
+    Result result = bank.deposit(accountNo, amount);
+    if (!result.ok()) {
+        cout << "│ ❌ " << errorMessage(result.code) << "\n";
+        cout << "└─────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "│ ✅ Deposit successful!              │\n";
+    cout << "│ New Balance: ₹" << result.balance << "\n";
+    cout << "└─────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::withdrawMoney() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    Money amount;
+    
+    cout << "\n┌─────────── WITHDRAW MONEY ───────────┐\n";
+    cout << "│ Current Balance: ₹" << bank.getBalance(accountNo).balance << "\n";
+    cout << "│ Enter withdrawal amount: ₹";
+    amount = readAmount();
+    
+    Result result = bank.withdraw(accountNo, amount);
+    if (!result.ok()) {
+        if (result.code == ErrorCode::MinimumBalance) {
+            cout << "│ ❌ Minimum balance ₹" << bank.getMinimumBalance() << " required! │\n";
+        } else {
+            cout << "│ ❌ " << errorMessage(result.code) << "\n";
+        }
+        cout << "└──────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "│ ✅ Withdrawal successful!            │\n";
+    cout << "│ New Balance: ₹" << result.balance << "\n";
+    cout << "└──────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::checkBalance() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    BankAccount account;
+    bank.getAccountDetails(accountNo, account);
+    
+    cout << "\n┌─────────── BALANCE INQUIRY ───────────┐\n";
+    cout << "│ Account Number: " << account.getAccountNumber() << "\n";
+    cout << "│ Account Holder: " << account.getAccountHolderName() << "\n";
+    cout << "│ Current Balance: ₹" << account.getBalance() << "\n";
+    cout << "│ Account Type: " << account.getAccountType() << "\n";
+    cout << "└────────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::viewAccountDetails() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    BankAccount account;
+    bank.getAccountDetails(accountNo, account);
+    
+    cout << "\n┌─────────── ACCOUNT DETAILS ───────────┐\n";
+    cout << "│ Account Number: " << account.getAccountNumber() << "\n";
+    cout << "│ Account Holder: " << account.getAccountHolderName() << "\n";
+    cout << "│ Account Type: " << account.getAccountType() << "\n";
+    cout << "│ Current Balance: ₹" << account.getBalance() << "\n";
+    cout << "│ Account Created: " << account.getCreationDate() << "\n";
+    cout << "│ Status: " << (account.getActiveStatus() ? "Active" : "Inactive") << "\n";
+    cout << "└────────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::transferMoney() {
+    clearScreen();
+    displayHeader();
+    
+    string fromAccount;
+    if (!authenticateUser(fromAccount)) {
+        pauseScreen();
+        return;
+    }
+    
+    string toAccount;
+    Money amount;
+    
+    cout << "\n┌─────────── MONEY TRANSFER ───────────┐\n";
+    cout << "│ Transfer to Account Number: ";
+    cin >> toAccount;
+    
+    if (bank.findAccountIndex(toAccount) == -1) {
+        cout << "│ ❌ Recipient account not found!      │\n";
+        cout << "└───────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    if (fromAccount == toAccount) {
+        cout << "│ ❌ Cannot transfer to same account!  │\n";
+        cout << "└───────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "│ Transfer Amount: ₹";
+    amount = readAmount();
+    
+    Result result = bank.transfer(fromAccount, toAccount, amount);
+    if (!result.ok()) {
+        ErrorCode shown = (result.code == ErrorCode::MinimumBalance) ? ErrorCode::InsufficientBalance : result.code;
+        cout << "│ ❌ " << errorMessage(shown) << "\n";
+        cout << "└───────────────────────────────────────┘\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "│ ✅ Transfer successful!              │\n";
+    cout << "│ Transferred ₹" << amount << " to " << toAccount << "\n";
+    cout << "│ Your new balance: ₹" << result.balance << "\n";
+    cout << "└───────────────────────────────────────┘\n";
+    
+    pauseScreen();
+}
+
+void BankingConsole::viewTransactionHistory() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    cout << "\n┌─────────── TRANSACTION HISTORY ───────────┐\n";
+    cout << "│ Account: " << accountNo << "\n";
+    cout << "├────────────────────────────────────────────┤\n";
+    
+    vector<Transaction> history;
+    bank.getTransactionHistory(accountNo, history);
+    for (const auto& trans : history) {
+        cout << "│ " << trans.dateText() << "\n";
+        cout << "│ Type: " << trans.description() << "\n";
+        cout << "│ Amount: ₹" << trans.amount << "\n";
+        cout << "│ Balance After: ₹" << trans.balanceAfter << "\n";
+        cout << "├────────────────────────────────────────────┤\n";
+    }
+    
+    if (history.empty()) {
+        cout << "│ No transactions found.                     │\n";
+    }
+    
+    cout << "└────────────────────────────────────────────┘\n";
+    pauseScreen();
+}
+
+void BankingConsole::generateAccountStatement() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    string filename;
+    if (!bank.writeAccountStatement(accountNo, filename).ok()) {
+        cout << "❌ Error creating statement file!\n";
+        pauseScreen();
+        return;
+    }
+    
+    cout << "\n✅ Account statement generated successfully!\n";
+    cout << "File saved as: " << filename << "\n";
+    pauseScreen();
+}
+
+void BankingConsole::deactivateAccount() {
+    clearScreen();
+    displayHeader();
+    
+    string accountNo;
+    if (!authenticateUser(accountNo)) {
+        pauseScreen();
+        return;
+    }
+    
+    cout << "\n┌─────────── DEACTIVATE ACCOUNT ───────────┐\n";
+    cout << "│ ⚠️  WARNING: This action is irreversible! │\n";
+    cout << "│ Current Balance: ₹" << bank.getBalance(accountNo).balance << "\n";
+    cout << "│ Confirm deactivation (Y/N): ";
+    
+    char confirm;
+    cin >> confirm;
+    
+    if ((confirm == 'Y' || confirm == 'y') && bank.deactivate(accountNo).ok()) {
+        cout << "│ ✅ Account deactivated successfully!     │\n";
+        cout << "│ Please visit branch for balance refund.  │\n";
+    } else {
+        cout << "│ ❌ Deactivation cancelled.               │\n";
+    }
+    
+    cout << "└───────────────────────────────────────────┘\n";
+    pauseScreen();
+}
+
+void BankingConsole::runBankingSystem() {
+    int choice;
+    bool exitSystem = false;
+    
+    while (!exitSystem) {
+        displayMainMenu();
+        cin >> choice;
+    
+        switch (choice) {
+            case 1: createNewAccount(); break;
+            case 2: depositMoney(); break;
+            case 3: withdrawMoney(); break;
+            case 4: checkBalance(); break;
+            case 5: viewAccountDetails(); break;
+            case 6: transferMoney(); break;
+            case 7: viewTransactionHistory(); break;
+            case 8: generateAccountStatement(); break;
+            case 9: deactivateAccount(); break;
+            case 0:
+                clearScreen();
+                displayFooter();
+                cout << "\n🙏 Thank you for using Riddhi's Banking System!\n";
+                cout << "💫 Have a great day ahead!\n\n";
+                exitSystem = true;
+                break;
+            default:
+                cout << "\n❌ Invalid choice! Please try again.\n";
+                pauseScreen();
+        }
+    }
+}
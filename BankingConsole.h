@@ -0,0 +1,39 @@
+#ifndef BANKINGCONSOLE_H
+#define BANKINGCONSOLE_H
+
+#include "BankSystem.h"
+
+// Interactive terminal front end. Every screen is a thin client of the
+// BankingSystem API; no account or ledger state lives here.
+class BankingConsole {
+private:
+    BankingSystem& bank;
+
+public:
+    explicit BankingConsole(BankingSystem& system);
+
+    // Menu screens
+    void createNewAccount();
+    void depositMoney();
+    void withdrawMoney();
+    void checkBalance();
+    void viewAccountDetails();
+    void transferMoney();
+    void viewTransactionHistory();
+    void deactivateAccount();
+    void generateAccountStatement();
+
+    // Utility functions
+    void displayMainMenu();
+    void clearScreen();
+    void pauseScreen();
+    bool authenticateUser(string& accountNo);
+    Money readAmount();
+    void displayHeader();
+    void displayFooter();
+
+    // Main System loop
+    void runBankingSystem();
+};
+
+#endif
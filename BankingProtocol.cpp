@@ -0,0 +1,93 @@
+#include "BankingProtocol.h"
+
+static uint64_t readLittleEndian(const char* bytes, int width) {
+    uint64_t value = 0;
+    for (int i = width - 1; i >= 0; i--) {
+        value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return value;
+}
+
+static void writeLittleEndian(string& out, uint64_t value, int width) {
+    for (int i = 0; i < width; i++) {
+        out += static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+FrameWriter::FrameWriter(string& buffer) : out(buffer), start(buffer.size()) {
+    out.append(FRAME_HEADER_BYTES, '\0');
+}
+
+void FrameWriter::put32(uint32_t value) {
+    writeLittleEndian(out, value, 4);
+}
+
+void FrameWriter::put64(uint64_t value) {
+    writeLittleEndian(out, value, 8);
+}
+
+// Longer strings are cut at 64K; no field in the protocol comes close
+void FrameWriter::putString(string_view value) {
+    size_t length = value.size() < 0xFFFF ? value.size() : 0xFFFF;
+    writeLittleEndian(out, length, 2);
+    out.append(value.data(), length);
+}
+
+void FrameWriter::finish() {
+    uint64_t length = out.size() - start - FRAME_HEADER_BYTES;
+    for (size_t i = 0; i < FRAME_HEADER_BYTES; i++) {
+        out[start + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+}
+
+FrameReader::FrameReader(const char* body, size_t length) : pos(body), end(body + length), valid(true) {}
+
+uint8_t FrameReader::get8() {
+    if (end - pos < 1) {
+        valid = false;
+        return 0;
+    }
+    return static_cast<uint8_t>(*pos++);
+}
+
+uint32_t FrameReader::get32() {
+    if (end - pos < 4) {
+        valid = false;
+        return 0;
+    }
+    uint32_t value = static_cast<uint32_t>(readLittleEndian(pos, 4));
+    pos += 4;
+    return value;
+}
+
+uint64_t FrameReader::get64() {
+    if (end - pos < 8) {
+        valid = false;
+        return 0;
+    }
+    uint64_t value = readLittleEndian(pos, 8);
+    pos += 8;
+    return value;
+}
+
+string_view FrameReader::getString() {
+    if (end - pos < 2) {
+        valid = false;
+        return string_view();
+    }
+    size_t length = static_cast<size_t>(readLittleEndian(pos, 2));
+    if (static_cast<size_t>(end - pos - 2) < length) {
+        valid = false;
+        return string_view();
+    }
+    string_view value(pos + 2, length);
+    pos += 2 + length;
+    return value;
+}
+
+bool peekFrameLength(const char* data, size_t available, uint32_t& length) {
+    if (available < FRAME_HEADER_BYTES) return false;
+    length = static_cast<uint32_t>(readLittleEndian(data, 4));
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef BANKINGPROTOCOL_H
+#define BANKINGPROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Wire format spoken by --serve and banking_loadgen.
+//
+// Every frame is a uint32 body length followed by the body; all integers
+// are little-endian and strings are a uint16 length followed by the bytes.
+//
+//   request:  u32 requestId | u8 opcode | fields below
+//   response: u32 requestId | u8 status (ErrorCode) | i64 balance | payload
+//
+// Every request except Create names an account and carries its password.
+// Responses come back in request order, so a client may send many
+// requests before reading any replies (pipelining).
+//
+//   Create      str name | str password | u8 type (0 Savings, 1 Current) | i64 deposit
+//               -> u64 accountId
+//   Deposit     u64 account | str password | i64 amount
+//   Withdraw    u64 account | str password | i64 amount
+//   Balance     u64 account | str password
+//   Transfer    u64 account | str password | u64 toAccount | i64 amount
+//   History     u64 account | str password | i64 fromTime | i64 toTime | u32 limit
+//               -> u32 count | count x (i64 time | u8 type | u64 counterparty |
+//                                       i64 amount | i64 balanceAfter)
+//   Statement   u64 account | str password -> str filename
+//   Deactivate  u64 account | str password
+//   Metrics     (no fields) -> str report (the text of Metrics::report())
+//   MultiTransfer u64 account | str password | str idempotencyKey | u32 count |
+//               count x (u64 toAccount | i64 amount)
+//               -> on a failed leg only: u64 toAccount of that leg
+//
+// Amounts and balances are whole paise; times are seconds since the epoch.
+// A History reply holds at most MAX_HISTORY_ROWS rows (the most recent).
+// A MultiTransfer is applied whole or not at all; resending it with the
+// same non-empty key returns the first reply without posting again.
+enum class Opcode : uint8_t {
+    Create = 1,
+    Deposit,
+    Withdraw,
+    Balance,
+    Transfer,
+    History,
+    Statement,
+    Deactivate,
+    Metrics,
+    MultiTransfer
+};
+
+// Larger frames are treated as a broken client and the connection closed
+const uint32_t MAX_FRAME_BYTES = 1 << 20;
+const size_t FRAME_HEADER_BYTES = 4;
+const size_t HISTORY_ROW_BYTES = 33;
+const size_t MAX_HISTORY_ROWS = (MAX_FRAME_BYTES - 64) / HISTORY_ROW_BYTES;
+
+// Appends one frame to a buffer; the length is filled in by finish()
+class FrameWriter {
+private:
+    string& out;
+    size_t start;
+
+public:
+    explicit FrameWriter(string& buffer);
+
+    void put8(uint8_t value) { out += static_cast<char>(value); }
+    void put32(uint32_t value);
+    void put64(uint64_t value);
+    void putString(string_view value);
+    void finish();
+};
+
+// Reads fields from one frame body. A read past the end returns zero and
+// marks the reader failed, so a handler checks ok() once at the end.
+class FrameReader {
+private:
+    const char* pos;
+    const char* end;
+    bool valid;
+
+public:
+    FrameReader(const char* body, size_t length);
+
+    uint8_t get8();
+    uint32_t get32();
+    uint64_t get64();
+    string_view getString();
+    bool ok() const { return valid; }
+    bool atEnd() const { return pos == end; }
+};
+
+// Body length of the frame at the front of data, or false if the header
+// itself is not complete yet
+bool peekFrameLength(const char* data, size_t available, uint32_t& length);
+
+#endif
@@ -0,0 +1,360 @@
+#include "BankingServer.h"
+
+// Built on epoll and Unix sockets, so Windows builds leave --serve out
+#ifndef _WIN32
+
+#include "Metrics.h"
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+BankingServer::BankingServer(BankingSystem& system)
+    : bank(&system), shardedBank(nullptr), listenFd(-1), stopping(false) {}
+
+BankingServer::BankingServer(ShardedBank& system)
+    : bank(nullptr), shardedBank(&system), listenFd(-1), stopping(false) {}
+
+BankingServer::~BankingServer() {
+    if (listenFd >= 0) close(listenFd);
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+}
+
+bool BankingServer::listenTcp(uint16_t port) {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    int on = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+           listen(listenFd, SOMAXCONN) == 0;
+}
+
+bool BankingServer::listenUnix(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+
+    // A socket file left by a server that did not shut down cleanly
+    unlink(path.c_str());
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return false;
+    unixPath = path;
+    return listen(listenFd, SOMAXCONN) == 0;
+}
+
+void BankingServer::run(unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    vector<thread> loops;
+    for (unsigned t = 1; t < threads; t++) {
+        loops.emplace_back(&BankingServer::runLoop, this);
+    }
+    runLoop();
+    for (auto& loop : loops) {
+        loop.join();
+    }
+}
+
+// Level-triggered: a connection is read while it has room for replies and
+// watched for writability only while replies are queued. A client that
+// half-closes its socket still gets every reply it asked for.
+void BankingServer::runLoop() {
+    const int MAX_EVENTS = 64;
+    const int POLL_MS = 200;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) return;
+
+    epoll_event listenEvent;
+    memset(&listenEvent, 0, sizeof(listenEvent));
+    listenEvent.events = EPOLLIN | EPOLLEXCLUSIVE;
+    listenEvent.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
+
+    // Replies to one read's worth of requests share a single log fsync
+    if (bank) bank->deferLogSync(true);
+    unordered_map<int, Connection> connections;
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, POLL_MS);
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                int client;
+                while ((client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    int on = 1;
+                    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    connections[client] = Connection{client, string(), 0, string(), 0, EPOLLIN, false};
+                    epoll_event clientEvent;
+                    memset(&clientEvent, 0, sizeof(clientEvent));
+                    clientEvent.events = EPOLLIN;
+                    clientEvent.data.fd = client;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &clientEvent);
+                }
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& conn = it->second;
+
+            bool open = !(events[i].events & EPOLLERR);
+            if (open && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                open = readInput(conn);
+            }
+            // Sending replies may free room for requests that were held back
+            while (open) {
+                size_t queued = conn.output.size();
+                open = handleFrames(conn);
+                // Replies whose changes did not reach the log are never sent
+                if (bank && conn.output.size() != queued && !bank->syncLog()) {
+                    conn.output.resize(queued);
+                    open = false;
+                }
+                open = open && writeOutput(conn);
+                if (conn.output.size() > conn.outputStart || !frameReady(conn)) break;
+            }
+
+            size_t pending = conn.output.size() - conn.outputStart;
+            uint32_t wanted = 0;
+            if (pending > 0) wanted |= EPOLLOUT;
+            if (!conn.peerClosed && pending < MAX_PENDING_OUTPUT) wanted |= EPOLLIN;
+            if (open && wanted == 0) open = false;
+            if (open && wanted != conn.events) {
+                epoll_event update;
+                memset(&update, 0, sizeof(update));
+                update.events = wanted;
+                update.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &update);
+                conn.events = wanted;
+            }
+            if (!open) {
+                close(fd);
+                connections.erase(it);
+            }
+        }
+    }
+
+    for (auto& entry : connections) {
+        close(entry.first);
+    }
+    close(epollFd);
+    if (bank) bank->deferLogSync(false);
+}
+
+bool BankingServer::frameReady(const Connection& conn) {
+    uint32_t length;
+    size_t available = conn.input.size() - conn.inputStart;
+    return peekFrameLength(conn.input.data() + conn.inputStart, available, length) &&
+           (length > MAX_FRAME_BYTES || available >= FRAME_HEADER_BYTES + length);
+}
+
+bool BankingServer::readInput(Connection& conn) {
+    const size_t READ_CHUNK = 64 * 1024;
+    if (conn.inputStart > 0 && conn.inputStart == conn.input.size()) {
+        conn.input.clear();
+        conn.inputStart = 0;
+    }
+    size_t used = conn.input.size();
+    conn.input.resize(used + READ_CHUNK);
+    ssize_t received = recv(conn.fd, &conn.input[used], READ_CHUNK, 0);
+    conn.input.resize(used + (received > 0 ? received : 0));
+
+    if (received == 0) {
+        conn.peerClosed = true;
+        return true;
+    }
+    return received > 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+bool BankingServer::writeOutput(Connection& conn) {
+    while (conn.outputStart < conn.output.size()) {
+        ssize_t sent = send(conn.fd, conn.output.data() + conn.outputStart,
+                            conn.output.size() - conn.outputStart, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conn.outputStart += sent;
+    }
+    conn.output.clear();
+    conn.outputStart = 0;
+    return true;
+}
+
+// Answers every complete frame in the input, in order. False closes the
+// connection (a frame larger than MAX_FRAME_BYTES).
+bool BankingServer::handleFrames(Connection& conn) {
+    while (conn.output.size() - conn.outputStart < MAX_PENDING_OUTPUT) {
+        const char* data = conn.input.data() + conn.inputStart;
+        size_t available = conn.input.size() - conn.inputStart;
+        uint32_t length;
+        if (!peekFrameLength(data, available, length)) break;
+        if (length > MAX_FRAME_BYTES) return false;
+        if (available < FRAME_HEADER_BYTES + length) break;
+
+        FrameReader request(data + FRAME_HEADER_BYTES, length);
+        if (bank) {
+            handleRequest(*bank, request, conn.output);
+        } else {
+            handleRequest(*shardedBank, request, conn.output);
+        }
+        conn.inputStart += FRAME_HEADER_BYTES + length;
+    }
+
+    // Keep a partial frame at the front of the buffer
+    if (conn.inputStart > 0 && conn.inputStart >= conn.input.size() / 2) {
+        conn.input.erase(0, conn.inputStart);
+        conn.inputStart = 0;
+    }
+    return true;
+}
+
+template <typename Bank>
+void BankingServer::handleRequest(Bank& target, FrameReader& request, string& output) {
+    uint32_t requestId = request.get32();
+    Opcode op = static_cast<Opcode>(request.get8());
+    Result result(ErrorCode::BadRequest);
+    AccountId created = NO_ACCOUNT;
+    AccountId failedLeg = NO_ACCOUNT;
+    vector<Transaction> history;
+    string filename;
+    string report;
+
+    if (op == Opcode::Create) {
+        string name(request.getString());
+        string password(request.getString());
+        uint8_t type = request.get8();
+        Money deposit = Money::fromPaise(static_cast<int64_t>(request.get64()));
+        if (request.ok() && request.atEnd() && type <= 1) {
+            result = target.openAccount(name, password, type ? "Current" : "Savings", deposit);
+            created = parseAccountId(result.accountNo);
+        }
+    } else if (op == Opcode::Metrics) {
+        if (request.ok() && request.atEnd()) {
+            result = Result(ErrorCode::Success);
+            report = Metrics::report();
+        }
+    } else {
+        string accountNo = formatAccountId(request.get64());
+        string password(request.getString());
+        Money amount;
+        string toAccount;
+        string idempotencyKey;
+        vector<TransferLeg> legs;
+        uint32_t count = 0;
+        time_t fromTime = 0;
+        time_t toTime = 0;
+        size_t limit = 0;
+        bool known = true;
+        switch (op) {
+            case Opcode::Deposit:
+            case Opcode::Withdraw:
+                amount = Money::fromPaise(static_cast<int64_t>(request.get64()));
+                break;
+            case Opcode::Transfer:
+                toAccount = formatAccountId(request.get64());
+                amount = Money::fromPaise(static_cast<int64_t>(request.get64()));
+                break;
+            case Opcode::MultiTransfer:
+                idempotencyKey = string(request.getString());
+                count = request.get32();
+                // Each leg takes 16 bytes, so a larger count cannot fit in a frame
+                if (count > MAX_FRAME_BYTES / 16) {
+                    known = false;
+                    break;
+                }
+                legs.resize(count);
+                for (auto& leg : legs) {
+                    if (!request.ok()) break;
+                    leg.toAccount = request.get64();
+                    leg.amount = Money::fromPaise(static_cast<int64_t>(request.get64()));
+                }
+                break;
+            case Opcode::History:
+                fromTime = static_cast<time_t>(request.get64());
+                toTime = static_cast<time_t>(request.get64());
+                limit = request.get32();
+                if (limit == 0 || limit > MAX_HISTORY_ROWS) limit = MAX_HISTORY_ROWS;
+                break;
+            case Opcode::Balance:
+            case Opcode::Statement:
+            case Opcode::Deactivate:
+                break;
+            default:
+                known = false;
+        }
+
+        if (known && request.ok() && request.atEnd()) {
+            result = target.authenticate(accountNo, password);
+        }
+        if (result.ok()) {
+            switch (op) {
+                case Opcode::Deposit: result = target.deposit(accountNo, amount); break;
+                case Opcode::Withdraw: result = target.withdraw(accountNo, amount); break;
+                case Opcode::Transfer: result = target.transfer(accountNo, toAccount, amount); break;
+                case Opcode::MultiTransfer: result = target.transferToMany(accountNo, legs, idempotencyKey); break;
+                case Opcode::History:
+                    result.code = target.getTransactionHistory(accountNo, history, fromTime, toTime, limit).code;
+                    break;
+                case Opcode::Statement: result.code = target.writeAccountStatement(accountNo, filename).code; break;
+                case Opcode::Deactivate: result = target.deactivate(accountNo); break;
+                default: break;
+            }
+        }
+        // The failed leg's ID as sent, which need not parse as a valid number
+        if (op == Opcode::MultiTransfer && !result.accountNo.empty()) {
+            for (const auto& leg : legs) {
+                if (formatAccountId(leg.toAccount) == result.accountNo) {
+                    failedLeg = leg.toAccount;
+                    break;
+                }
+            }
+        }
+    }
+
+    FrameWriter reply(output);
+    reply.put32(requestId);
+    reply.put8(static_cast<uint8_t>(result.code));
+    reply.put64(static_cast<uint64_t>(result.balance.toPaise()));
+    if (result.ok()) {
+        if (op == Opcode::Create) {
+            reply.put64(created);
+        } else if (op == Opcode::History) {
+            reply.put32(static_cast<uint32_t>(history.size()));
+            for (const auto& trans : history) {
+                reply.put64(static_cast<uint64_t>(trans.timestamp));
+                reply.put8(static_cast<uint8_t>(trans.type));
+                reply.put64(trans.counterparty);
+                reply.put64(static_cast<uint64_t>(trans.amount.toPaise()));
+                reply.put64(static_cast<uint64_t>(trans.balanceAfter.toPaise()));
+            }
+        } else if (op == Opcode::Statement) {
+            reply.putString(filename);
+        } else if (op == Opcode::Metrics) {
+            reply.putString(report);
+        }
+    } else if (op == Opcode::MultiTransfer && !result.accountNo.empty()) {
+        reply.put64(failedLeg);
+    }
+    reply.finish();
+}
+
+#endif
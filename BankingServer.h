@@ -0,0 +1,62 @@
+#ifndef BANKINGSERVER_H
+#define BANKINGSERVER_H
+
+#include "BankSystem.h"
+#include "BankingProtocol.h"
+#include "ShardedBank.h"
+#include <atomic>
+
+// Local network front end for --serve. Speaks the frame protocol in
+// BankingProtocol.h over TCP (loopback) or a Unix socket. Each event loop
+// thread owns an epoll set and its connections; the listening socket is
+// shared between the loops, which take turns accepting. Like the console,
+// it is a thin client of the BankingSystem API, or of a ShardedBank's,
+// whose workers sync each shard's log themselves.
+class BankingServer {
+private:
+    // Stop reading from a connection whose replies are not being drained
+    static const size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;
+
+    struct Connection {
+        int fd;
+        string input;
+        size_t inputStart;
+        string output;
+        size_t outputStart;
+        uint32_t events;
+        bool peerClosed;
+    };
+
+    // Exactly one is set
+    BankingSystem* bank;
+    ShardedBank* shardedBank;
+    int listenFd;
+    string unixPath;
+    atomic<bool> stopping;
+
+    void runLoop();
+    static bool frameReady(const Connection& conn);
+    bool readInput(Connection& conn);
+    bool writeOutput(Connection& conn);
+    bool handleFrames(Connection& conn);
+    template <typename Bank>
+    void handleRequest(Bank& target, FrameReader& request, string& output);
+
+public:
+    explicit BankingServer(BankingSystem& system);
+    explicit BankingServer(ShardedBank& system);
+    ~BankingServer();
+    BankingServer(const BankingServer&) = delete;
+    BankingServer& operator=(const BankingServer&) = delete;
+
+    // Binds 127.0.0.1:port; false with errno set on failure
+    bool listenTcp(uint16_t port);
+    bool listenUnix(const string& path);
+
+    // Serves until stop() is called; threads = 0 uses every core
+    void run(unsigned threads);
+    // Safe to call from a signal handler
+    void stop() { stopping = true; }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "BatchIngest.h"
+
+BatchIngestor::BatchIngestor(BankingSystem& system, size_t rowsPerBatch)
+    : bank(system), batchSize(rowsPerBatch ? rowsPerBatch : 1) {}
+
+// Splits on commas in place; no stringstream per row. A row with more or
+// fewer fields than its operation takes is refused whole, since shifted
+// columns would otherwise be half applied.
+bool BatchIngestor::parseLine(const string& line, BatchOperation& op) {
+    size_t fields[4];
+    size_t lengths[4];
+    size_t count = 0;
+    size_t start = 0;
+    for (;;) {
+        if (count == 4) return false;
+        size_t comma = line.find(',', start);
+        size_t end = (comma == string::npos) ? line.size() : comma;
+        fields[count] = start;
+        lengths[count] = end - start;
+        count++;
+        if (comma == string::npos) break;
+        start = comma + 1;
+    }
+    if (count < 3) return false;
+
+    string type = line.substr(fields[0], lengths[0]);
+    if (type == "deposit" && count == 3) {
+        op.type = BatchOperationType::Deposit;
+    } else if ((type == "withdraw" || type == "withdrawal") && count == 3) {
+        op.type = BatchOperationType::Withdraw;
+    } else if (type == "transfer" && count == 4) {
+        op.type = BatchOperationType::Transfer;
+        op.toAccount = parseAccountId(string_view(line).substr(fields[3], lengths[3]));
+    } else {
+        return false;
+    }
+
+    // Unknown or malformed account numbers are reported by applyBatch
+    op.accountId = parseAccountId(string_view(line).substr(fields[1], lengths[1]));
+    const char* amount = line.data() + fields[2];
+    return Money::parse(amount, amount + lengths[2], op.amount);
+}
+
+IngestSummary BatchIngestor::ingestFile(const string& path, ostream& rejects) {
+    IngestSummary summary = {0, 0, 0, 0.0};
+    ifstream file(path);
+    if (!file) {
+        rejects << "cannot open " << path << "\n";
+        return summary;
+    }
+
+    vector<BatchOperation> batch;
+    vector<size_t> lineNumbers;
+    vector<string> rawLines;
+    vector<Result> results;
+    batch.reserve(batchSize);
+    lineNumbers.reserve(batchSize);
+    rawLines.reserve(batchSize);
+
+    auto flush = [&]() {
+        bank.applyBatch(batch, results);
+        for (size_t i = 0; i < results.size(); i++) {
+            if (results[i].ok()) {
+                summary.applied++;
+            } else {
+                summary.rejected++;
+                rejects << "line " << lineNumbers[i] << ": " << errorMessage(results[i].code)
+                        << ": " << rawLines[i] << "\n";
+            }
+        }
+        batch.clear();
+        lineNumbers.clear();
+        rawLines.clear();
+    };
+
+    auto start = chrono::steady_clock::now();
+    string line;
+    size_t lineNumber = 0;
+    BatchOperation op;
+    while (getline(file, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#' || line.compare(0, 5, "type,") == 0) continue;
+
+        summary.rows++;
+        if (!parseLine(line, op)) {
+            summary.rejected++;
+            rejects << "line " << lineNumber << ": Malformed row: " << line << "\n";
+            continue;
+        }
+        batch.push_back(op);
+        lineNumbers.push_back(lineNumber);
+        rawLines.push_back(line);
+        if (batch.size() >= batchSize) flush();
+    }
+    if (!batch.empty()) flush();
+
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return summary;
+}
@@ -0,0 +1,37 @@
+#ifndef BATCHINGEST_H
+#define BATCHINGEST_H
+
+#include "BankSystem.h"
+
+// Totals for one settlement file
+struct IngestSummary {
+    size_t rows;
+    size_t applied;
+    size_t rejected;
+    double seconds;
+};
+
+// Reads an end-of-day settlement file and posts it through
+// BankingSystem::applyBatch. One operation per line:
+//
+//   deposit,RC123456,2500.00
+//   withdraw,RC123456,100
+//   transfer,RC123456,750.50,RC654321
+//
+// Blank lines, '#' comments and a "type,..." header line are skipped. A
+// row with more or fewer fields than its operation takes is rejected.
+class BatchIngestor {
+private:
+    BankingSystem& bank;
+    size_t batchSize;
+
+public:
+    BatchIngestor(BankingSystem& system, size_t rowsPerBatch = 8192);
+
+    // Rejected rows are written to rejects as "line N: reason: row"
+    IngestSummary ingestFile(const string& path, ostream& rejects);
+
+    static bool parseLine(const string& line, BatchOperation& op);
+};
+
+#endif
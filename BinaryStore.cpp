@@ -0,0 +1,201 @@
+#include "BinaryStore.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <io.h>
+    #define fsync _commit
+    #define fileno _fileno
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+static size_t alignTo8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// FNV-1a style mix over 64-bit words, with the tail folded in bytewise
+uint64_t dataChecksum(const char* bytes, size_t length, uint64_t seed) {
+    const uint64_t PRIME = 1099511628211ULL;
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 29;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * PRIME;
+    }
+    return hash;
+}
+
+bool syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+    return fsync(fileno(file)) == 0;
+}
+
+// MappedFile implementation
+MappedFile::MappedFile() : data(nullptr), length(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const string& path) {
+    close();
+#ifdef _WIN32
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) return false;
+    fallback.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(fallback.data(), fallback.size());
+    data = fallback.data();
+    length = fallback.size();
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (data && length > 0) {
+        munmap(const_cast<char*>(data), length);
+    }
+#endif
+    fallback.clear();
+    data = nullptr;
+    length = 0;
+}
+
+// DataFileReader implementation
+DataFileReader::DataFileReader() : totalRecords(0), fileVersion(0), fileRecordSize(0) {}
+
+bool DataFileReader::open(const string& path, const char* magic) {
+    blockList.clear();
+    totalRecords = 0;
+    fileVersion = 0;
+    fileRecordSize = 0;
+
+    if (!file.open(path)) return false;
+
+    const char* base = file.begin();
+    size_t size = file.size();
+    if (size < sizeof(DataFileHeader)) {
+        throw runtime_error("Corrupt data file header: " + path);
+    }
+
+    DataFileHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a banking data file: " + path);
+    }
+    if (header.version < 1 || header.version > DATA_FORMAT_VERSION ||
+        header.recordSize == 0 || header.recordSize % 8 != 0) {
+        throw runtime_error("Unsupported data file version: " + path);
+    }
+    fileVersion = header.version;
+    fileRecordSize = header.recordSize;
+    size_t recordSize = header.recordSize;
+
+    size_t offset = sizeof(DataFileHeader);
+    while (offset + sizeof(DataBlockHeader) <= size) {
+        DataBlockHeader block;
+        memcpy(&block, base + offset, sizeof(block));
+
+        size_t recordBytes = block.recordCount * recordSize;
+        size_t payload = recordBytes + alignTo8(block.heapSize);
+        size_t start = offset + sizeof(DataBlockHeader);
+        if (block.recordCount > size / recordSize || block.heapSize > size) break;
+        if (payload > size - start) break;
+        uint64_t checksum = dataChecksum(base + start, recordBytes + block.heapSize,
+                                         CHECKSUM_BASIS ^ block.recordCount);
+        if (checksum != block.checksum) break;
+
+        Block view;
+        view.records = base + start;
+        view.count = block.recordCount;
+        view.heap = base + start + recordBytes;
+        view.heapSize = block.heapSize;
+        blockList.push_back(view);
+
+        totalRecords += block.recordCount;
+        offset = start + payload;
+    }
+    return true;
+}
+
+// DataBlockWriter implementation
+DataBlockWriter::DataBlockWriter() : count(0) {}
+
+void DataBlockWriter::reserve(size_t recordCount, size_t recordSize, size_t heapBytes) {
+    records.reserve(recordCount * recordSize);
+    heap.reserve(heapBytes);
+}
+
+StringRef DataBlockWriter::addString(string_view value) {
+    StringRef ref;
+    ref.offset = static_cast<uint32_t>(heap.size());
+    ref.length = static_cast<uint32_t>(value.size());
+    heap += value;
+    return ref;
+}
+
+void DataBlockWriter::addRecord(const void* record, size_t recordSize) {
+    const char* bytes = static_cast<const char*>(record);
+    records.insert(records.end(), bytes, bytes + recordSize);
+    count++;
+}
+
+bool DataBlockWriter::writeTo(FILE* file, const char* magic, uint32_t recordSize) const {
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        DataFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = DATA_FORMAT_VERSION;
+        header.recordSize = recordSize;
+        if (fwrite(&header, sizeof(header), 1, file) != 1) return false;
+    }
+
+    // Record sizes are multiples of 8, so chaining matches the reader's
+    // single pass over records and heap
+    DataBlockHeader block;
+    block.recordCount = count;
+    block.heapSize = heap.size();
+    block.checksum = dataChecksum(records.data(), records.size(), CHECKSUM_BASIS ^ count);
+    block.checksum = dataChecksum(heap.data(), heap.size(), block.checksum);
+
+    static const char padding[8] = {0};
+    size_t padBytes = alignTo8(heap.size()) - heap.size();
+    return fwrite(&block, sizeof(block), 1, file) == 1 &&
+           fwrite(records.data(), 1, records.size(), file) == records.size() &&
+           fwrite(heap.data(), 1, heap.size(), file) == heap.size() &&
+           fwrite(padding, 1, padBytes, file) == padBytes;
+}
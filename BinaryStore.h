@@ -0,0 +1,165 @@
+#ifndef BINARYSTORE_H
+#define BINARYSTORE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Binary layout shared by accounts.bin and transactions.bin:
+//
+//   DataFileHeader
+//   DataBlockHeader | recordCount fixed-width records | string heap
+//   DataBlockHeader | ...
+//
+// Every block carries its own checksum, so a torn or damaged block is
+// detected and reading stops before it. The account table is always rewritten as a single block.
+// All sections are padded to 8 bytes so records can be read in place.
+
+// Version 1 stored amounts as doubles (rupees); version 2 stores them as
+// int64 paise in the same 8 bytes. Version 3 replaces the account number
+// string with the numeric account ID, again in the same 8 bytes. Version 4
+// makes ledger rows fixed-width (type code, counterparty, epoch time) with
+// no string heap. Version 5 splits the ledger row's type word into the
+// type code and a cross-shard transfer ID, which version 4 files hold as
+// zero. Readers accept every version.
+const uint32_t DATA_FORMAT_VERSION = 5;
+
+struct DataFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct DataBlockHeader {
+    uint64_t recordCount;
+    uint64_t heapSize;
+    uint64_t checksum;
+};
+
+// Location of a string inside the owning block's heap
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct AccountRecord {
+    uint64_t accountId;
+    StringRef holderName;
+    StringRef password;
+    StringRef accountType;
+    StringRef creationDate;
+    int64_t balance;
+    uint64_t active;
+};
+
+struct TransactionRecord {
+    uint64_t accountId;
+    uint64_t counterparty;
+    int64_t timestamp;
+    int64_t amount;
+    int64_t balanceAfter;
+    uint32_t type;
+    uint32_t transferId;
+};
+
+// Ledger rows as written by versions 1 to 3
+struct LegacyTransactionRecord {
+    uint64_t accountId;
+    StringRef type;
+    StringRef date;
+    int64_t amount;
+    int64_t balanceAfter;
+};
+
+// Read-only view of a whole file (mmap where available)
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+    vector<char> fallback;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& path);
+    void close();
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+};
+
+// Validates a data file and exposes its blocks without copying them
+class DataFileReader {
+public:
+    struct Block {
+        const char* records;
+        size_t count;
+        const char* heap;
+        size_t heapSize;
+    };
+
+private:
+    MappedFile file;
+    vector<Block> blockList;
+    size_t totalRecords;
+    uint32_t fileVersion;
+    uint32_t fileRecordSize;
+
+public:
+    DataFileReader();
+
+    // False if the file is missing; throws runtime_error if it is not a
+    // readable data file of the expected kind. Record sizes differ between
+    // versions, so callers check recordSize() against version().
+    bool open(const string& path, const char* magic);
+
+    const vector<Block>& blocks() const { return blockList; }
+    size_t recordCount() const { return totalRecords; }
+    uint32_t version() const { return fileVersion; }
+    uint32_t recordSize() const { return fileRecordSize; }
+    // Start of the mapped file; valid while the reader stays open
+    const char* data() const { return file.begin(); }
+
+    static string getString(const Block& block, StringRef ref) {
+        return string(block.heap + ref.offset, ref.length);
+    }
+    // Valid only while the reader stays open
+    static string_view getView(const Block& block, StringRef ref) {
+        return string_view(block.heap + ref.offset, ref.length);
+    }
+};
+
+// Accumulates one block's records and heap before it is written out
+class DataBlockWriter {
+private:
+    vector<char> records;
+    string heap;
+    size_t count;
+
+public:
+    DataBlockWriter();
+
+    void reserve(size_t recordCount, size_t recordSize, size_t heapBytes);
+    StringRef addString(string_view value);
+    void addRecord(const void* record, size_t recordSize);
+    size_t recordCount() const { return count; }
+
+    // Writes the file header first when the file is empty
+    bool writeTo(FILE* file, const char* magic, uint32_t recordSize) const;
+};
+
+// Flushes stdio buffers and forces the file contents to disk
+bool syncFile(FILE* file);
+
+// Word-at-a-time checksum; runs whose length is a multiple of 8 can be
+// chained by passing the previous result as the seed
+const uint64_t CHECKSUM_BASIS = 14695981039346656037ULL;
+uint64_t dataChecksum(const char* bytes, size_t length, uint64_t seed);
+
+#endif
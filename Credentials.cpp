@@ -0,0 +1,451 @@
+#include "Credentials.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <random>
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotateRight(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t rotateLeft(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t loadLittleEndian(const uint8_t* bytes) {
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static inline void storeLittleEndian(uint8_t* bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+Sha256::Sha256()
+    : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      used(0), length(0) {}
+
+void Sha256::compress(const uint8_t* data) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(data[4 * i]) << 24) | (static_cast<uint32_t>(data[4 * i + 1]) << 16) |
+               (static_cast<uint32_t>(data[4 * i + 2]) << 8) | static_cast<uint32_t>(data[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        uint32_t choose = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choose + SHA256_K[i] + w[i];
+        uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t size) {
+    length += size;
+    while (size > 0) {
+        size_t take = min(size, sizeof(block) - used);
+        memcpy(block + used, data, take);
+        used += take;
+        data += take;
+        size -= take;
+        if (used == sizeof(block)) {
+            compress(block);
+            used = 0;
+        }
+    }
+}
+
+Digest Sha256::finish() {
+    uint64_t bits = length * 8;
+    uint8_t pad = 0x80;
+    update(&pad, 1);
+    pad = 0;
+    while (used != 56) {
+        update(&pad, 1);
+    }
+    uint8_t lengthBytes[8];
+    for (int i = 0; i < 8; i++) {
+        lengthBytes[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    update(lengthBytes, 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) {
+            digest[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
+        }
+    }
+    return digest;
+}
+
+Digest sha256(string_view data) {
+    Sha256 hash;
+    hash.update(data);
+    return hash.finish();
+}
+
+// HMAC (RFC 2104) with its inner and outer hashes keyed once, so PBKDF2
+// can reuse them for every output block
+class HmacSha256 {
+private:
+    Sha256 inner;
+    Sha256 outer;
+
+public:
+    explicit HmacSha256(string_view key) {
+        uint8_t padded[64] = {};
+        if (key.size() > sizeof(padded)) {
+            Digest shortened = sha256(key);
+            memcpy(padded, shortened.data(), shortened.size());
+        } else {
+            memcpy(padded, key.data(), key.size());
+        }
+        uint8_t innerPad[64], outerPad[64];
+        for (size_t i = 0; i < sizeof(padded); i++) {
+            innerPad[i] = padded[i] ^ 0x36;
+            outerPad[i] = padded[i] ^ 0x5c;
+        }
+        inner.update(innerPad, sizeof(innerPad));
+        outer.update(outerPad, sizeof(outerPad));
+    }
+
+    // Keyed copy of the inner hash; feed it the message and pass it to finish()
+    Sha256 start() const { return inner; }
+
+    Digest finish(Sha256 message) const {
+        Digest innerDigest = message.finish();
+        Sha256 result = outer;
+        result.update(innerDigest.data(), innerDigest.size());
+        return result.finish();
+    }
+};
+
+// PBKDF2-HMAC-SHA256 with one iteration, the only count scrypt uses
+static void pbkdf2Sha256(string_view password, const uint8_t* salt, size_t saltSize,
+                         uint8_t* output, size_t outputSize) {
+    HmacSha256 hmac(password);
+    Sha256 salted = hmac.start();
+    salted.update(salt, saltSize);
+    for (uint32_t blockIndex = 1; outputSize > 0; blockIndex++) {
+        uint8_t counter[4] = {static_cast<uint8_t>(blockIndex >> 24), static_cast<uint8_t>(blockIndex >> 16),
+                              static_cast<uint8_t>(blockIndex >> 8), static_cast<uint8_t>(blockIndex)};
+        Sha256 message = salted;
+        message.update(counter, sizeof(counter));
+        Digest block = hmac.finish(message);
+        size_t take = min(outputSize, block.size());
+        memcpy(output, block.data(), take);
+        output += take;
+        outputSize -= take;
+    }
+}
+
+static void salsa20_8(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    for (int round = 0; round < 8; round += 2) {
+        // Columns
+        x[4] ^= rotateLeft(x[0] + x[12], 7);
+        x[8] ^= rotateLeft(x[4] + x[0], 9);
+        x[12] ^= rotateLeft(x[8] + x[4], 13);
+        x[0] ^= rotateLeft(x[12] + x[8], 18);
+        x[9] ^= rotateLeft(x[5] + x[1], 7);
+        x[13] ^= rotateLeft(x[9] + x[5], 9);
+        x[1] ^= rotateLeft(x[13] + x[9], 13);
+        x[5] ^= rotateLeft(x[1] + x[13], 18);
+        x[14] ^= rotateLeft(x[10] + x[6], 7);
+        x[2] ^= rotateLeft(x[14] + x[10], 9);
+        x[6] ^= rotateLeft(x[2] + x[14], 13);
+        x[10] ^= rotateLeft(x[6] + x[2], 18);
+        x[3] ^= rotateLeft(x[15] + x[11], 7);
+        x[7] ^= rotateLeft(x[3] + x[15], 9);
+        x[11] ^= rotateLeft(x[7] + x[3], 13);
+        x[15] ^= rotateLeft(x[11] + x[7], 18);
+        // Rows
+        x[1] ^= rotateLeft(x[0] + x[3], 7);
+        x[2] ^= rotateLeft(x[1] + x[0], 9);
+        x[3] ^= rotateLeft(x[2] + x[1], 13);
+        x[0] ^= rotateLeft(x[3] + x[2], 18);
+        x[6] ^= rotateLeft(x[5] + x[4], 7);
+        x[7] ^= rotateLeft(x[6] + x[5], 9);
+        x[4] ^= rotateLeft(x[7] + x[6], 13);
+        x[5] ^= rotateLeft(x[4] + x[7], 18);
+        x[11] ^= rotateLeft(x[10] + x[9], 7);
+        x[8] ^= rotateLeft(x[11] + x[10], 9);
+        x[9] ^= rotateLeft(x[8] + x[11], 13);
+        x[10] ^= rotateLeft(x[9] + x[8], 18);
+        x[12] ^= rotateLeft(x[15] + x[14], 7);
+        x[13] ^= rotateLeft(x[12] + x[15], 9);
+        x[14] ^= rotateLeft(x[13] + x[12], 13);
+        x[15] ^= rotateLeft(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+// scryptBlockMix: in and out are 2r 64-byte blocks; the even-numbered
+// results go to the first half of out and the odd-numbered to the second
+static void blockMix(const uint32_t* in, uint32_t* out, int r) {
+    uint32_t x[16];
+    memcpy(x, in + (2 * r - 1) * 16, sizeof(x));
+    for (int i = 0; i < 2 * r; i++) {
+        for (int j = 0; j < 16; j++) {
+            x[j] ^= in[i * 16 + j];
+        }
+        salsa20_8(x);
+        memcpy(out + ((i / 2) + (i & 1) * r) * 16, x, sizeof(x));
+    }
+}
+
+// scryptROMix over one 128r-byte block, in place. The N-entry table is the
+// memory-hard part; each thread keeps its buffer between calls.
+static void roMix(uint8_t* block, int r, uint64_t n) {
+    thread_local vector<uint32_t> table;
+    size_t words = 32 * static_cast<size_t>(r);
+    table.resize(words * (n + 2));
+    uint32_t* x = table.data() + words * n;
+    uint32_t* y = x + words;
+
+    for (size_t i = 0; i < words; i++) {
+        x[i] = loadLittleEndian(block + 4 * i);
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        memcpy(table.data() + words * i, x, words * sizeof(uint32_t));
+        blockMix(x, y, r);
+        swap(x, y);
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t j = x[(2 * r - 1) * 16] & (n - 1);
+        const uint32_t* v = table.data() + words * j;
+        for (size_t k = 0; k < words; k++) {
+            x[k] ^= v[k];
+        }
+        blockMix(x, y, r);
+        swap(x, y);
+    }
+    for (size_t i = 0; i < words; i++) {
+        storeLittleEndian(block + 4 * i, x[i]);
+    }
+}
+
+bool scrypt(string_view password, string_view salt, int logN, int r, int p, vector<uint8_t>& output) {
+    // Up to 1 GiB for the table; anything above is a corrupt parameter
+    if (logN < 1 || logN > 24 || r < 1 || p < 1 || r > 64 || p > 64 || output.empty()) return false;
+    uint64_t n = uint64_t(1) << logN;
+    if (n * 128 * static_cast<uint64_t>(r) > (uint64_t(1) << 30)) return false;
+
+    size_t blockSize = 128 * static_cast<size_t>(r);
+    vector<uint8_t> blocks(blockSize * p);
+    pbkdf2Sha256(password, reinterpret_cast<const uint8_t*>(salt.data()), salt.size(), blocks.data(), blocks.size());
+    for (int i = 0; i < p; i++) {
+        roMix(blocks.data() + blockSize * i, r, n);
+    }
+    pbkdf2Sha256(password, blocks.data(), blocks.size(), output.data(), output.size());
+    return true;
+}
+
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Standard alphabet, no padding
+static string encodeBase64(const uint8_t* data, size_t size) {
+    string text;
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < size) group |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < size) group |= data[i + 2];
+        size_t chars = min<size_t>(4, (size - i) * 8 / 6 + 1);
+        for (size_t c = 0; c < chars; c++) {
+            text += BASE64_ALPHABET[(group >> (18 - 6 * c)) & 0x3F];
+        }
+    }
+    return text;
+}
+
+static bool decodeBase64(string_view text, string& data) {
+    data.clear();
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        const char* found = strchr(BASE64_ALPHABET, c);
+        if (c == '\0' || !found) return false;
+        bits = (bits << 6) | static_cast<uint32_t>(found - BASE64_ALPHABET);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            data += static_cast<char>((bits >> count) & 0xFF);
+        }
+    }
+    return true;
+}
+
+static const char HASH_PREFIX[] = "$scrypt$";
+
+bool isPasswordHash(string_view stored) {
+    return stored.compare(0, sizeof(HASH_PREFIX) - 1, HASH_PREFIX) == 0;
+}
+
+static atomic<int> workFactor(PASSWORD_HASH_LOG_N);
+
+void setPasswordWorkFactor(int logN) {
+    if (logN >= 10 && logN <= 20) workFactor = logN;
+}
+
+int passwordWorkFactor() {
+    return workFactor;
+}
+
+string hashPassword(string_view password) {
+    const size_t SALT_BYTES = 16;
+    random_device random;
+    uint8_t salt[SALT_BYTES];
+    for (size_t i = 0; i < SALT_BYTES; i += 4) {
+        storeLittleEndian(salt + i, random());
+    }
+
+    int logN = workFactor;
+    vector<uint8_t> hash(32);
+    scrypt(password, string_view(reinterpret_cast<const char*>(salt), SALT_BYTES),
+           logN, PASSWORD_HASH_R, PASSWORD_HASH_P, hash);
+    return string(HASH_PREFIX) + "ln=" + to_string(logN) + ",r=" + to_string(PASSWORD_HASH_R) +
+           ",p=" + to_string(PASSWORD_HASH_P) + "$" + encodeBase64(salt, SALT_BYTES) + "$" +
+           encodeBase64(hash.data(), hash.size());
+}
+
+// Reads "name=<number>" from the front of text and moves past it
+static bool takeParameter(string_view& text, string_view name, int& value) {
+    if (text.compare(0, name.size(), name) != 0) return false;
+    const char* first = text.data() + name.size();
+    auto parsed = from_chars(first, text.data() + text.size(), value);
+    if (parsed.ec != errc()) return false;
+    text.remove_prefix(parsed.ptr - text.data());
+    return true;
+}
+
+bool verifyPassword(string_view password, string_view stored) {
+    if (!isPasswordHash(stored)) return constantTimeEquals(password, stored);
+
+    string_view text = stored.substr(sizeof(HASH_PREFIX) - 1);
+    int logN, r, p;
+    if (!takeParameter(text, "ln=", logN) || !takeParameter(text, ",r=", r) ||
+        !takeParameter(text, ",p=", p) || text.empty() || text[0] != '$') {
+        return false;
+    }
+    text.remove_prefix(1);
+    size_t separator = text.find('$');
+    string salt, expected;
+    if (separator == string_view::npos || !decodeBase64(text.substr(0, separator), salt) ||
+        !decodeBase64(text.substr(separator + 1), expected) || expected.empty()) {
+        return false;
+    }
+
+    vector<uint8_t> hash(expected.size());
+    if (!scrypt(password, salt, logN, r, p, hash)) return false;
+    return constantTimeEquals(string_view(reinterpret_cast<const char*>(hash.data()), hash.size()), expected);
+}
+
+// Only the lengths can leak, and every stored hash has the same length
+bool constantTimeEquals(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    uint8_t difference = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        difference |= static_cast<uint8_t>(a[i] ^ b[i]);
+    }
+    return difference == 0;
+}
+
+SessionCache::SessionCache(unsigned ttlSeconds) : entries(SLOTS), ttl(ttlSeconds) {
+    random_device random;
+    uint8_t key[64];
+    for (size_t i = 0; i < sizeof(key); i += 4) {
+        storeLittleEndian(key + i, random());
+    }
+    keyed.update(key, sizeof(key));
+    clear();
+}
+
+size_t SessionCache::slotOf(AccountId account) const {
+    return static_cast<size_t>((account * 0x9E3779B97F4A7C15ULL) >> 48) & (SLOTS - 1);
+}
+
+// Keyed with a per-process secret, so the cache never holds anything an
+// attacker could test passwords against offline. Digests are only compared
+// with each other, so a secret prefix is enough and costs one compression.
+Digest SessionCache::digestOf(AccountId account, string_view password) const {
+    uint8_t id[8];
+    storeLittleEndian(id, static_cast<uint32_t>(account));
+    storeLittleEndian(id + 4, static_cast<uint32_t>(account >> 32));
+    Sha256 hash = keyed;
+    hash.update(id, sizeof(id));
+    hash.update(password);
+    return hash.finish();
+}
+
+void SessionCache::setTtl(unsigned ttlSeconds) {
+    ttl = ttlSeconds;
+    if (ttlSeconds == 0) clear();
+}
+
+bool SessionCache::check(AccountId account, string_view password) {
+    if (ttl.load() == 0) return false;
+    Digest digest = digestOf(account, password);
+    size_t slot = slotOf(account);
+    lock_guard<mutex> lock(stripes[slot % STRIPES].lock);
+    const Entry& entry = entries[slot];
+    if (entry.account != account || chrono::steady_clock::now() >= entry.expires) return false;
+    return constantTimeEquals(string_view(reinterpret_cast<const char*>(entry.digest.data()), entry.digest.size()),
+                              string_view(reinterpret_cast<const char*>(digest.data()), digest.size()));
+}
+
+void SessionCache::remember(AccountId account, string_view password) {
+    unsigned seconds = ttl.load();
+    if (seconds == 0) return;
+    Digest digest = digestOf(account, password);
+    size_t slot = slotOf(account);
+    lock_guard<mutex> lock(stripes[slot % STRIPES].lock);
+    entries[slot] = Entry{account, digest, chrono::steady_clock::now() + chrono::seconds(seconds)};
+}
+
+void SessionCache::clear() {
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+        lock_guard<mutex> lock(stripes[slot % STRIPES].lock);
+        entries[slot].account = NO_ACCOUNT;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AccountId.h"
+
+using namespace std;
+
+// Password storage. A stored credential is an scrypt (RFC 7914) hash with
+// a random 16-byte salt, encoded with its parameters so they can be raised
+// later without touching existing accounts:
+//
+//   $scrypt$ln=14,r=8,p=1$<salt, base64>$<32-byte hash, base64>
+//
+// Data files written before hashing hold the password itself; those still
+// verify (in constant time for equal lengths) and are replaced with a hash
+// at the account's next successful login.
+const int PASSWORD_HASH_LOG_N = 14;
+const int PASSWORD_HASH_R = 8;
+const int PASSWORD_HASH_P = 1;
+
+// scrypt cost (N = 2^logN) for hashes made from now on; existing hashes
+// keep the cost they were made with. Values outside 10..20 are ignored.
+void setPasswordWorkFactor(int logN);
+int passwordWorkFactor();
+
+typedef array<uint8_t, 32> Digest;
+
+// Incremental SHA-256 (FIPS 180-4); copying one copies its running state
+class Sha256 {
+private:
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t used;
+    uint64_t length;
+
+    void compress(const uint8_t* data);
+
+public:
+    Sha256();
+    void update(const uint8_t* data, size_t size);
+    void update(string_view data) { update(reinterpret_cast<const uint8_t*>(data.data()), data.size()); }
+    Digest finish();
+};
+
+Digest sha256(string_view data);
+// RFC 7914 scrypt with N = 2^logN; output.size() bytes of key material
+bool scrypt(string_view password, string_view salt, int logN, int r, int p, vector<uint8_t>& output);
+
+bool isPasswordHash(string_view stored);
+string hashPassword(string_view password);
+bool verifyPassword(string_view password, string_view stored);
+// Compares every byte, so the time taken does not depend on where the
+// inputs first differ
+bool constantTimeEquals(string_view a, string_view b);
+
+// Recently verified (account, password) pairs, so an authenticated client
+// does not pay for scrypt on every request. Entries hold a keyed digest of
+// the password, never the password, and expire after the TTL. The table
+// has a fixed number of slots; a new entry replaces whatever shared its
+// slot. Thread-safe.
+class SessionCache {
+private:
+    static const size_t SLOTS = 1 << 16;
+    static const size_t STRIPES = 64;
+
+    struct Entry {
+        AccountId account;
+        Digest digest;
+        chrono::steady_clock::time_point expires;
+    };
+    struct alignas(64) Stripe {
+        mutex lock;
+    };
+
+    vector<Entry> entries;
+    array<Stripe, STRIPES> stripes;
+    // SHA-256 state after a random 64-byte key block
+    Sha256 keyed;
+    atomic<unsigned> ttl;
+
+    size_t slotOf(AccountId account) const;
+    Digest digestOf(AccountId account, string_view password) const;
+
+public:
+    explicit SessionCache(unsigned ttlSeconds);
+
+    // TTL of 0 turns the cache off and forgets every entry
+    void setTtl(unsigned ttlSeconds);
+    bool check(AccountId account, string_view password);
+    void remember(AccountId account, string_view password);
+    void clear();
+};
+
+#endif
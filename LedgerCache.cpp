@@ -0,0 +1,94 @@
+#include "LedgerCache.h"
+#include <algorithm>
+
+LedgerCache::LedgerCache(size_t capacityBytes, Loader segmentLoader)
+    : loader(segmentLoader), capacity(capacityBytes), resident(0), hitCount(0), missCount(0) {}
+
+// The segment just used is never the one evicted, so a single segment
+// larger than the cap still stays cached until the next one arrives
+void LedgerCache::evict() {
+    while (resident > capacity && recency.size() > 1) {
+        auto it = entries.find(recency.back());
+        resident -= it->second.segment->bytes;
+        entries.erase(it);
+        recency.pop_back();
+    }
+}
+
+shared_ptr<const CachedSegment> LedgerCache::get(const string& path, size_t first, size_t end) {
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = entries.find(path);
+        if (it != entries.end()) {
+            recency.splice(recency.begin(), recency, it->second.recent);
+            hitCount++;
+            return it->second.segment;
+        }
+        missCount++;
+    }
+
+    auto segment = make_shared<CachedSegment>();
+    loader(path, first, end, segment->rows);
+    for (size_t i = 0; i < segment->rows.size(); i++) {
+        segment->postings[segment->rows[i].accountId].push_back(static_cast<uint32_t>(i));
+    }
+    // Chunk space past the last row is never touched, so only the rows
+    // themselves count against the cap
+    segment->bytes = segment->rows.size() * sizeof(Transaction);
+    for (const auto& account : segment->postings) {
+        segment->bytes += sizeof(account) + account.second.capacity() * sizeof(uint32_t);
+    }
+    Span span{INT64_MAX, INT64_MIN};
+    for (const auto& partition : segment->rows.dayPartitions()) {
+        span.minTimestamp = min(span.minTimestamp, partition.minTimestamp);
+        span.maxTimestamp = max(span.maxTimestamp, partition.maxTimestamp);
+    }
+
+    lock_guard<mutex> lock(cacheMutex);
+    spans[path] = span;
+    // Another thread may have loaded the same segment meanwhile
+    auto it = entries.find(path);
+    if (it != entries.end()) {
+        recency.splice(recency.begin(), recency, it->second.recent);
+        return it->second.segment;
+    }
+    recency.push_front(path);
+    entries[path] = Entry{segment, recency.begin()};
+    resident += segment->bytes;
+    evict();
+    return segment;
+}
+
+bool LedgerCache::span(const string& path, int64_t& minTimestamp, int64_t& maxTimestamp) const {
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = spans.find(path);
+    if (it == spans.end()) return false;
+    minTimestamp = it->second.minTimestamp;
+    maxTimestamp = it->second.maxTimestamp;
+    return true;
+}
+
+void LedgerCache::erase(const string& path) {
+    lock_guard<mutex> lock(cacheMutex);
+    spans.erase(path);
+    auto it = entries.find(path);
+    if (it == entries.end()) return;
+    resident -= it->second.segment->bytes;
+    recency.erase(it->second.recent);
+    entries.erase(it);
+}
+
+size_t LedgerCache::residentBytes() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return resident;
+}
+
+size_t LedgerCache::hits() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return hitCount;
+}
+
+size_t LedgerCache::misses() const {
+    lock_guard<mutex> lock(cacheMutex);
+    return missCount;
+}
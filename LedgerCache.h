@@ -0,0 +1,74 @@
+#ifndef LEDGERCACHE_H
+#define LEDGERCACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LedgerStore.h"
+
+using namespace std;
+
+// One sealed ledger segment read back into memory, with its own index of
+// rows by account. Positions are relative to the segment's first row.
+struct CachedSegment {
+    LedgerStore rows;
+    unordered_map<AccountId, vector<uint32_t>> postings;
+    size_t bytes;
+};
+
+// Sealed ledger segments paged in on first use and kept up to a memory
+// cap, least recently used first out. A segment handed out stays valid
+// for as long as the caller holds it, even once evicted. Segment files
+// never change, so entries are keyed by path alone. The time span of each
+// segment loaded so far is remembered after eviction, so range queries
+// can pass over it without reading it again. Thread-safe; loads run
+// outside the cache lock.
+class LedgerCache {
+public:
+    // Appends rows [first, end) of a segment file to into; throws on failure
+    using Loader = function<void(const string& path, size_t first, size_t end, LedgerStore& into)>;
+
+private:
+    struct Entry {
+        shared_ptr<const CachedSegment> segment;
+        list<string>::iterator recent;
+    };
+    struct Span {
+        int64_t minTimestamp;
+        int64_t maxTimestamp;
+    };
+
+    Loader loader;
+    size_t capacity;
+    mutable mutex cacheMutex;
+    unordered_map<string, Entry> entries;
+    // Most recently used first
+    list<string> recency;
+    unordered_map<string, Span> spans;
+    size_t resident;
+    size_t hitCount;
+    size_t missCount;
+
+    void evict();
+
+public:
+    LedgerCache(size_t capacityBytes, Loader segmentLoader);
+
+    // The rows of one path must be the same on every call
+    shared_ptr<const CachedSegment> get(const string& path, size_t first, size_t end);
+    // False until the segment has been loaded once
+    bool span(const string& path, int64_t& minTimestamp, int64_t& maxTimestamp) const;
+    // Forgets a segment whose file has been replaced
+    void erase(const string& path);
+
+    size_t residentBytes() const;
+    size_t hits() const;
+    size_t misses() const;
+};
+
+#endif
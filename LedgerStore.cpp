@@ -0,0 +1,71 @@
+#include "LedgerStore.h"
+#include <algorithm>
+
+LedgerStore::LedgerStore() : count(0), resident(0) {}
+
+LedgerStore::~LedgerStore() {
+    clear();
+}
+
+// Raw memory: rows are constructed in place by push_back, and pages the
+// ledger has not reached yet are never touched
+void LedgerStore::addChunk() {
+    void* memory = ::operator new(CHUNK_ROWS * sizeof(Transaction));
+    chunks.push_back(static_cast<Transaction*>(memory));
+}
+
+void LedgerStore::startAt(size_t rows) {
+    // The chunk row rows falls in is allocated by the first push_back
+    chunks.assign(rows >> CHUNK_SHIFT, nullptr);
+    count = rows;
+    resident = rows;
+}
+
+void LedgerStore::reserve(size_t rows) {
+    size_t needed = (rows + CHUNK_ROWS - 1) >> CHUNK_SHIFT;
+    chunks.reserve(needed);
+    while (chunks.size() < needed) {
+        addChunk();
+    }
+}
+
+void LedgerStore::addToPartition(int64_t timestamp) {
+    int64_t day = timestamp / SECONDS_PER_DAY - (timestamp % SECONDS_PER_DAY < 0);
+    if (partitions.empty() || day > partitions.back().day) {
+        partitions.push_back({day, count, count + 1, timestamp, timestamp});
+        return;
+    }
+    LedgerPartition& partition = partitions.back();
+    partition.end = count + 1;
+    partition.minTimestamp = min(partition.minTimestamp, timestamp);
+    partition.maxTimestamp = max(partition.maxTimestamp, timestamp);
+}
+
+// maxTimestamp never falls from one partition to the next, so the first
+// candidate is found by binary search; after it, only minTimestamp decides
+vector<LedgerPartition> LedgerStore::partitionsBetween(int64_t fromTime, int64_t toTime) const {
+    auto it = partition_point(partitions.begin(), partitions.end(), [fromTime](const LedgerPartition& partition) {
+        return partition.maxTimestamp < fromTime;
+    });
+    vector<LedgerPartition> found;
+    for (; it != partitions.end(); ++it) {
+        if (it->minTimestamp <= toTime) found.push_back(*it);
+    }
+    return found;
+}
+
+void LedgerStore::clear() {
+    for (Transaction* chunk : chunks) {
+        ::operator delete(chunk);
+    }
+    chunks.clear();
+    partitions.clear();
+    count = 0;
+    resident = 0;
+}
+
+size_t LedgerStore::memoryUsage() const {
+    size_t allocated = chunks.size() - (resident >> CHUNK_SHIFT);
+    return allocated * CHUNK_ROWS * sizeof(Transaction) +
+           chunks.capacity() * sizeof(Transaction*) + partitions.capacity() * sizeof(LedgerPartition);
+}
@@ -0,0 +1,125 @@
+#ifndef LEDGERSTORE_H
+#define LEDGERSTORE_H
+
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Money.h"
+#include "AccountId.h"
+
+using namespace std;
+
+// Kind of ledger posting; stored as a code, rendered as text on demand
+enum class TransactionType : uint8_t {
+    AccountOpening,
+    Deposit,
+    Withdrawal,
+    TransferOut,
+    TransferIn,
+    AccountDeactivated,
+    Other
+};
+
+// Transaction structure to store transaction history. Rows are fixed size
+// and hold no strings; description() and dateText() build the text shown
+// in history and statements.
+struct Transaction {
+    AccountId accountId;
+    AccountId counterparty;  // other side of a transfer, else NO_ACCOUNT
+    int64_t timestamp;       // seconds since the epoch
+    Money amount;
+    Money balanceAfter;
+    TransactionType type;
+    uint32_t transferId;     // cross-shard transfer it belongs to, else 0
+
+    string description() const;  // e.g. "Transfer Out to RC10000008"
+    string dateText() const;     // e.g. "Sat Oct 18 01:12:00 2026"
+};
+
+static_assert(is_trivially_copyable<Transaction>::value && is_trivially_destructible<Transaction>::value,
+              "ledger rows are copied and released as raw memory");
+
+// A run of consecutive ledger rows posted on one UTC day. Rows are
+// appended in roughly time order: a row dated on a later day starts a new
+// partition, while a late row dated earlier (a cross-shard credit, an
+// unsorted import) stays in the current one and only lowers its
+// minTimestamp. minTimestamp/maxTimestamp always bound every row in
+// [first, end), so a date range query can skip any partition they exclude.
+struct LedgerPartition {
+    int64_t day;  // days since the epoch
+    size_t first;
+    size_t end;
+    int64_t minTimestamp;
+    int64_t maxTimestamp;
+};
+
+// Append-only storage for the ledger. Rows live in fixed-size chunks that
+// are never moved: growing the ledger allocates one more chunk instead of
+// copying every row, and a row's address stays valid until clear(). Rows
+// are also grouped into day partitions for date range queries.
+//
+// A ledger may start part way through (startAt()): rows before
+// firstResident() are kept elsewhere and must not be read from here.
+// Chunks holding only such rows are never allocated.
+class LedgerStore {
+public:
+    static const size_t CHUNK_SHIFT = 16;
+    static const size_t CHUNK_ROWS = size_t(1) << CHUNK_SHIFT;
+    static const int64_t SECONDS_PER_DAY = 86400;
+
+private:
+    static const size_t CHUNK_MASK = CHUNK_ROWS - 1;
+
+    vector<Transaction*> chunks;
+    size_t count;
+    size_t resident;
+    vector<LedgerPartition> partitions;
+
+    void addChunk();
+    void addToPartition(int64_t timestamp);
+
+public:
+    LedgerStore();
+    ~LedgerStore();
+    LedgerStore(const LedgerStore&) = delete;
+    LedgerStore& operator=(const LedgerStore&) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return chunks.size() * CHUNK_ROWS; }
+
+    size_t firstResident() const { return resident; }
+    // Only on an empty ledger: the next row appended is row rows
+    void startAt(size_t rows);
+
+    // Allocates every chunk needed for rows in one go (e.g. before a load)
+    void reserve(size_t rows);
+    void push_back(const Transaction& row) {
+        if (count >= capacity()) addChunk();
+        new (&chunks[count >> CHUNK_SHIFT][count & CHUNK_MASK]) Transaction(row);
+        addToPartition(row.timestamp);
+        count++;
+    }
+    void clear();
+
+    // Chunk i holds rows i * CHUNK_ROWS onwards; its address never changes
+    size_t chunkCount() const { return chunks.size(); }
+    const Transaction* chunk(size_t i) const { return chunks[i]; }
+
+    // Day partitions in row order
+    const vector<LedgerPartition>& dayPartitions() const { return partitions; }
+    // Partitions that may hold rows timestamped in [fromTime, toTime], in
+    // row order; rows inside them still need their own timestamp checked
+    vector<LedgerPartition> partitionsBetween(int64_t fromTime, int64_t toTime) const;
+
+    // Rows are not changed in place once written; partition bounds rely on it
+    Transaction& operator[](size_t i) { return chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK]; }
+    const Transaction& operator[](size_t i) const { return chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK]; }
+
+    // Bytes held by the chunks and the chunk directory
+    size_t memoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+atomic<bool> Metrics::active(false);
+LatencyHistogram Metrics::histograms[static_cast<size_t>(Metric::Count)];
+
+static const char* const METRIC_NAMES[] = {
+    "authenticate",
+    "password_hash",
+    "find_account",
+    "deposit",
+    "withdraw",
+    "transfer",
+    "multi_transfer",
+    "history",
+    "statement",
+    "ledger_append",
+    "log_sync",
+    "load_accounts",
+    "load_ledger",
+    "replay_log",
+    "save_accounts",
+    "save_ledger",
+    "checkpoint",
+    "compaction"
+};
+
+static_assert(sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0]) == static_cast<size_t>(Metric::Count),
+              "every Metric needs a name");
+
+static int highestBit(uint64_t value) {
+    int bit = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (value >> step) {
+            value >>= step;
+            bit += step;
+        }
+    }
+    return bit;
+}
+
+LatencyHistogram::LatencyHistogram() : total(0), sum(0), largest(0) {
+    for (auto& bucket : buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+}
+
+// Values below SUB_BUCKETS get a bucket each; above that, the top
+// SUB_BUCKET_BITS + 1 bits pick the bucket
+int LatencyHistogram::bucketOf(uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) return static_cast<int>(nanos);
+    int shift = highestBit(nanos) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((nanos >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketTop(int bucket) {
+    if (bucket < SUB_BUCKETS) return static_cast<uint64_t>(bucket);
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(nanos, memory_order_relaxed);
+    uint64_t seen = largest.load(memory_order_relaxed);
+    while (nanos > seen && !largest.compare_exchange_weak(seen, nanos, memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    total.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    largest.store(0, memory_order_relaxed);
+}
+
+// Samples recorded while this runs may or may not be counted; the answer
+// is still one of the bucket bounds around the requested rank
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    uint64_t samples = count();
+    if (samples == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(fraction * samples);
+    if (rank >= samples) rank = samples - 1;
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += buckets[bucket].load(memory_order_relaxed);
+        if (seen > rank) return min(bucketTop(bucket), maxNanos());
+    }
+    return maxNanos();
+}
+
+void Metrics::reset() {
+    for (auto& histogram : histograms) {
+        histogram.reset();
+    }
+}
+
+const char* Metrics::name(Metric metric) {
+    return METRIC_NAMES[static_cast<size_t>(metric)];
+}
+
+string Metrics::report() {
+    ostringstream out;
+    out << "# banking metrics (" << (enabled() ? "enabled" : "disabled") << "), times in microseconds\n";
+    out << left << setw(16) << "operation" << right << setw(12) << "calls" << setw(12) << "mean"
+        << setw(12) << "p50" << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "p99.9"
+        << setw(12) << "max" << "\n";
+    out << fixed << setprecision(2);
+    for (size_t i = 0; i < static_cast<size_t>(Metric::Count); i++) {
+        const LatencyHistogram& h = histograms[i];
+        uint64_t calls = h.count();
+        out << left << setw(16) << METRIC_NAMES[i] << right << setw(12) << calls
+            << setw(12) << (calls ? h.totalNanos() / 1e3 / calls : 0.0)
+            << setw(12) << h.percentile(0.50) / 1e3 << setw(12) << h.percentile(0.90) / 1e3
+            << setw(12) << h.percentile(0.99) / 1e3 << setw(12) << h.percentile(0.999) / 1e3
+            << setw(12) << h.maxNanos() / 1e3 << "\n";
+    }
+    return out.str();
+}
+
+MetricsFileWriter::MetricsFileWriter(const string& file, unsigned seconds)
+    : path(file), interval(seconds ? seconds : 1), stopping(false) {
+    writer = thread(&MetricsFileWriter::run, this);
+}
+
+MetricsFileWriter::~MetricsFileWriter() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    writeNow();
+}
+
+void MetricsFileWriter::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!wake.wait_for(lock, interval, [this]() { return stopping; })) {
+        lock.unlock();
+        writeNow();
+        lock.lock();
+    }
+}
+
+bool MetricsFileWriter::writeNow() {
+    string tempFile = path + ".tmp";
+    ofstream file(tempFile);
+    if (!file) return false;
+    file << Metrics::report();
+    file.close();
+    return file && rename(tempFile.c_str(), path.c_str()) == 0;
+}
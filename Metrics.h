@@ -0,0 +1,137 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Operations timed by the metrics layer
+enum class Metric : uint8_t {
+    Authenticate,
+    PasswordHash,
+    FindAccount,
+    Deposit,
+    Withdraw,
+    Transfer,
+    MultiTransfer,
+    History,
+    Statement,
+    LedgerAppend,
+    LogSync,
+    LoadAccounts,
+    LoadLedger,
+    ReplayLog,
+    SaveAccounts,
+    SaveLedger,
+    Checkpoint,
+    Compaction,
+    Count
+};
+
+// Log-linear latency histogram in the style of HdrHistogram. Values are
+// nanoseconds; every power of two is split into SUB_BUCKETS linear
+// buckets, so a reported value is within 1/SUB_BUCKETS of the true one.
+// Recording is a few relaxed atomic adds and never blocks.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    atomic<uint64_t> buckets[BUCKETS];
+    atomic<uint64_t> total;
+    atomic<uint64_t> sum;
+    atomic<uint64_t> largest;
+
+    static int bucketOf(uint64_t nanos);
+    static uint64_t bucketTop(int bucket);
+
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t nanos);
+    void reset();
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t totalNanos() const { return sum.load(memory_order_relaxed); }
+    uint64_t maxNanos() const { return largest.load(memory_order_relaxed); }
+    // Upper bound of the bucket holding the given fraction of samples
+    uint64_t percentile(double fraction) const;
+};
+
+// Process-wide counters and histograms, one per Metric. Off by default;
+// while off, instrumented code pays one relaxed load and a branch.
+class Metrics {
+private:
+    static atomic<bool> active;
+    static LatencyHistogram histograms[static_cast<size_t>(Metric::Count)];
+
+public:
+    static void enable(bool on) { active.store(on, memory_order_relaxed); }
+    static bool enabled() { return active.load(memory_order_relaxed); }
+
+    static void record(Metric metric, uint64_t nanos) {
+        histograms[static_cast<size_t>(metric)].record(nanos);
+    }
+    static const LatencyHistogram& histogram(Metric metric) {
+        return histograms[static_cast<size_t>(metric)];
+    }
+    static void reset();
+
+    static const char* name(Metric metric);
+    // One line per operation: calls, mean, percentiles and max in microseconds
+    static string report();
+};
+
+// Times the enclosing scope into one metric. The clock is only read while
+// metrics are enabled.
+class MetricTimer {
+private:
+    Metric metric;
+    bool timing;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricTimer(Metric timed) : metric(timed), timing(Metrics::enabled()) {
+        if (timing) start = chrono::steady_clock::now();
+    }
+    ~MetricTimer() {
+        if (!timing) return;
+        auto elapsed = chrono::steady_clock::now() - start;
+        Metrics::record(metric, static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(elapsed).count()));
+    }
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+};
+
+// Rewrites Metrics::report() to a file every interval and once more when
+// destroyed. The file is replaced by rename, so readers never see half of it.
+class MetricsFileWriter {
+private:
+    string path;
+    chrono::seconds interval;
+    mutex wakeMutex;
+    condition_variable wake;
+    bool stopping;
+    thread writer;
+
+    void run();
+
+public:
+    MetricsFileWriter(const string& file, unsigned seconds);
+    ~MetricsFileWriter();
+    MetricsFileWriter(const MetricsFileWriter&) = delete;
+    MetricsFileWriter& operator=(const MetricsFileWriter&) = delete;
+
+    bool writeNow();
+};
+
+#endif
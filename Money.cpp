@@ -0,0 +1,107 @@
+#include "Money.h"
+#include <cmath>
+#include <cstdlib>
+
+// Writes the digits right to left into a 32-byte buffer and returns a
+// pointer to the first character; the text is NUL terminated
+char* Money::format(char* buffer) const {
+    char* out = buffer + 31;
+    *out = '\0';
+
+    bool negative = paise < 0;
+    uint64_t value = negative ? 0 - static_cast<uint64_t>(paise) : static_cast<uint64_t>(paise);
+    *--out = static_cast<char>('0' + value % 10);
+    value /= 10;
+    *--out = static_cast<char>('0' + value % 10);
+    value /= 10;
+    *--out = '.';
+    do {
+        *--out = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    if (negative) *--out = '-';
+    return out;
+}
+
+string Money::toString() const {
+    char buffer[32];
+    return string(format(buffer));
+}
+
+ostream& operator<<(ostream& out, Money value) {
+    char buffer[32];
+    return out << value.format(buffer);
+}
+
+// Legacy text files stored balances with default stream precision
+static bool parseExponentForm(const char* begin, const char* end, Money& value) {
+    string text(begin, end);
+    char* parsedEnd = nullptr;
+    double amount = strtod(text.c_str(), &parsedEnd);
+    if (parsedEnd != text.c_str() + text.size() || !std::isfinite(amount)) return false;
+
+    double scaled = std::round(amount * 100.0);
+    if (std::fabs(scaled) >= 9.2e18) return false;
+    value = Money::fromPaise(static_cast<int64_t>(scaled));
+    return true;
+}
+
+bool Money::parse(const char* begin, const char* end, Money& value) {
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == end) return false;
+
+    const uint64_t LIMIT = static_cast<uint64_t>(numeric_limits<int64_t>::max());
+    uint64_t rupees = 0;
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        uint64_t digit = static_cast<uint64_t>(*p - '0');
+        if (rupees > (LIMIT / 100 - digit) / 10) return false;
+        rupees = rupees * 10 + digit;
+        p++;
+    }
+    bool hasRupees = (p != digits);
+
+    uint64_t fraction = 0;
+    int places = 0;
+    bool roundUp = false;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (places < 2) {
+                fraction = fraction * 10 + static_cast<uint64_t>(*p - '0');
+            } else if (places == 2) {
+                roundUp = (*p >= '5');
+            }
+            places++;
+            p++;
+        }
+        if (!hasRupees && places == 0) return false;
+    } else if (!hasRupees) {
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        return parseExponentForm(begin, end, value);
+    }
+    if (p != end) return false;
+
+    while (places < 2) {
+        fraction *= 10;
+        places++;
+    }
+    uint64_t total = rupees * 100 + fraction + (roundUp ? 1 : 0);
+    if (total > LIMIT) return false;
+
+    int64_t signedTotal = static_cast<int64_t>(total);
+    value = Money::fromPaise(negative ? -signedTotal : signedTotal);
+    return true;
+}
+
+bool Money::parse(const string& text, Money& value) {
+    return parse(text.data(), text.data() + text.size(), value);
+}
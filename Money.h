@@ -0,0 +1,81 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Exact amount of money held as a whole number of paise. Arithmetic is
+// checked: operators throw overflow_error, and the tryAdd/trySubtract
+// forms report overflow to callers that must not throw.
+class Money {
+private:
+    int64_t paise;
+
+    explicit constexpr Money(int64_t value) : paise(value) {}
+
+public:
+    constexpr Money() : paise(0) {}
+
+    static constexpr Money fromPaise(int64_t value) { return Money(value); }
+    static constexpr Money fromRupees(int64_t rupees) { return Money(rupees * 100); }
+    constexpr int64_t toPaise() const { return paise; }
+
+    static bool tryAdd(Money a, Money b, Money& sum) {
+        if ((b.paise > 0 && a.paise > numeric_limits<int64_t>::max() - b.paise) ||
+            (b.paise < 0 && a.paise < numeric_limits<int64_t>::min() - b.paise)) {
+            return false;
+        }
+        sum.paise = a.paise + b.paise;
+        return true;
+    }
+
+    static bool trySubtract(Money a, Money b, Money& difference) {
+        if ((b.paise < 0 && a.paise > numeric_limits<int64_t>::max() + b.paise) ||
+            (b.paise > 0 && a.paise < numeric_limits<int64_t>::min() + b.paise)) {
+            return false;
+        }
+        difference.paise = a.paise - b.paise;
+        return true;
+    }
+
+    Money operator+(Money other) const {
+        Money sum;
+        if (!tryAdd(*this, other, sum)) throw overflow_error("Money overflow");
+        return sum;
+    }
+
+    Money operator-(Money other) const {
+        Money difference;
+        if (!trySubtract(*this, other, difference)) throw overflow_error("Money overflow");
+        return difference;
+    }
+
+    Money& operator+=(Money other) { return *this = *this + other; }
+    Money& operator-=(Money other) { return *this = *this - other; }
+
+    bool operator==(Money other) const { return paise == other.paise; }
+    bool operator!=(Money other) const { return paise != other.paise; }
+    bool operator<(Money other) const { return paise < other.paise; }
+    bool operator<=(Money other) const { return paise <= other.paise; }
+    bool operator>(Money other) const { return paise > other.paise; }
+    bool operator>=(Money other) const { return paise >= other.paise; }
+
+    // Always two decimal places, e.g. "1234.50" or "-0.05"
+    string toString() const;
+    char* format(char* buffer) const;
+
+    // Accepts "123", "123.4", "123.45" and an optional sign; extra decimal
+    // places are rounded half up. Exponent forms written by older data
+    // files ("1.23457e+06") are accepted as well.
+    static bool parse(const char* begin, const char* end, Money& value);
+    static bool parse(const string& text, Money& value);
+};
+
+ostream& operator<<(ostream& out, Money value);
+
+#endif
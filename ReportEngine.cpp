@@ -0,0 +1,228 @@
+#include "ReportEngine.h"
+#include <algorithm>
+#include <thread>
+
+// Below this many rows per thread a scan is not worth splitting
+static const size_t MIN_ROWS_PER_THREAD = 1 << 16;
+
+static size_t partsFor(size_t count, unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    return max<size_t>(1, min<size_t>(threads, count / MIN_ROWS_PER_THREAD));
+}
+
+// Runs scan(part, begin, end) over one contiguous range of [0, count) for
+// each of partsFor(count, threads) parts, the last on the calling thread
+template <typename Scan>
+static void scanInParallel(size_t count, unsigned threads, Scan scan) {
+    size_t parts = partsFor(count, threads);
+    vector<thread> workers;
+    for (size_t part = 0; part + 1 < parts; part++) {
+        workers.emplace_back(scan, part, count * part / parts, count * (part + 1) / parts);
+    }
+    scan(parts - 1, count * (parts - 1) / parts, count);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+AccountTypeTotals ReportEngine::typeTotals(const AccountStore::Columns& columns, unsigned threads) {
+    struct Partial {
+        int64_t balance[ACCOUNT_TYPES];
+        int64_t accounts[ACCOUNT_TYPES];
+    };
+    vector<Partial> partials(partsFor(columns.count, threads), Partial{{0, 0}, {0, 0}});
+    scanInParallel(columns.count, threads, [&](size_t part, size_t begin, size_t end) {
+        int64_t savings = 0;
+        int64_t current = 0;
+        int64_t savingsAccounts = 0;
+        int64_t currentAccounts = 0;
+        for (size_t i = begin; i < end; i++) {
+            int64_t active = columns.active[i] != 0;
+            int64_t isCurrent = columns.types[i] == AccountType::Current;
+            int64_t paise = columns.balances[i].toPaise() & -active;
+            current += paise & -isCurrent;
+            savings += paise & (isCurrent - 1);
+            currentAccounts += active & isCurrent;
+            savingsAccounts += active & (1 - isCurrent);
+        }
+        Partial& partial = partials[part];
+        partial.balance[static_cast<size_t>(AccountType::Savings)] = savings;
+        partial.balance[static_cast<size_t>(AccountType::Current)] = current;
+        partial.accounts[static_cast<size_t>(AccountType::Savings)] = savingsAccounts;
+        partial.accounts[static_cast<size_t>(AccountType::Current)] = currentAccounts;
+    });
+
+    AccountTypeTotals totals;
+    for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+        int64_t balance = 0;
+        int64_t accounts = 0;
+        for (const auto& partial : partials) {
+            balance += partial.balance[type];
+            accounts += partial.accounts[type];
+        }
+        totals.accounts[type] = static_cast<size_t>(accounts);
+        totals.balance[type] = Money::fromPaise(balance);
+    }
+    return totals;
+}
+
+vector<AccountBalance> ReportEngine::balancesBelow(const AccountStore::Columns& columns, Money threshold,
+                                                   unsigned threads) {
+    vector<vector<AccountBalance>> partials(partsFor(columns.count, threads));
+    scanInParallel(columns.count, threads, [&](size_t part, size_t begin, size_t end) {
+        vector<AccountBalance>& found = partials[part];
+        for (size_t i = begin; i < end; i++) {
+            if (columns.active[i] && columns.balances[i] < threshold) {
+                found.push_back({columns.ids[i], columns.balances[i]});
+            }
+        }
+    });
+
+    vector<AccountBalance> below;
+    for (const auto& found : partials) {
+        below.insert(below.end(), found.begin(), found.end());
+    }
+    sort(below.begin(), below.end(), [](const AccountBalance& a, const AccountBalance& b) {
+        return a.balance != b.balance ? a.balance < b.balance : a.id < b.id;
+    });
+    return below;
+}
+
+// Each thread keeps a min-heap of its count best; the heaps are merged
+vector<AccountBalance> ReportEngine::topBalances(const AccountStore::Columns& columns, size_t count,
+                                                 unsigned threads) {
+    auto higher = [](const AccountBalance& a, const AccountBalance& b) {
+        return a.balance != b.balance ? a.balance > b.balance : a.id < b.id;
+    };
+    if (count == 0) return {};
+    vector<vector<AccountBalance>> heaps(partsFor(columns.count, threads));
+    scanInParallel(columns.count, threads, [&](size_t part, size_t begin, size_t end) {
+        vector<AccountBalance>& heap = heaps[part];
+        heap.reserve(count);
+        for (size_t i = begin; i < end; i++) {
+            if (!columns.active[i]) continue;
+            AccountBalance candidate{columns.ids[i], columns.balances[i]};
+            if (heap.size() < count) {
+                heap.push_back(candidate);
+                push_heap(heap.begin(), heap.end(), higher);
+            } else if (higher(candidate, heap.front())) {
+                pop_heap(heap.begin(), heap.end(), higher);
+                heap.back() = candidate;
+                push_heap(heap.begin(), heap.end(), higher);
+            }
+        }
+    });
+
+    vector<AccountBalance> top;
+    for (const auto& heap : heaps) {
+        top.insert(top.end(), heap.begin(), heap.end());
+    }
+    size_t kept = min(count, top.size());
+    partial_sort(top.begin(), top.begin() + kept, top.end(), higher);
+    top.resize(kept);
+    return top;
+}
+
+static time_t localMidnight(time_t when, int daysLater) {
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &when);
+#else
+    localtime_r(&when, &local);
+#endif
+    local.tm_mday += daysLater;
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_isdst = -1;
+    return mktime(&local);
+}
+
+vector<DailyFlow> ReportEngine::dailyFlows(const vector<const Transaction*>& chunks,
+                                           const vector<LedgerPartition>& partitions,
+                                           time_t fromDate, time_t toDate, unsigned threads) {
+    const size_t CHUNK_MASK = LedgerStore::CHUNK_ROWS - 1;
+    auto row = [&chunks, CHUNK_MASK](size_t i) -> const Transaction& {
+        return chunks[i >> LedgerStore::CHUNK_SHIFT][i & CHUNK_MASK];
+    };
+    if (partitions.empty()) return {};
+
+    // Adjacent partitions are scanned as one run of rows; runStarts[r] is
+    // the position of run r's first row among all the rows scanned
+    vector<pair<size_t, size_t>> runs;
+    vector<size_t> runStarts;
+    size_t scanned = 0;
+    int64_t earliest = INT64_MAX;
+    int64_t latest = INT64_MIN;
+    for (const auto& partition : partitions) {
+        if (!runs.empty() && runs.back().second == partition.first) {
+            runs.back().second = partition.end;
+        } else {
+            runs.push_back({partition.first, partition.end});
+            runStarts.push_back(scanned);
+        }
+        scanned += partition.end - partition.first;
+        earliest = min(earliest, partition.minTimestamp);
+        latest = max(latest, partition.maxTimestamp);
+    }
+    time_t from = fromDate ? fromDate : static_cast<time_t>(earliest);
+    time_t to = toDate ? toDate : static_cast<time_t>(latest);
+    if (from > to) return {};
+
+    // dayStarts[d] .. dayStarts[d + 1] is day d
+    vector<time_t> dayStarts{localMidnight(from, 0)};
+    while (dayStarts.back() <= to) {
+        dayStarts.push_back(localMidnight(dayStarts.front(), static_cast<int>(dayStarts.size())));
+    }
+    size_t days = dayStarts.size() - 1;
+
+    struct DaySums {
+        int64_t inflow;
+        int64_t outflow;
+        int64_t transfers;
+        int64_t rows;
+    };
+    vector<vector<DaySums>> partials(partsFor(scanned, threads));
+    scanInParallel(scanned, threads, [&](size_t part, size_t begin, size_t end) {
+        vector<DaySums>& sums = partials[part];
+        sums.assign(days, DaySums{0, 0, 0, 0});
+        size_t day = 0;
+        size_t run = upper_bound(runStarts.begin(), runStarts.end(), begin) - runStarts.begin() - 1;
+        size_t i = runs[run].first + (begin - runStarts[run]);
+        for (size_t position = begin; position < end; position++, i++) {
+            if (i == runs[run].second) i = runs[++run].first;
+            const Transaction& trans = row(i);
+            time_t when = static_cast<time_t>(trans.timestamp);
+            // Edge partitions hold rows either side of the range
+            if (when < from || when > to) continue;
+            // Rows are nearly always in the current day or the next one
+            if (when < dayStarts[day] || when >= dayStarts[day + 1]) {
+                day = upper_bound(dayStarts.begin(), dayStarts.end(), when) - dayStarts.begin() - 1;
+            }
+            int64_t amount = trans.amount.toPaise();
+            TransactionType type = trans.type;
+            int64_t in = -static_cast<int64_t>(type == TransactionType::Deposit ||
+                                               type == TransactionType::AccountOpening);
+            int64_t out = -static_cast<int64_t>(type == TransactionType::Withdrawal);
+            int64_t moved = -static_cast<int64_t>(type == TransactionType::TransferOut);
+            DaySums& sum = sums[day];
+            sum.inflow += amount & in;
+            sum.outflow += amount & out;
+            sum.transfers += amount & moved;
+            sum.rows++;
+        }
+    });
+
+    vector<DailyFlow> flows(days);
+    for (size_t day = 0; day < days; day++) {
+        DaySums total{0, 0, 0, 0};
+        for (const auto& sums : partials) {
+            if (sums.empty()) continue;
+            total.inflow += sums[day].inflow;
+            total.outflow += sums[day].outflow;
+            total.transfers += sums[day].transfers;
+            total.rows += sums[day].rows;
+        }
+        flows[day] = DailyFlow{dayStarts[day], Money::fromPaise(total.inflow), Money::fromPaise(total.outflow),
+                               Money::fromPaise(total.transfers), static_cast<size_t>(total.rows)};
+    }
+    return flows;
+}
@@ -0,0 +1,56 @@
+#ifndef REPORTENGINE_H
+#define REPORTENGINE_H
+
+#include <ctime>
+#include <vector>
+#include "AccountStore.h"
+#include "LedgerStore.h"
+
+using namespace std;
+
+// Active accounts and the balances they hold, indexed by AccountType
+struct AccountTypeTotals {
+    size_t accounts[ACCOUNT_TYPES];
+    Money balance[ACCOUNT_TYPES];
+};
+
+// Money through the bank on one local calendar day. Inflow is deposits
+// and opening deposits, outflow is withdrawals; transfers move money
+// between accounts and are counted once, on their debit side.
+struct DailyFlow {
+    time_t day;  // local midnight
+    Money inflow;
+    Money outflow;
+    Money transfers;
+    size_t rows;
+};
+
+struct AccountBalance {
+    AccountId id;
+    Money balance;
+};
+
+// Scans behind the bank-wide reports. They read raw columns (the account
+// table's hot arrays, the ledger's row chunks) with no locks of their own;
+// callers hold whatever keeps those stable. Each scan splits its input
+// into one contiguous range per thread (0 = every core), keeps partial
+// results per thread and merges them at the end. Inner loops are
+// branch-free so the compiler can vectorise them.
+class ReportEngine {
+public:
+    static AccountTypeTotals typeTotals(const AccountStore::Columns& columns, unsigned threads);
+    // Active accounts holding less than threshold, lowest balance first
+    static vector<AccountBalance> balancesBelow(const AccountStore::Columns& columns, Money threshold,
+                                                unsigned threads);
+    // The count highest active balances, highest first
+    static vector<AccountBalance> topBalances(const AccountStore::Columns& columns, size_t count,
+                                              unsigned threads);
+    // One entry per local day from fromDate to toDate (0 = the earliest or
+    // latest row). Only rows in the given day partitions are read, so
+    // callers pass the ledger's partitionsBetween() for the range.
+    static vector<DailyFlow> dailyFlows(const vector<const Transaction*>& chunks,
+                                        const vector<LedgerPartition>& partitions,
+                                        time_t fromDate, time_t toDate, unsigned threads);
+};
+
+#endif
@@ -0,0 +1,428 @@
+#include "ShardedBank.h"
+#include "Credentials.h"
+#include "Metrics.h"
+#include <charconv>
+#include <filesystem>
+#include <map>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+static void pinToCore(thread& worker, unsigned core) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus);
+#else
+    (void)worker;
+    (void)core;
+#endif
+}
+
+// The shard count is fixed by the first run against a directory; account
+// numbers already issued depend on it
+static unsigned recordedShardCount(const string& path, unsigned requested) {
+    ifstream in(path);
+    unsigned recorded = 0;
+    if (in >> recorded && recorded > 0) {
+        if (requested != 0 && requested != recorded) {
+            throw runtime_error(path + " holds " + to_string(recorded) + " shards, not " + to_string(requested));
+        }
+        return recorded;
+    }
+    if (requested == 0) requested = max(1u, thread::hardware_concurrency());
+    ofstream out(path);
+    out << requested << "\n";
+    if (!out) throw runtime_error("Cannot write " + path);
+    return requested;
+}
+
+ShardedBank::ShardedBank(const string& dataDirectory, unsigned shardCount)
+    : directory(dataDirectory), nextOpenShard(0),
+      journal(dataDirectory + "/transfers.log"), journalFile(dataDirectory + "/transfers.log"),
+      nextTransferId(1) {
+    filesystem::create_directories(directory);
+    unsigned count = recordedShardCount(directory + "/shards", shardCount);
+    for (unsigned i = 0; i < count; i++) {
+        unique_ptr<Shard> shard(new Shard());
+        shard->bank.reset(new BankingSystem(directory + "/shard_" + to_string(i)));
+        shard->bank->partitionAccountSerials(i, count);
+        shards.push_back(move(shard));
+    }
+    recoverTransfers();
+    journal.open();
+    if (!rewriteJournal()) {
+        journal.append(nextIdRecord(), true);
+        journal.sync();
+    }
+
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < count; i++) {
+        Shard& shard = *shards[i];
+        shard.worker = thread(&ShardedBank::runWorker, this, ref(shard));
+        pinToCore(shard.worker, i % cores);
+    }
+}
+
+// Workers finish everything already queued before they exit
+ShardedBank::~ShardedBank() {
+    for (auto& shard : shards) {
+        {
+            lock_guard<mutex> lock(shard->queueMutex);
+            shard->stopping = true;
+        }
+        shard->ready.notify_one();
+    }
+    for (auto& shard : shards) {
+        shard->worker.join();
+    }
+}
+
+// Legacy 6-digit IDs have no serial and are placed by the ID itself
+unsigned ShardedBank::shardOf(AccountId account) const {
+    uint64_t serial = accountSerial(account);
+    return static_cast<unsigned>((serial ? serial : account) % shards.size());
+}
+
+future<Result> ShardedBank::submit(AccountId account, function<Result(BankingSystem&)> operation) {
+    return enqueue(*shards[shardOf(account)], move(operation));
+}
+
+future<Result> ShardedBank::enqueue(Shard& shard, function<Result(BankingSystem&)> operation) {
+    Request request;
+    request.operation = move(operation);
+    future<Result> result = request.done.get_future();
+    bool wake;
+    {
+        lock_guard<mutex> lock(shard.queueMutex);
+        wake = shard.queue.empty();
+        shard.queue.push_back(move(request));
+    }
+    if (wake) shard.ready.notify_one();
+    return result;
+}
+
+// Takes the whole queue at once; requests that arrive while a batch runs
+// form the next batch. Results are released only after the batch's log
+// records are synced, so one fsync covers the whole batch.
+void ShardedBank::runWorker(Shard& shard) {
+    shard.bank->deferLogSync(true);
+    vector<Request> batch;
+    vector<Result> results;
+    unique_lock<mutex> lock(shard.queueMutex);
+    for (;;) {
+        shard.ready.wait(lock, [&shard]() { return shard.stopping || !shard.queue.empty(); });
+        if (shard.queue.empty()) break;
+        batch.swap(shard.queue);
+        lock.unlock();
+
+        results.clear();
+        for (auto& request : batch) {
+            results.push_back(request.operation(*shard.bank));
+        }
+        bool written = shard.bank->syncLog();
+        for (size_t i = 0; i < batch.size(); i++) {
+            // The batch's changes did not all reach the log
+            if (!written && results[i].ok()) results[i] = Result(ErrorCode::IoError);
+            batch[i].done.set_value(results[i]);
+        }
+        batch.clear();
+        lock.lock();
+    }
+    shard.bank->deferLogSync(false);
+}
+
+Result ShardedBank::openAccount(const string& name, const string& password,
+                                const string& accountType, Money initialDeposit) {
+    // Checked before the hash is paid for; the minimum is the same everywhere
+    if (initialDeposit < shards[0]->bank->getMinimumBalance()) return Result(ErrorCode::MinimumBalance);
+    string credential;
+    {
+        MetricTimer timer(Metric::PasswordHash);
+        credential = hashPassword(password);
+    }
+    unsigned index = nextOpenShard.fetch_add(1, memory_order_relaxed) % shards.size();
+    return enqueue(*shards[index], [name, password, credential, accountType, initialDeposit](BankingSystem& bank) {
+        return bank.openAccountWithCredential(name, password, credential, accountType, initialDeposit);
+    }).get();
+}
+
+// The stored hash is fetched and the login recorded on the worker; the
+// password is checked in between on this thread
+Result ShardedBank::authenticate(const string& accountNo, const string& password) {
+    MetricTimer timer(Metric::Authenticate);
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    bool cached = false;
+    string stored;
+    Result login = submit(id, [accountNo, password, &cached, &stored](BankingSystem& bank) {
+        return bank.beginLogin(accountNo, password, cached, stored);
+    }).get();
+    if (!login.ok() || cached) return login;
+
+    string upgraded;
+    if (!BankingSystem::verifyLogin(password, stored, upgraded)) return Result(ErrorCode::AuthenticationFailed);
+    return submit(id, [accountNo, password, stored, upgraded](BankingSystem& bank) {
+        return bank.finishLogin(accountNo, password, stored, upgraded);
+    }).get();
+}
+
+Result ShardedBank::deposit(const string& accountNo, Money amount) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [accountNo, amount](BankingSystem& bank) { return bank.deposit(accountNo, amount); }).get();
+}
+
+Result ShardedBank::withdraw(const string& accountNo, Money amount) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [accountNo, amount](BankingSystem& bank) { return bank.withdraw(accountNo, amount); }).get();
+}
+
+Result ShardedBank::getBalance(const string& accountNo) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [accountNo](BankingSystem& bank) { return bank.getBalance(accountNo); }).get();
+}
+
+Result ShardedBank::deactivate(const string& accountNo) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [accountNo](BankingSystem& bank) { return bank.deactivate(accountNo); }).get();
+}
+
+Result ShardedBank::writeAccountStatement(const string& accountNo, string& filename) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [accountNo, &filename](BankingSystem& bank) {
+        return bank.writeAccountStatement(accountNo, filename);
+    }).get();
+}
+
+Result ShardedBank::transferToMany(const string& fromAccount, const vector<TransferLeg>& legs,
+                                   const string& idempotencyKey) {
+    AccountId fromId = parseAccountId(fromAccount);
+    if (fromId == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    for (const auto& leg : legs) {
+        if (shardOf(leg.toAccount) != shardOf(fromId)) {
+            Result refused(ErrorCode::BadRequest);
+            refused.accountNo = formatAccountId(leg.toAccount);
+            return refused;
+        }
+    }
+    return submit(fromId, [fromAccount, legs, idempotencyKey](BankingSystem& bank) {
+        return bank.transferToMany(fromAccount, legs, idempotencyKey);
+    }).get();
+}
+
+Result ShardedBank::getTransactionHistory(const string& accountNo, vector<Transaction>& history,
+                                          time_t fromDate, time_t toDate, size_t limit) {
+    AccountId id = parseAccountId(accountNo);
+    if (id == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    return submit(id, [&history, accountNo, fromDate, toDate, limit](BankingSystem& bank) {
+        return bank.getTransactionHistory(accountNo, history, fromDate, toDate, limit);
+    }).get();
+}
+
+// A transfer inside one shard is the shard's own transfer(); see the class
+// comment for the two-phase protocol between shards
+Result ShardedBank::transfer(const string& fromAccount, const string& toAccount, Money amount) {
+    AccountId fromId = parseAccountId(fromAccount);
+    AccountId toId = parseAccountId(toAccount);
+    if (fromId == NO_ACCOUNT || toId == NO_ACCOUNT) return Result(ErrorCode::AccountNotFound);
+    if (shardOf(fromId) == shardOf(toId)) {
+        return submit(fromId, [fromAccount, toAccount, amount](BankingSystem& bank) {
+            return bank.transfer(fromAccount, toAccount, amount);
+        }).get();
+    }
+    if (amount <= Money()) return Result(ErrorCode::InvalidAmount);
+
+    // Prepare: the credit is checked first so a transfer bound to fail
+    // never touches the source account
+    Result check = submit(toId, [toAccount, amount](BankingSystem& bank) {
+        Result balance = bank.getBalance(toAccount);
+        Money credited;
+        if (balance.ok() && !Money::tryAdd(balance.balance, amount, credited)) {
+            balance.code = ErrorCode::AmountOverflow;
+        }
+        return balance;
+    }).get();
+    if (!check.ok()) return Result(check.code);
+
+    PendingTransfer pending{fromId, toId, amount, static_cast<int64_t>(time(0))};
+    uint32_t transferId = beginTransfer(pending);
+    Result debit = submit(fromId, [fromAccount, pending, transferId](BankingSystem& bank) {
+        return bank.debitTransfer(fromAccount, pending.to, pending.amount, pending.timestamp, transferId);
+    }).get();
+    if (debit.ok()) {
+        // Commit
+        Result credit = completeTransfer(transferId, pending);
+        if (credit.code == ErrorCode::TransferHeld) {
+            holdTransfer(transferId);
+            return credit;
+        }
+        if (!credit.ok()) debit = Result(credit.code, credit.balance);
+    }
+    finishTransfer(transferId);
+    return debit;
+}
+
+// Credits the destination of a debited transfer, or returns the money to
+// the source if the destination can no longer take it. The result carries
+// the source balance when the money was returned, and is TransferHeld if
+// it could not be.
+Result ShardedBank::completeTransfer(uint32_t transferId, const PendingTransfer& transfer) {
+    string toAccount = formatAccountId(transfer.to);
+    Result credit = submit(transfer.to, [toAccount, transfer, transferId](BankingSystem& bank) {
+        return bank.creditTransfer(toAccount, transfer.from, transfer.amount, transfer.timestamp, transferId);
+    }).get();
+    if (credit.ok()) return credit;
+
+    string fromAccount = formatAccountId(transfer.from);
+    Result refund = submit(transfer.from, [fromAccount, transfer, transferId](BankingSystem& bank) {
+        return bank.creditTransfer(fromAccount, transfer.to, transfer.amount, transfer.timestamp, transferId);
+    }).get();
+    if (!refund.ok()) return Result(ErrorCode::TransferHeld);
+    return Result(credit.code, refund.balance);
+}
+
+string ShardedBank::journalRecord(uint32_t transferId, const PendingTransfer& transfer) {
+    return "B|" + to_string(transferId) + "|" + to_string(transfer.from) + "|" + to_string(transfer.to) + "|" +
+           to_string(transfer.amount.toPaise()) + "|" + to_string(transfer.timestamp);
+}
+
+// The entry is on disk before the debit is made. The wait happens outside
+// the journal lock, so concurrent transfers share the journal's fsyncs.
+uint32_t ShardedBank::beginTransfer(const PendingTransfer& transfer) {
+    uint32_t transferId;
+    uint64_t lsn;
+    {
+        lock_guard<mutex> lock(journalMutex);
+        transferId = nextTransferId++;
+        // 0 marks rows outside any transfer
+        if (nextTransferId == 0) nextTransferId = 1;
+        pendingTransfers.emplace(transferId, transfer);
+        lsn = journal.append(journalRecord(transferId, transfer), true);
+    }
+    journal.waitDurable(lsn);
+    return transferId;
+}
+
+// The finish mark may be lost in a crash; recovery then finds the
+// transfer's rows already balanced and does nothing. Once the journal
+// passes JOURNAL_ROTATE_BYTES it is rewritten with just the transfers
+// still in flight.
+void ShardedBank::finishTransfer(uint32_t transferId) {
+    lock_guard<mutex> lock(journalMutex);
+    pendingTransfers.erase(transferId);
+    journal.append("E|" + to_string(transferId), true);
+    if (journal.size() >= JOURNAL_ROTATE_BYTES) rewriteJournal();
+}
+
+// No finish mark is written, so the entry stays open in the journal
+void ShardedBank::holdTransfer(uint32_t transferId) {
+    lock_guard<mutex> lock(journalMutex);
+    auto it = pendingTransfers.find(transferId);
+    if (it == pendingTransfers.end()) return;
+    heldTransfers.emplace(it->first, it->second);
+    pendingTransfers.erase(it);
+}
+
+// Starts a fresh journal with the next ID and every transfer still in
+// flight or held, then drops the old one. False if the journal could not
+// be swapped, in which case it keeps every record it had. Caller holds
+// journalMutex, or is the constructor.
+bool ShardedBank::rewriteJournal() {
+    string sealed = journalFile + ".old";
+    if (!journal.rotate(sealed)) return false;
+    journal.append(nextIdRecord(), true);
+    for (const auto& pending : pendingTransfers) {
+        journal.append(journalRecord(pending.first, pending.second), true);
+    }
+    for (const auto& held : heldTransfers) {
+        journal.append(journalRecord(held.first, held.second), true);
+    }
+    if (journal.sync()) remove(sealed.c_str());
+    return true;
+}
+
+// Transfers with a journal entry but no finish mark were cut off by a
+// crash or held. Their rows are found by the transfer ID they carry: a
+// debit with neither a credit nor a refund is completed now, and a
+// transfer never debited needs nothing. One that can still be neither
+// credited nor returned stays held. Runs before the workers start; the
+// constructor then rewrites the journal with just the held transfers.
+void ShardedBank::recoverTransfers() {
+    map<uint32_t, PendingTransfer> unfinished;
+    for (const string& path : {journalFile + ".old", journalFile}) {
+        for (const string& record : WriteAheadLog::readRecords(path)) {
+            vector<uint64_t> fields;
+            const char* p = record.data() + 2;
+            const char* last = record.data() + record.size();
+            while (record.size() > 2 && p <= last) {
+                uint64_t value = 0;
+                auto parsed = from_chars(p, last, value);
+                if (parsed.ec != errc()) break;
+                fields.push_back(value);
+                p = parsed.ptr + 1;
+            }
+            if (record[0] == 'B' && fields.size() == 5) {
+                uint32_t transferId = static_cast<uint32_t>(fields[0]);
+                unfinished[transferId] = PendingTransfer{fields[1], fields[2],
+                                                         Money::fromPaise(static_cast<int64_t>(fields[3])),
+                                                         static_cast<int64_t>(fields[4])};
+                if (transferId >= nextTransferId) nextTransferId = transferId + 1;
+            } else if (record[0] == 'E' && fields.size() == 1) {
+                unfinished.erase(static_cast<uint32_t>(fields[0]));
+            } else if (record[0] == 'N' && fields.size() == 1 && fields[0] > nextTransferId) {
+                nextTransferId = static_cast<uint32_t>(fields[0]);
+            }
+        }
+    }
+    if (nextTransferId == 0) nextTransferId = 1;
+
+    for (const auto& entry : unfinished) {
+        uint32_t transferId = entry.first;
+        const PendingTransfer& transfer = entry.second;
+        auto posted = [&](AccountId account, TransactionType type, BankingSystem& bank) {
+            vector<Transaction> rows;
+            bank.getTransactionHistory(formatAccountId(account), rows, static_cast<time_t>(transfer.timestamp),
+                                       static_cast<time_t>(transfer.timestamp));
+            for (const auto& row : rows) {
+                if (row.type == type && row.transferId == transferId) return true;
+            }
+            return false;
+        };
+        BankingSystem& source = shard(shardOf(transfer.from));
+        BankingSystem& destination = shard(shardOf(transfer.to));
+        if (!posted(transfer.from, TransactionType::TransferOut, source) ||
+            posted(transfer.from, TransactionType::TransferIn, source) ||
+            posted(transfer.to, TransactionType::TransferIn, destination)) {
+            continue;
+        }
+        Result credit = destination.creditTransfer(formatAccountId(transfer.to), transfer.from,
+                                                   transfer.amount, transfer.timestamp, transferId);
+        if (credit.ok()) continue;
+        Result refund = source.creditTransfer(formatAccountId(transfer.from), transfer.to, transfer.amount,
+                                              transfer.timestamp, transferId);
+        if (!refund.ok()) heldTransfers.emplace(transferId, transfer);
+    }
+}
+
+Money ShardedBank::totalBalance() const {
+    Money total;
+    for (const auto& shard : shards) {
+        Money::tryAdd(total, shard->bank->totalBalance(), total);
+    }
+    lock_guard<mutex> lock(journalMutex);
+    for (const auto& held : heldTransfers) {
+        Money::tryAdd(total, held.second.amount, total);
+    }
+    return total;
+}
+
+size_t ShardedBank::heldTransferCount() const {
+    lock_guard<mutex> lock(journalMutex);
+    return heldTransfers.size();
+}
@@ -0,0 +1,136 @@
+#ifndef SHARDEDBANK_H
+#define SHARDEDBANK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BankSystem.h"
+
+using namespace std;
+
+// The account space split across several BankingSystems ("shards"). Each
+// shard owns its accounts, ledger and data files under shard_<n>/ and is
+// driven by one worker thread, pinned to a core, that drains the shard's
+// request queue in batches and syncs the shard's log once per batch.
+//
+// An account belongs to the shard its serial falls in modulo the shard
+// count; each shard only issues serials in its own residue class, so the
+// owner of any account number is known without a lookup. The shard count
+// is recorded in the directory and cannot change afterwards.
+//
+// Operations on one account run on its shard's worker. Transfers between
+// shards use two phases, coordinated by the calling thread:
+//   prepare  the destination is checked to exist and accept the credit,
+//            then the source is debited under its own minimum balance
+//            check (a TransferOut row)
+//   commit   the destination is credited (a TransferIn row); if that now
+//            fails, the debit is returned to the source as a TransferIn
+//            from the destination
+// Each cross-shard transfer is logged to transfers.log before its debit
+// and marked finished after its commit, so a restart can complete a
+// transfer that was debited but never credited. Its ID goes into the
+// journal and into every ledger row it posts, and is never reissued: the
+// journal also records the next ID to hand out.
+//
+// If the refund fails too (the source was deactivated meanwhile), the
+// transfer is held: it fails with TransferHeld, its journal entry stays
+// open, and every restart tries to complete it again.
+class ShardedBank {
+private:
+    struct Request {
+        function<Result(BankingSystem&)> operation;
+        promise<Result> done;
+    };
+    struct Shard {
+        unique_ptr<BankingSystem> bank;
+        mutex queueMutex;
+        condition_variable ready;
+        vector<Request> queue;
+        bool stopping = false;
+        thread worker;
+    };
+    // A cross-shard transfer between its journal entry and its finish mark
+    struct PendingTransfer {
+        AccountId from;
+        AccountId to;
+        Money amount;
+        int64_t timestamp;
+    };
+
+    const size_t JOURNAL_ROTATE_BYTES = 4 * 1024 * 1024;
+
+    string directory;
+    vector<unique_ptr<Shard>> shards;
+    atomic<unsigned> nextOpenShard;
+
+    mutable mutex journalMutex;
+    WriteAheadLog journal;
+    string journalFile;
+    uint32_t nextTransferId;
+    unordered_map<uint32_t, PendingTransfer> pendingTransfers;
+    // Debited, but neither credited nor returned
+    unordered_map<uint32_t, PendingTransfer> heldTransfers;
+
+    void runWorker(Shard& shard);
+    static future<Result> enqueue(Shard& shard, function<Result(BankingSystem&)> operation);
+    uint32_t beginTransfer(const PendingTransfer& transfer);
+    void finishTransfer(uint32_t transferId);
+    void holdTransfer(uint32_t transferId);
+    bool rewriteJournal();
+    void recoverTransfers();
+    Result completeTransfer(uint32_t transferId, const PendingTransfer& transfer);
+    static string journalRecord(uint32_t transferId, const PendingTransfer& transfer);
+    string nextIdRecord() const { return "N|" + to_string(nextTransferId); }
+
+public:
+    // shardCount = 0 uses one shard per core
+    ShardedBank(const string& dataDirectory, unsigned shardCount);
+    ~ShardedBank();
+    ShardedBank(const ShardedBank&) = delete;
+    ShardedBank& operator=(const ShardedBank&) = delete;
+
+    unsigned shardCount() const { return static_cast<unsigned>(shards.size()); }
+    unsigned shardOf(AccountId account) const;
+    // Direct access for loading and inspection; operations should go
+    // through submit() so they run on the shard's worker
+    BankingSystem& shard(unsigned index) { return *shards[index]->bank; }
+
+    // Queues an operation on the shard owning account. The future is ready
+    // once the operation has run and its log records are on disk. Must not
+    // be waited on from inside another shard operation.
+    future<Result> submit(AccountId account, function<Result(BankingSystem&)> operation);
+
+    // Every operation runs on the owning shard's worker. New accounts are
+    // spread over the shards in turn. Opening and logging in hash and
+    // verify passwords on the calling thread, between trips to the worker,
+    // so scrypt never holds up a shard's queue.
+    Result openAccount(const string& name, const string& password,
+                       const string& accountType, Money initialDeposit);
+    Result authenticate(const string& accountNo, const string& password);
+    Result deposit(const string& accountNo, Money amount);
+    Result withdraw(const string& accountNo, Money amount);
+    Result getBalance(const string& accountNo);
+    Result transfer(const string& fromAccount, const string& toAccount, Money amount);
+    // All or nothing, as BankingSystem::transferToMany(), so every leg must
+    // credit an account in the source's shard; the first that does not is
+    // refused with BadRequest and named in accountNo
+    Result transferToMany(const string& fromAccount, const vector<TransferLeg>& legs,
+                          const string& idempotencyKey = "");
+    Result getTransactionHistory(const string& accountNo, vector<Transaction>& history,
+                                 time_t fromDate = 0, time_t toDate = 0, size_t limit = 0);
+    Result writeAccountStatement(const string& accountNo, string& filename);
+    Result deactivate(const string& accountNo);
+    // Sum over the shards plus held transfers; a cross-shard transfer
+    // between its debit and its credit is counted as neither
+    Money totalBalance() const;
+    size_t heldTransferCount() const;
+};
+
+#endif
@@ -0,0 +1,328 @@
+#include "WriteAheadLog.h"
+#include "BinaryStore.h"
+#include "Metrics.h"
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+    #include <io.h>
+    #define fsync _commit
+    #define fileno _fileno
+#else
+    #include <unistd.h>
+#endif
+
+// '#' and eight hex digits after every record
+static const size_t CHECKSUM_SUFFIX = 9;
+
+static uint32_t recordChecksum(string_view record) {
+    uint64_t checksum = dataChecksum(record.data(), record.size(), CHECKSUM_BASIS);
+    return static_cast<uint32_t>(checksum ^ (checksum >> 32));
+}
+
+WriteAheadLog::WriteAheadLog(const string& logPath, size_t batch)
+    : path(logPath), file(nullptr), ring(RING_SLOTS), claimed(0), taken(0), durable(0), writeFailed(false),
+      bytesLogged(0), syncBatch(batch ? batch : 1), writerSleeping(false), durableWaiters(0), spaceWaiters(0),
+      stopping(false) {
+    for (size_t i = 0; i < RING_SLOTS; i++) {
+        ring[i].sequence.store(i, memory_order_relaxed);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+// Cuts a torn final line left by a crash back to the last complete record,
+// so the next record appended starts a line of its own
+static bool trimTornTail(const string& logPath) {
+    ifstream in(logPath, ios::binary | ios::ate);
+    if (!in) return true;
+    streamoff end = in.tellg();
+    streamoff keep = end;
+    char c = '\n';
+    while (keep > 0) {
+        in.seekg(keep - 1);
+        if (!in.get(c) || c == '\n') break;
+        keep--;
+    }
+    in.close();
+    if (keep == end) return true;
+    error_code error;
+    filesystem::resize_file(logPath, static_cast<uintmax_t>(keep), error);
+    return !error;
+}
+
+bool WriteAheadLog::open() {
+    if (!file) {
+        if (!trimTornTail(path)) return false;
+        file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+        fseek(file, 0, SEEK_END);
+        bytesLogged.store(static_cast<size_t>(ftell(file)), memory_order_relaxed);
+    }
+    if (!writer.joinable()) {
+        stopping = false;
+        writer = thread(&WriteAheadLog::runWriter, this);
+    }
+    return true;
+}
+
+void WriteAheadLog::close() {
+    if (writer.joinable()) {
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        writerWake.notify_one();
+        writer.join();
+    }
+    if (!file) return;
+    fclose(file);
+    file = nullptr;
+}
+
+// seq_cst, not acquire: this load and the producer's load of
+// writerSleeping must both be in the single total order, or the writer can
+// go to sleep on a record whose producer saw it still awake
+bool WriteAheadLog::recordReady(uint64_t position) const {
+    return ring[position % RING_SLOTS].sequence.load(memory_order_seq_cst) == position + 1;
+}
+
+void WriteAheadLog::fail() {
+    writeFailed.store(true, memory_order_seq_cst);
+    lock_guard<mutex> lock(wakeMutex);
+    durableWake.notify_all();
+    spaceWake.notify_all();
+}
+
+// The ring is full. Room normally comes back within one write; a writer
+// that frees none for STALL_SECONDS fails the log.
+bool WriteAheadLog::waitForSpace(uint64_t position) {
+    spaceWaiters.fetch_add(1, memory_order_seq_cst);
+    bool freed;
+    {
+        unique_lock<mutex> lock(wakeMutex);
+        freed = spaceWake.wait_for(lock, chrono::seconds(STALL_SECONDS), [&]() {
+            return failed() || position < taken.load(memory_order_seq_cst) + RING_SLOTS;
+        });
+    }
+    spaceWaiters.fetch_sub(1, memory_order_relaxed);
+    if (!freed) fail();
+    return !failed();
+}
+
+uint64_t WriteAheadLog::append(string_view record, bool deferSync) {
+    // A position is claimed only once its slot is free, so a producer that
+    // gives up leaves no hole for the writer to wait on
+    uint64_t position = claimed.load(memory_order_relaxed);
+    for (;;) {
+        if (failed()) return 0;
+        if (position >= taken.load(memory_order_acquire) + RING_SLOTS) {
+            if (!waitForSpace(position)) return 0;
+            position = claimed.load(memory_order_relaxed);
+        } else if (claimed.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+            break;
+        }
+    }
+    // The writer released this slot before it advanced taken past it
+    Slot& slot = ring[position % RING_SLOTS];
+    char suffix[CHECKSUM_SUFFIX + 1];
+    snprintf(suffix, sizeof(suffix), "#%08x", static_cast<unsigned>(recordChecksum(record)));
+    slot.record.reserve(record.size() + CHECKSUM_SUFFIX);
+    slot.record.assign(record.data(), record.size());
+    slot.record.append(suffix, CHECKSUM_SUFFIX);
+    bytesLogged.fetch_add(slot.record.size() + 1, memory_order_relaxed);
+    slot.sequence.store(position + 1, memory_order_seq_cst);
+    if (writerSleeping.load(memory_order_seq_cst)) {
+        lock_guard<mutex> lock(wakeMutex);
+        writerWake.notify_one();
+    }
+
+    uint64_t lsn = position + 1;
+    if (!deferSync) commit(lsn);
+    return lsn;
+}
+
+// Takes every record published in order, up to MAX_WRITE_BYTES, and makes
+// them durable with one fsync. Records appended meanwhile form the next
+// group. On close the ring is drained before the thread exits.
+void WriteAheadLog::runWriter() {
+    uint64_t next = durable.load(memory_order_relaxed);
+    string batch;
+    for (;;) {
+        uint64_t end = next;
+        while (batch.size() < MAX_WRITE_BYTES && recordReady(end)) {
+            Slot& slot = ring[end % RING_SLOTS];
+            batch += slot.record;
+            batch += '\n';
+            slot.sequence.store(end + RING_SLOTS, memory_order_release);
+            end++;
+        }
+        if (end != next) {
+            taken.store(end, memory_order_seq_cst);
+            if (spaceWaiters.load(memory_order_seq_cst) > 0) {
+                lock_guard<mutex> lock(wakeMutex);
+                spaceWake.notify_all();
+            }
+        }
+
+        if (end == next) {
+            unique_lock<mutex> lock(wakeMutex);
+            writerSleeping.store(true, memory_order_seq_cst);
+            writerWake.wait(lock, [&]() {
+                return recordReady(next) || (stopping && claimed.load(memory_order_acquire) == next);
+            });
+            writerSleeping.store(false, memory_order_relaxed);
+            if (!recordReady(next)) break;
+            continue;
+        }
+
+        // After a failure the ring is still drained, so producers never
+        // wait on it, but nothing more is written
+        bool written = false;
+        if (!failed()) {
+            lock_guard<mutex> fileLock(fileMutex);
+            MetricTimer timer(Metric::LogSync);
+            written = file && fwrite(batch.data(), 1, batch.size(), file) == batch.size() &&
+                      fflush(file) == 0 && fsync(fileno(file)) == 0;
+        }
+        batch.clear();
+        next = end;
+        if (!written) {
+            if (!failed()) fail();
+            continue;
+        }
+        durable.store(next, memory_order_seq_cst);
+        if (durableWaiters.load(memory_order_seq_cst) > 0) {
+            lock_guard<mutex> lock(wakeMutex);
+            durableWake.notify_all();
+        }
+    }
+}
+
+bool WriteAheadLog::commit(uint64_t lsn) {
+    if (lsn % syncBatch.load(memory_order_relaxed) == 0) {
+        return waitDurable(lsn);
+    }
+    return !failed();
+}
+
+// Without a running writer nothing would ever become durable, so this
+// returns at once, as a sync on a closed log always has
+bool WriteAheadLog::waitDurable(uint64_t lsn) {
+    if (isDurable(lsn)) return true;
+    if (failed()) return false;
+    if (!writer.joinable()) return true;
+    durableWaiters.fetch_add(1, memory_order_seq_cst);
+    {
+        unique_lock<mutex> lock(wakeMutex);
+        durableWake.wait(lock, [&]() { return failed() || durable.load(memory_order_seq_cst) >= lsn; });
+    }
+    durableWaiters.fetch_sub(1, memory_order_relaxed);
+    return isDurable(lsn);
+}
+
+bool WriteAheadLog::sync() {
+    return waitDurable(claimed.load(memory_order_acquire));
+}
+
+// Called once a checkpoint holds everything the log describes
+void WriteAheadLog::reset() {
+    sync();
+    lock_guard<mutex> fileLock(fileMutex);
+    if (file) fclose(file);
+    bytesLogged.store(0, memory_order_relaxed);
+    file = fopen(path.c_str(), "wb");
+    if (file) {
+        fflush(file);
+        fsync(fileno(file));
+    }
+}
+
+// A checkpoint seals the current log under its own name, so the live log
+// keeps taking records while the checkpoint is written. Records appended
+// while the file is swapped land in one file or the other, and the sealed
+// file is always replayed first.
+bool WriteAheadLog::rotate(const string& sealedPath) {
+    if (!sync()) return false;
+    lock_guard<mutex> fileLock(fileMutex);
+#ifdef _WIN32
+    // An open file cannot be renamed here
+    if (file) fclose(file);
+    file = nullptr;
+#endif
+    bool moved = rename(path.c_str(), sealedPath.c_str()) == 0;
+    FILE* fresh = moved ? fopen(path.c_str(), "ab") : nullptr;
+    if (moved && !fresh) {
+        // Put the old log back and keep appending to it
+        moved = false;
+        rename(sealedPath.c_str(), path.c_str());
+    }
+#ifdef _WIN32
+    if (!fresh) fresh = fopen(path.c_str(), "ab");
+#endif
+    if (!moved) {
+        if (!file) file = fresh;
+        return false;
+    }
+    if (file) fclose(file);
+    file = fresh;
+    bytesLogged.store(0, memory_order_relaxed);
+    return true;
+}
+
+void WriteAheadLog::setSyncBatch(size_t batch) {
+    syncBatch.store(batch ? batch : 1, memory_order_relaxed);
+}
+
+size_t WriteAheadLog::size() const {
+    return bytesLogged.load(memory_order_relaxed);
+}
+
+// Splits a line into its record and checksum; false if it carries none
+static bool splitChecksum(const string& line, size_t& length, uint32_t& checksum) {
+    if (line.size() < CHECKSUM_SUFFIX || line[line.size() - CHECKSUM_SUFFIX] != '#') return false;
+    length = line.size() - CHECKSUM_SUFFIX;
+    const char* last = line.data() + line.size();
+    auto parsed = from_chars(line.data() + length + 1, last, checksum, 16);
+    return parsed.ec == errc() && parsed.ptr == last;
+}
+
+vector<string> WriteAheadLog::readRecords(const string& logPath) {
+    bool complete;
+    return readRecords(logPath, complete);
+}
+
+// Lines without a checksum are accepted only at the start of the file,
+// where a log written before records carried one is being read
+vector<string> WriteAheadLog::readRecords(const string& logPath, bool& complete) {
+    vector<string> records;
+    complete = true;
+    ifstream file(logPath, ios::binary);
+    if (!file) return records;
+
+    string line;
+    bool checked = false;
+    while (getline(file, line)) {
+        if (file.eof()) break;  // no trailing newline: interrupted write
+        if (line.empty()) continue;
+        size_t length;
+        uint32_t checksum;
+        if (splitChecksum(line, length, checksum)) {
+            line.resize(length);
+            if (recordChecksum(line) != checksum) {
+                complete = false;
+                break;
+            }
+            checked = true;
+        } else if (checked) {
+            complete = false;
+            break;
+        }
+        records.push_back(line);
+    }
+    return records;
+}
@@ -0,0 +1,119 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Append-only log of state changes made since the last checkpoint.
+// Records are single pipe-delimited lines, each followed by '#' and a hex
+// checksum of the record so a garbled line is caught when it is read back.
+//
+// Appending is lock-free: a producer claims the next position in a ring of
+// RING_SLOTS slots with one atomic add, copies its record in and publishes
+// it. One writer thread drains every published record in order, writes
+// them with a single write and fsync (group commit), and then advances the
+// durable position. A record's position + 1 is its log sequence number
+// (LSN), which the producer can wait on with waitDurable(). Producers only
+// block when the ring is full, and for at most STALL_SECONDS.
+//
+// A failed write, flush or fsync is sticky: nothing more is written, the
+// durable position stops where it was, waits return false and append()
+// refuses every later record. So is a ring that stays full for
+// STALL_SECONDS, since a writer that far behind cannot be trusted to
+// catch up. The log has to be reopened by a restart.
+class WriteAheadLog {
+private:
+    static const size_t RING_SLOTS = 4096;
+    static const size_t MAX_WRITE_BYTES = 1 << 20;
+    static const int STALL_SECONDS = 30;
+
+    // sequence == position + 1 once the record at position is published,
+    // and position + RING_SLOTS once the writer has taken it
+    struct alignas(64) Slot {
+        atomic<uint64_t> sequence;
+        string record;
+    };
+
+    string path;
+    FILE* file;
+    vector<Slot> ring;
+    atomic<uint64_t> claimed;
+    // Positions below taken have been copied out of the ring by the writer
+    atomic<uint64_t> taken;
+    atomic<uint64_t> durable;
+    atomic<bool> writeFailed;
+    atomic<size_t> bytesLogged;
+    atomic<size_t> syncBatch;
+
+    // The writer sleeps on writerWake while the ring is empty; waitDurable()
+    // sleeps on durableWake and a producer facing a full ring on spaceWake.
+    // The flags let the other side skip the mutex and notify when nobody is
+    // asleep. Both sides of each handshake store and load seq_cst, so one
+    // of them always sees the other.
+    mutex wakeMutex;
+    condition_variable writerWake;
+    condition_variable durableWake;
+    condition_variable spaceWake;
+    atomic<bool> writerSleeping;
+    atomic<unsigned> durableWaiters;
+    atomic<unsigned> spaceWaiters;
+    bool stopping;
+    thread writer;
+    // Held by the writer while it writes, and to swap the file underneath it
+    mutex fileMutex;
+
+    void runWriter();
+    bool recordReady(uint64_t position) const;
+    bool waitForSpace(uint64_t position);
+    void fail();
+
+public:
+    explicit WriteAheadLog(const string& logPath, size_t batch = 1);
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Opens the file, dropping a torn final line, and starts the writer
+    // thread
+    bool open();
+    // Writes everything appended so far, then stops the writer
+    void close();
+    // Returns the record's LSN, or 0 if the log has failed and the record
+    // was not taken. Unless deferSync is set, also waits for it to reach
+    // disk as commit() does.
+    uint64_t append(string_view record, bool deferSync = false);
+    // Waits for lsn to be durable when the sync batch calls for it: always
+    // with a batch of 1, otherwise only for every syncBatch'th record.
+    // False if the log failed first.
+    bool commit(uint64_t lsn);
+    bool waitDurable(uint64_t lsn);
+    bool isDurable(uint64_t lsn) const { return durable.load(memory_order_acquire) >= lsn; }
+    bool failed() const { return writeFailed.load(memory_order_acquire); }
+    // Waits for every record appended so far; false if any was not written
+    bool sync();
+    // Empties the file once everything appended so far is on disk
+    void reset();
+    // Moves the records logged so far to sealedPath and starts an empty log.
+    // If the new file cannot be created the old one stays in place.
+    bool rotate(const string& sealedPath);
+
+    void setSyncBatch(size_t batch);
+    size_t size() const;
+
+    // Complete records only; a torn final line from a crash is dropped.
+    // Reading stops at the first record that fails its checksum, and
+    // complete is then false: nothing after it can be trusted.
+    static vector<string> readRecords(const string& logPath);
+    static vector<string> readRecords(const string& logPath, bool& complete);
+};
+
+#endif
@@ -0,0 +1,1151 @@
+/*
+ * Benchmark driver for Riddhi's Banking System
+ *
+ * Builds synthetic data files in a scratch directory, loads them through
+ * BankingSystem and times the hot paths.
+ *
+ * Usage: ./banking_bench [--json <file>] [accounts ...]
+ *        (default sizes: 10000 100000 1000000; --json also writes every
+ *        measurement to <file> for tracking regressions between releases)
+ *        ./banking_bench --ledger [rows]
+ *        (ledger append only; default 100000000 rows)
+ *        ./banking_bench --generate <accounts> <transactions>
+ *        (writes accounts.dat and transactions.dat in the current directory)
+ */
+
+#include "BankSystem.h"
+#include "Metrics.h"
+#include "ShardedBank.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Clock = chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return chrono::duration<double, nano>(end - start).count();
+}
+
+// Numbered the way openAccount numbers them: serials from
+// FIRST_ACCOUNT_SERIAL, each with its check digit
+static string benchAccountNumber(size_t i) {
+    return formatAccountId(makeAccountId(FIRST_ACCOUNT_SERIAL + i));
+}
+
+// When the synthetic accounts were opened
+static const time_t BENCH_OPENED = 1792285920;
+
+// The ctime() text the data files hold
+static string benchDate(time_t when) {
+    tm local;
+    localtime_r(&when, &local);
+    char text[64];
+    strftime(text, sizeof(text), "%a %b %e %H:%M:%S %Y", &local);
+    return text;
+}
+
+// One measurement for the JSON report: the benchmark, the parameters it
+// ran with and the numbers it produced
+struct BenchResult {
+    string benchmark;
+    vector<pair<string, double>> params;
+    vector<pair<string, double>> metrics;
+};
+
+static vector<BenchResult> benchResults;
+
+static void record(const string& benchmark, vector<pair<string, double>> params,
+                   vector<pair<string, double>> metrics) {
+    benchResults.push_back(BenchResult{benchmark, move(params), move(metrics)});
+}
+
+static void writeJsonFields(ostream& out, const vector<pair<string, double>>& fields) {
+    out << "{";
+    for (size_t i = 0; i < fields.size(); i++) {
+        out << (i ? ", " : "") << "\"" << fields[i].first << "\": ";
+        if (isfinite(fields[i].second)) {
+            out << fields[i].second;
+        } else {
+            out << "null";
+        }
+    }
+    out << "}";
+}
+
+static bool writeJsonReport(const string& path) {
+    ostringstream out;
+    out << setprecision(12);
+    out << "{\n  \"format\": 1,\n  \"timestamp\": " << time(nullptr)
+        << ",\n  \"hardware_threads\": " << thread::hardware_concurrency()
+        << ",\n  \"transaction_bytes\": " << sizeof(Transaction) << ",\n  \"results\": [";
+    for (size_t i = 0; i < benchResults.size(); i++) {
+        const BenchResult& result = benchResults[i];
+        out << (i ? "," : "") << "\n    {\"benchmark\": \"" << result.benchmark << "\", \"params\": ";
+        writeJsonFields(out, result.params);
+        out << ", \"metrics\": ";
+        writeJsonFields(out, result.metrics);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    ofstream file(path);
+    file << out.str();
+    return static_cast<bool>(file);
+}
+
+static void writeAccountsFile(size_t count) {
+    string opened = benchDate(BENCH_OPENED);
+    ofstream file("accounts.dat");
+    for (size_t i = 0; i < count; i++) {
+        file << benchAccountNumber(i) << "|Bench User " << i << "|pass" << i << "|"
+             << 1000 + (i % 5000) << "|" << (i % 2 ? "Current" : "Savings") << "|"
+             << opened << "|" << (i % 10 != 0) << "\n";
+    }
+}
+
+// Rows are spread over the 30 days after the accounts were opened, oldest
+// first, the way the ledger is written
+static void writeTransactionsFile(size_t accounts, size_t rows) {
+    const size_t DAYS = 30;
+    vector<string> dates;
+    for (size_t day = 0; day < DAYS; day++) {
+        dates.push_back(benchDate(BENCH_OPENED + static_cast<time_t>(day * 86400)));
+    }
+
+    ofstream file("transactions.dat");
+    for (size_t i = 0; i < rows; i++) {
+        file << benchAccountNumber(i % accounts) << (i % 3 == 2 ? "|Withdrawal|" : "|Deposit|")
+             << 100 + (i % 900) << "|" << dates[i * DAYS / rows] << "|" << 5000 + (i % 7000) << "\n";
+    }
+}
+
+static void removeDataFiles() {
+    remove("accounts.dat");
+    remove("transactions.dat");
+    remove("accounts.bin");
+    remove("transactions.bin");
+    remove("banking.wal");
+    for (const auto& entry : filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.compare(0, 7, "ledger_") == 0 || name.compare(0, 12, "banking.wal.") == 0) {
+            remove(name.c_str());
+        }
+    }
+}
+
+static void benchmarkStartup(size_t count) {
+    const size_t ROWS_PER_ACCOUNT = 4;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * ROWS_PER_ACCOUNT);
+
+    double textMs;
+    auto textStart = Clock::now();
+    {
+        BankingSystem bank;
+        textMs = elapsedNs(textStart, Clock::now()) / 1e6;
+        bank.checkpoint();
+    }
+
+    double binaryMs;
+    size_t binaryBytes;
+    auto binaryStart = Clock::now();
+    {
+        BankingSystem bank;
+        binaryMs = elapsedNs(binaryStart, Clock::now()) / 1e6;
+        binaryBytes = bank.accountMemoryUsage() + bank.ledgerMemoryUsage();
+    }
+
+    // Lazy: time to the first history request. Bench accounts have no
+    // opening row, so it pages every segment in, through a 64 MB cache.
+    double lazyMs;
+    double firstRequestMs;
+    size_t lazyBytes;
+    setLazyLoading(64 << 20);
+    auto lazyStart = Clock::now();
+    {
+        BankingSystem bank;
+        lazyMs = elapsedNs(lazyStart, Clock::now()) / 1e6;
+        lazyBytes = bank.accountMemoryUsage() + bank.ledgerMemoryUsage();
+        vector<Transaction> history;
+        bank.getTransactionHistory(benchAccountNumber(count - 1), history, 0, 0, 10);
+        firstRequestMs = elapsedNs(lazyStart, Clock::now()) / 1e6;
+    }
+    setLazyLoading(0);
+
+    cout << setw(10) << count << setw(12) << count * ROWS_PER_ACCOUNT
+         << setw(14) << fixed << setprecision(1) << textMs << setw(14) << binaryMs
+         << setw(14) << lazyMs << setw(14) << firstRequestMs
+         << setw(12) << binaryBytes / (1 << 20) << setw(12) << lazyBytes / (1 << 20) << "\n";
+    record("startup", {{"accounts", count}, {"rows", count * ROWS_PER_ACCOUNT}},
+           {{"text_load_ms", textMs}, {"binary_load_ms", binaryMs}, {"lazy_load_ms", lazyMs},
+            {"lazy_first_request_ms", firstRequestMs}, {"binary_memory_bytes", binaryBytes},
+            {"lazy_memory_bytes", lazyBytes}});
+}
+
+// Text files only, parsed with one thread and then with every core
+static void benchmarkTextLoad(size_t count) {
+    const size_t ROWS_PER_ACCOUNT = 4;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * ROWS_PER_ACCOUNT);
+
+    StartupTiming timing[2];
+    unsigned threads[2] = {1, 0};
+    for (size_t run = 0; run < 2; run++) {
+        setLoadThreads(threads[run]);
+        BankingSystem bank;
+        timing[run] = bank.startupTiming();
+    }
+    setLoadThreads(0);
+
+    cout << setw(10) << count << setw(12) << count * ROWS_PER_ACCOUNT << setw(10) << timing[1].threads
+         << setw(14) << fixed << setprecision(1) << timing[0].accountsSeconds * 1e3
+         << setw(14) << timing[1].accountsSeconds * 1e3 << setw(14) << timing[0].ledgerSeconds * 1e3
+         << setw(14) << timing[1].ledgerSeconds * 1e3 << "\n";
+    record("text_load", {{"accounts", count}, {"rows", count * ROWS_PER_ACCOUNT}, {"threads", timing[1].threads}},
+           {{"accounts_1_thread_ms", timing[0].accountsSeconds * 1e3},
+            {"accounts_parallel_ms", timing[1].accountsSeconds * 1e3},
+            {"ledger_1_thread_ms", timing[0].ledgerSeconds * 1e3},
+            {"ledger_parallel_ms", timing[1].ledgerSeconds * 1e3}});
+}
+
+static void benchmarkAccountLookup(size_t count) {
+    const size_t LOOKUPS = 1000000;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+
+    auto loadStart = Clock::now();
+    BankingSystem bank;
+    auto loadEnd = Clock::now();
+
+    // Pre-build the probe keys so string construction is not timed
+    mt19937 gen(42);
+    uniform_int_distribution<size_t> dis(0, count - 1);
+    vector<string> hits, misses;
+    hits.reserve(LOOKUPS);
+    misses.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        hits.push_back(benchAccountNumber(dis(gen)));
+        misses.push_back("RX" + to_string(dis(gen)));
+    }
+
+    long long found = 0;
+    auto hitStart = Clock::now();
+    for (const auto& accNo : hits) {
+        found += bank.findAccountIndex(accNo) != -1;
+    }
+    auto hitEnd = Clock::now();
+    for (const auto& accNo : misses) {
+        found += bank.findAccountIndex(accNo) != -1;
+    }
+    auto missEnd = Clock::now();
+
+    cout << setw(10) << count
+         << setw(14) << fixed << setprecision(1) << elapsedNs(loadStart, loadEnd) / 1e6
+         << setw(14) << elapsedNs(hitStart, hitEnd) / LOOKUPS
+         << setw(14) << elapsedNs(hitEnd, missEnd) / LOOKUPS
+         << setw(10) << found << "\n";
+    record("find_account_index", {{"accounts", count}, {"lookups", LOOKUPS}},
+           {{"load_ms", elapsedNs(loadStart, loadEnd) / 1e6}, {"hit_ns", elapsedNs(hitStart, hitEnd) / LOOKUPS},
+            {"miss_ns", elapsedNs(hitEnd, missEnd) / LOOKUPS}});
+}
+
+template <typename Operation>
+static double nanosecondsPerCall(size_t calls, Operation operation) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < calls; i++) {
+        operation(i);
+    }
+    return elapsedNs(start, Clock::now()) / calls;
+}
+
+// Single-threaded cost of each core operation on a loaded bank, then of
+// writing it back out as text files and as a checkpoint
+static void benchmarkOperations(size_t count) {
+    const size_t OPS = 100000;
+    const size_t STATEMENTS = 1000;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * 4);
+    BankingSystem bank;
+    bank.setWalSyncBatch(1024);
+
+    // Every tenth bench account is inactive; probe the active ones only
+    mt19937 gen(11);
+    uniform_int_distribution<size_t> pick(0, count - 1);
+    vector<string> from, to;
+    for (size_t i = 0; i < OPS; i++) {
+        size_t a = pick(gen), b = pick(gen);
+        from.push_back(benchAccountNumber(a % 10 ? a : a ^ 1));
+        to.push_back(benchAccountNumber(b % 10 ? b : b ^ 1));
+    }
+
+    Money amount = Money::fromPaise(100);
+    long long rejected = 0;
+    double depositNs = nanosecondsPerCall(OPS, [&](size_t i) { rejected += !bank.deposit(from[i], amount).ok(); });
+    double withdrawNs = nanosecondsPerCall(OPS, [&](size_t i) { rejected += !bank.withdraw(to[i], amount).ok(); });
+    double transferNs = nanosecondsPerCall(OPS, [&](size_t i) {
+        rejected += !bank.transfer(from[i], to[i], amount).ok();
+    });
+    vector<Transaction> history;
+    double historyNs = nanosecondsPerCall(OPS, [&](size_t i) {
+        rejected += !bank.getTransactionHistory(from[i], history).ok();
+    });
+    string filename;
+    size_t statements = min(STATEMENTS, OPS);
+    double statementNs = nanosecondsPerCall(statements, [&](size_t i) {
+        rejected += !bank.writeAccountStatement(from[i], filename).ok();
+    });
+    for (size_t i = 0; i < statements; i++) {
+        remove(("statement_" + from[i] + ".txt").c_str());
+    }
+
+    auto saveStart = Clock::now();
+    bank.saveAccountsToFile();
+    bank.saveTransactionsToFile();
+    double saveMs = elapsedNs(saveStart, Clock::now()) / 1e6;
+    auto checkpointStart = Clock::now();
+    bank.checkpoint();
+    double checkpointMs = elapsedNs(checkpointStart, Clock::now()) / 1e6;
+
+    cout << setw(10) << count << fixed << setprecision(0)
+         << setw(12) << depositNs << setw(12) << withdrawNs << setw(12) << transferNs
+         << setw(12) << historyNs << setw(12) << statementNs / 1e3
+         << setprecision(1) << setw(12) << saveMs << setw(12) << checkpointMs
+         << setw(10) << rejected << "\n";
+    record("operations", {{"accounts", count}, {"ledger_rows", count * 4}, {"ops", OPS}},
+           {{"deposit_ns", depositNs}, {"withdraw_ns", withdrawNs}, {"transfer_ns", transferNs},
+            {"history_ns", historyNs}, {"statement_us", statementNs / 1e3}, {"save_text_ms", saveMs},
+            {"checkpoint_ms", checkpointMs}, {"rejected", rejected}});
+}
+
+// Cost of the metrics layer: the same deposits with timing off and on
+static void benchmarkMetricsOverhead(size_t count) {
+    const size_t OPS = 200000;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    BankingSystem bank;
+    bank.setWalSyncBatch(1024);
+
+    vector<string> keys;
+    for (size_t i = 0; i < OPS; i++) {
+        size_t a = (i * 7919) % count;
+        keys.push_back(benchAccountNumber(a % 10 ? a : a ^ 1));
+    }
+    Money amount = Money::fromPaise(100);
+    auto deposit = [&](size_t i) { bank.deposit(keys[i], amount); };
+
+    nanosecondsPerCall(OPS, deposit);
+    double offNs = nanosecondsPerCall(OPS, deposit);
+    Metrics::enable(true);
+    double onNs = nanosecondsPerCall(OPS, deposit);
+    Metrics::enable(false);
+    uint64_t timed = Metrics::histogram(Metric::Deposit).count();
+    Metrics::reset();
+
+    cout << setw(10) << count << fixed << setprecision(0) << setw(14) << offNs << setw(14) << onNs
+         << setw(12) << setprecision(1) << onNs - offNs << setw(12) << timed << "\n";
+    record("metrics_overhead", {{"accounts", count}, {"ops", OPS}},
+           {{"deposit_ns_off", offNs}, {"deposit_ns_on", onNs}, {"timed_calls", timed}});
+}
+
+// Runs calls split across threads and returns the calls per second
+template <typename Operation>
+static double callsPerSecond(unsigned threads, size_t calls, Operation operation) {
+    auto start = Clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = t; i < calls; i += threads) {
+                operation(i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return calls / (elapsedNs(start, Clock::now()) / 1e9);
+}
+
+// Logins per second per core: the first login of a legacy account (check
+// plus rehash), a full scrypt check with the session cache off, and a
+// repeat login answered by the cache
+static void benchmarkAuthentication(size_t count) {
+    const size_t CACHED_LOGINS = 1000000;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    size_t users = min(count, static_cast<size_t>(8 * threads));
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    BankingSystem bank;
+
+    // Bench account i has password "pass<i>"; every tenth one is inactive
+    vector<pair<string, string>> logins;
+    for (size_t i = 0; logins.size() < users && i < count; i++) {
+        if (i % 10 != 0) logins.emplace_back(benchAccountNumber(i), "pass" + to_string(i));
+    }
+    atomic<size_t> failed(0);
+    auto login = [&](size_t i) {
+        const auto& user = logins[i % logins.size()];
+        if (!bank.authenticate(user.first, user.second).ok()) failed++;
+    };
+
+    bank.setSessionTtl(0);
+    double upgrade = callsPerSecond(threads, logins.size(), login);
+    double hashed = callsPerSecond(threads, logins.size(), login);
+    bank.setSessionTtl(120);
+    callsPerSecond(threads, logins.size(), login);
+    double cached = callsPerSecond(threads, CACHED_LOGINS, login);
+
+    cout << setw(10) << threads << setw(8) << passwordWorkFactor() << fixed << setprecision(1)
+         << setw(14) << upgrade / threads << setw(14) << hashed / threads
+         << setw(14) << setprecision(0) << cached / threads << setw(10) << failed.load() << "\n";
+    record("authentication", {{"threads", threads}, {"scrypt_log_n", passwordWorkFactor()}},
+           {{"first_login_per_sec_per_core", upgrade / threads}, {"scrypt_login_per_sec_per_core", hashed / threads},
+            {"cached_login_per_sec_per_core", cached / threads}, {"failed", failed.load()}});
+}
+
+static size_t stringHeapBytes(const string& value) {
+    const char* text = value.data();
+    const char* self = reinterpret_cast<const char*>(&value);
+    bool inlined = text >= self && text < self + sizeof(string);
+    return inlined ? 0 : value.capacity() + 1;
+}
+
+// Footprint and full-bank scan cost of the account table, compared with
+// the previous layout of one BankAccount object (five strings) per account
+static void benchmarkAccountLayout(size_t count) {
+    const int SCANS = 20;
+
+    removeDataFiles();
+    writeAccountsFile(count);
+
+    vector<BankAccount> legacy;
+    legacy.reserve(count);
+    {
+        ifstream file("accounts.dat");
+        string line;
+        while (getline(file, line)) {
+            legacy.push_back(BankingSystem::parseAccountRecord(line));
+        }
+    }
+    size_t legacyBytes = legacy.capacity() * sizeof(BankAccount);
+    for (const auto& acc : legacy) {
+        legacyBytes += stringHeapBytes(acc.getAccountNumber()) + stringHeapBytes(acc.getAccountHolderName()) +
+                       stringHeapBytes(acc.getPassword()) + stringHeapBytes(acc.getAccountType()) +
+                       stringHeapBytes(acc.getCreationDate());
+    }
+
+    int64_t legacyTotal = 0;
+    auto legacyStart = Clock::now();
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (const auto& acc : legacy) {
+            if (acc.getActiveStatus()) legacyTotal += acc.getBalance().toPaise();
+        }
+    }
+    auto legacyEnd = Clock::now();
+
+    BankingSystem bank;
+    int64_t columnTotal = 0;
+    auto columnStart = Clock::now();
+    for (int scan = 0; scan < SCANS; scan++) {
+        columnTotal += bank.totalBalance().toPaise();
+    }
+    auto columnEnd = Clock::now();
+
+    cout << setw(10) << count
+         << setw(12) << legacyBytes / count
+         << setw(12) << bank.accountMemoryUsage() / count
+         << setw(14) << fixed << setprecision(2) << elapsedNs(legacyStart, legacyEnd) / SCANS / count
+         << setw(14) << elapsedNs(columnStart, columnEnd) / SCANS / count
+         << setw(10) << (legacyTotal == columnTotal ? "match" : "MISMATCH") << "\n";
+    record("account_layout", {{"accounts", count}},
+           {{"old_bytes_per_account", static_cast<double>(legacyBytes) / count},
+            {"new_bytes_per_account", static_cast<double>(bank.accountMemoryUsage()) / count},
+            {"old_scan_ns", elapsedNs(legacyStart, legacyEnd) / SCANS / count},
+            {"new_scan_ns", elapsedNs(columnStart, columnEnd) / SCANS / count},
+            {"totals_match", legacyTotal == columnTotal}});
+}
+
+static string readFile(const string& path) {
+    ifstream file(path, ios::binary);
+    return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+// Month-end statements: one writeAccountStatement call per account versus
+// the bulk job, which reads the ledger once and writes files in parallel
+static void benchmarkStatements(size_t count) {
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * 4);
+    BankingSystem bank;
+
+    vector<string> numbers;
+    for (size_t i = 0; i < count; i++) {
+        if (bank.isValidAccountNumber(benchAccountNumber(i))) numbers.push_back(benchAccountNumber(i));
+    }
+    auto singleStart = Clock::now();
+    string filename;
+    for (const auto& accountNo : numbers) {
+        bank.writeAccountStatement(accountNo, filename);
+    }
+    auto singleEnd = Clock::now();
+
+    StatementRunSummary summary;
+    bank.writeAllStatements("statements", 0, summary);
+    // Bulk files are named by the canonical number; the bench numbers are
+    // already canonical, so the two files must match byte for byte
+    string single = readFile("statement_" + numbers.front() + ".txt");
+    string bulk = readFile("statements/statement_" + numbers.front() + ".txt");
+    // Only the generation time may differ between the two runs
+    size_t stamp = single.find("Statement Generated: ");
+    bool same = stamp != string::npos && single.compare(0, stamp, bulk, 0, stamp) == 0 &&
+                single.substr(single.find('\n', stamp)) == bulk.substr(bulk.find('\n', stamp));
+
+    for (const auto& accountNo : numbers) {
+        remove(("statement_" + accountNo + ".txt").c_str());
+    }
+    filesystem::remove_all("statements");
+
+    double singleSeconds = elapsedNs(singleStart, singleEnd) / 1e9;
+    cout << setw(10) << numbers.size() << setw(10) << summary.threads
+         << setw(16) << fixed << setprecision(0) << numbers.size() / singleSeconds
+         << setw(16) << summary.files / summary.seconds
+         << setw(10) << (same ? "match" : "MISMATCH") << "\n";
+    record("statements", {{"accounts", numbers.size()}, {"threads", summary.threads}},
+           {{"per_account_files_per_sec", numbers.size() / singleSeconds},
+            {"bulk_files_per_sec", summary.files / summary.seconds}, {"text_match", same}});
+}
+
+template <typename Ledger>
+static void appendLedgerRows(Ledger& ledger, size_t rows) {
+    Transaction trans{};
+    trans.type = TransactionType::Deposit;
+    trans.timestamp = 1760750520;
+    for (size_t i = 0; i < rows; i++) {
+        trans.accountId = makeAccountId(FIRST_ACCOUNT_SERIAL + i % 100000);
+        trans.amount = Money::fromPaise(static_cast<int64_t>(i % 90000));
+        trans.balanceAfter = Money::fromPaise(static_cast<int64_t>(i));
+        ledger.push_back(trans);
+    }
+}
+
+// Bank-wide reports: the running per-type totals against a full scan of
+// the balance column, plus the other column and ledger scans
+static void benchmarkReports(size_t count) {
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * 4);
+    BankingSystem bank;
+    const int ROUNDS = 20;
+
+    auto runningStart = Clock::now();
+    AccountTypeTotals running{};
+    for (int round = 0; round < ROUNDS; round++) {
+        running = bank.accountTypeTotals();
+    }
+    double runningUs = elapsedNs(runningStart, Clock::now()) / 1e3 / ROUNDS;
+
+    auto scanStart = Clock::now();
+    AccountTypeTotals scanned{};
+    for (int round = 0; round < ROUNDS; round++) {
+        scanned = bank.scanAccountTypeTotals();
+    }
+    double scanUs = elapsedNs(scanStart, Clock::now()) / 1e3 / ROUNDS;
+    bool same = true;
+    for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+        same = same && running.accounts[type] == scanned.accounts[type] &&
+               running.balance[type] == scanned.balance[type];
+    }
+
+    auto belowStart = Clock::now();
+    size_t below = bank.accountsBelowMinimum().size();
+    double belowUs = elapsedNs(belowStart, Clock::now()) / 1e3;
+    auto topStart = Clock::now();
+    bank.topBalances(10);
+    double topUs = elapsedNs(topStart, Clock::now()) / 1e3;
+    auto flowStart = Clock::now();
+    vector<DailyFlow> flows = bank.dailyFlows();
+    double flowUs = elapsedNs(flowStart, Clock::now()) / 1e3;
+    size_t days = flows.size();
+    // The last week only reads that week's day partitions
+    time_t lastWeek = flows.empty() ? 0 : flows[days > 7 ? days - 7 : 0].day;
+    auto weekStart = Clock::now();
+    bank.dailyFlows(lastWeek);
+    double weekUs = elapsedNs(weekStart, Clock::now()) / 1e3;
+
+    cout << setw(10) << count << setw(12) << fixed << setprecision(2) << runningUs
+         << setw(12) << scanUs << setw(12) << belowUs << setw(12) << topUs
+         << setw(12) << flowUs << setw(12) << weekUs << setw(10) << (same ? "match" : "MISMATCH") << "\n";
+    record("reports", {{"accounts", count}, {"ledger_rows", count * 4}},
+           {{"running_totals_us", runningUs}, {"scan_totals_us", scanUs}, {"below_minimum_us", belowUs},
+            {"below_minimum_accounts", below}, {"top10_us", topUs}, {"daily_flows_us", flowUs},
+            {"last_week_flows_us", weekUs},
+            {"days", days}, {"totals_match", same}});
+}
+
+// Runs one ledger variant in a child process so each gets its own peak
+// RSS; a variant that runs out of memory only takes down its child. The
+// child sends its rows/sec and peak RSS (MB) back through a pipe.
+template <typename Ledger>
+static void benchmarkLedgerVariant(const char* name, size_t rows) {
+    int channel[2];
+    if (pipe(channel) != 0) return;
+    cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(channel[0]);
+        Ledger ledger;
+        auto start = Clock::now();
+        appendLedgerRows(ledger, rows);
+        auto end = Clock::now();
+
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double measured[2] = {rows / (elapsedNs(start, end) / 1e9), usage.ru_maxrss / 1024.0};
+        bool sent = write(channel[1], measured, sizeof(measured)) == static_cast<ssize_t>(sizeof(measured));
+        _exit(sent ? 0 : 1);
+    }
+
+    close(channel[1]);
+    double measured[2];
+    bool received = pid > 0 && read(channel[0], measured, sizeof(measured)) == static_cast<ssize_t>(sizeof(measured));
+    close(channel[0]);
+    int status = 0;
+    if (pid > 0) waitpid(pid, &status, 0);
+    if (!received) {
+        cout << setw(10) << name << setw(14) << rows << setw(16) << "failed"
+             << setw(14) << "-" << "  (" << (WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "error") << ")\n";
+        record("ledger_append", {{"rows", rows}}, {{string(name) + "_rows_per_sec", NAN}});
+        return;
+    }
+    cout << setw(10) << name << setw(14) << rows
+         << setw(16) << fixed << setprecision(0) << measured[0]
+         << setw(14) << measured[1] << "\n";
+    record("ledger_append", {{"rows", rows}},
+           {{string(name) + "_rows_per_sec", measured[0]}, {string(name) + "_peak_rss_mb", measured[1]}});
+}
+
+// Append throughput and peak RSS of the ledger, compared with the previous
+// vector<Transaction> (which copies every row each time it grows)
+static void benchmarkLedgerAppend(size_t rows) {
+    cout << "Ledger append (" << sizeof(Transaction) << " B rows)\n";
+    cout << setw(10) << "ledger" << setw(14) << "rows"
+         << setw(16) << "rows/sec" << setw(14) << "peak RSS MB" << "\n";
+    benchmarkLedgerVariant<vector<Transaction>>("vector", rows);
+    benchmarkLedgerVariant<LedgerStore>("chunked", rows);
+}
+
+// Checkpoint taken while a writer thread keeps depositing: checkpoint
+// time, the deposits that completed meanwhile, the slowest of them, and
+// how long a restart takes afterwards
+static void benchmarkCheckpoint(size_t count) {
+    removeDataFiles();
+    writeAccountsFile(count);
+    writeTransactionsFile(count, count * 4);
+
+    double checkpointMs;
+    long long during;
+    double worstUs = 0;
+    size_t segments;
+    {
+        BankingSystem bank;
+        bank.setWalSyncBatch(1024);
+        bank.checkpoint();
+
+        atomic<int> phase(0);
+        atomic<long long> completed(0);
+        thread writer([&]() {
+            mt19937 gen(7);
+            uniform_int_distribution<size_t> pick(0, count - 1);
+            while (phase.load() < 2) {
+                auto start = Clock::now();
+                bank.deposit(benchAccountNumber(pick(gen)), Money::fromPaise(100));
+                double us = elapsedNs(start, Clock::now()) / 1e3;
+                if (phase.load() == 1) {
+                    worstUs = max(worstUs, us);
+                    completed++;
+                }
+            }
+        });
+        this_thread::sleep_for(chrono::milliseconds(100));
+        phase = 1;
+        auto start = Clock::now();
+        bank.checkpoint();
+        checkpointMs = elapsedNs(start, Clock::now()) / 1e6;
+        phase = 2;
+        writer.join();
+        during = completed.load();
+        segments = bank.ledgerSegmentCount();
+    }
+
+    auto restartStart = Clock::now();
+    {
+        BankingSystem bank;
+    }
+    double restartMs = elapsedNs(restartStart, Clock::now()) / 1e6;
+
+    cout << setw(10) << count << setw(14) << fixed << setprecision(1) << checkpointMs
+         << setw(12) << during << setw(14) << worstUs
+         << setw(10) << segments << setw(14) << restartMs << "\n";
+    record("checkpoint_under_load", {{"accounts", count}},
+           {{"checkpoint_ms", checkpointMs}, {"deposits_during", during}, {"worst_deposit_us", worstUs},
+            {"segments", segments}, {"restart_ms", restartMs}});
+}
+
+// Random transfers, deposits and withdrawals from many threads at once.
+// Transfers must conserve money, so the bank total has to move by exactly
+// the net of the successful deposits and withdrawals.
+static bool benchmarkConcurrency(size_t count) {
+    const size_t TOTAL_OPS = 400000;
+    const unsigned THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    BankingSystem bank;
+    bank.setWalSyncBatch(1024);
+
+    bool conserved = true;
+    for (unsigned threads : THREAD_COUNTS) {
+        Money before = bank.totalBalance();
+        atomic<long long> netDeposits(0);
+        atomic<long long> succeeded(0);
+
+        auto start = Clock::now();
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                mt19937 gen(1000 + t);
+                uniform_int_distribution<size_t> pick(0, count - 1);
+                uniform_int_distribution<int64_t> amount(1, 50000);
+                for (size_t op = 0; op < TOTAL_OPS / threads; op++) {
+                    string from = benchAccountNumber(pick(gen));
+                    int64_t paise = amount(gen);
+                    Money value = Money::fromPaise(paise);
+                    Result result;
+                    switch (op % 4) {
+                        case 0:
+                            result = bank.deposit(from, value);
+                            if (result.ok()) netDeposits += paise;
+                            break;
+                        case 1:
+                            result = bank.withdraw(from, value);
+                            if (result.ok()) netDeposits -= paise;
+                            break;
+                        default:
+                            result = bank.transfer(from, benchAccountNumber(pick(gen)), value);
+                    }
+                    if (result.ok()) succeeded++;
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto end = Clock::now();
+
+        Money after = bank.totalBalance();
+        bool ok = (after - before).toPaise() == netDeposits.load();
+        conserved = conserved && ok;
+
+        double seconds = elapsedNs(start, end) / 1e9;
+        cout << setw(10) << threads << setw(14) << fixed << setprecision(0)
+             << (TOTAL_OPS / threads) * threads / seconds
+             << setw(12) << succeeded.load()
+             << setw(14) << (ok ? "conserved" : "MISMATCH") << "\n";
+        record("concurrency", {{"accounts", count}, {"threads", threads}},
+               {{"ops_per_sec", (TOTAL_OPS / threads) * threads / seconds},
+                {"succeeded", succeeded.load()}, {"conserved", ok}});
+    }
+    return conserved;
+}
+
+// Deposits that each wait for their log record to reach disk. The log
+// writer folds records from every waiting thread into one fsync, so
+// records per fsync grows with the number of threads.
+static void benchmarkDurableAppends(size_t count) {
+    const size_t TOTAL_OPS = 40000;
+    const unsigned THREAD_COUNTS[] = {1, 4, 16, 64};
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    BankingSystem bank;
+    bool wasEnabled = Metrics::enabled();
+    Metrics::enable(true);
+    for (unsigned threads : THREAD_COUNTS) {
+        Metrics::reset();
+        auto start = Clock::now();
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t op = t; op < TOTAL_OPS; op += threads) {
+                    bank.deposit(benchAccountNumber(1 + op % (count - 1)), Money::fromPaise(100));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = elapsedNs(start, Clock::now()) / 1e9;
+        const LatencyHistogram& deposits = Metrics::histogram(Metric::Deposit);
+        uint64_t syncs = Metrics::histogram(Metric::LogSync).count();
+        double perSync = syncs ? static_cast<double>(TOTAL_OPS) / syncs : 0.0;
+
+        cout << setw(10) << threads << setw(14) << fixed << setprecision(0) << TOTAL_OPS / seconds
+             << setw(14) << setprecision(1) << perSync << setw(14) << deposits.percentile(0.5) / 1e3
+             << setw(14) << deposits.percentile(0.99) / 1e3 << "\n";
+        record("durable_appends", {{"accounts", count}, {"threads", threads}},
+               {{"ops_per_sec", TOTAL_OPS / seconds}, {"records_per_fsync", perSync},
+                {"deposit_p50_us", deposits.percentile(0.5) / 1e3},
+                {"deposit_p99_us", deposits.percentile(0.99) / 1e3}});
+    }
+    Metrics::reset();
+    Metrics::enable(wasEnabled);
+}
+
+// One source paying out to many accounts: a loop of durable single
+// transfers against one multi-leg transfer, then a retry of it with the
+// same idempotency key, which must not post again
+static bool benchmarkMultiTransfer(size_t count) {
+    const size_t LEG_COUNTS[] = {10, 100, 1000, 5000};
+    const Money PAYMENT = Money::fromRupees(1);
+
+    removeDataFiles();
+    writeAccountsFile(count);
+    BankingSystem bank;
+    string source = benchAccountNumber(1);
+    bank.deposit(source, Money::fromRupees(10000000));
+    Money before = bank.totalBalance();
+    bool conserved = true;
+    for (size_t legCount : LEG_COUNTS) {
+        // Every tenth bench account is inactive
+        vector<TransferLeg> legs;
+        for (size_t i = 2; legs.size() < legCount && i < count; i++) {
+            if (i % 10 != 0) legs.push_back({parseAccountId(benchAccountNumber(i)), PAYMENT});
+        }
+
+        auto loopStart = Clock::now();
+        for (const auto& leg : legs) {
+            bank.transfer(source, formatAccountId(leg.toAccount), leg.amount);
+        }
+        double loopMs = elapsedNs(loopStart, Clock::now()) / 1e6;
+
+        string key = "bench-" + to_string(legCount);
+        auto multiStart = Clock::now();
+        Result first = bank.transferToMany(source, legs, key);
+        double multiMs = elapsedNs(multiStart, Clock::now()) / 1e6;
+        auto retryStart = Clock::now();
+        Result retry = bank.transferToMany(source, legs, key);
+        double retryUs = elapsedNs(retryStart, Clock::now()) / 1e3;
+        Result balance = bank.getBalance(source);
+        conserved = conserved && first.ok() && retry.ok() && retry.balance == first.balance &&
+                    balance.balance == first.balance;
+
+        cout << setw(10) << legs.size() << setw(14) << fixed << setprecision(1) << loopMs << setw(14) << multiMs
+             << setw(10) << setprecision(1) << (multiMs > 0 ? loopMs / multiMs : 0.0)
+             << setw(14) << setprecision(0) << (multiMs > 0 ? legs.size() / multiMs * 1e3 : 0.0)
+             << setw(12) << setprecision(1) << retryUs << "\n";
+        record("multi_transfer", {{"accounts", count}, {"legs", legs.size()}},
+               {{"single_loop_ms", loopMs}, {"multi_leg_ms", multiMs},
+                {"multi_leg_legs_per_sec", multiMs > 0 ? legs.size() / multiMs * 1e3 : 0.0},
+                {"idempotent_retry_us", retryUs}});
+    }
+    conserved = conserved && bank.totalBalance() == before;
+    if (!conserved) cout << "❌ Multi-leg transfers did not conserve balances or posted a retry\n";
+    return conserved;
+}
+
+// Sharded engine throughput with 5% of operations crossing shards. The
+// bench accounts are written straight into the shard that owns them;
+// clients keep a window of requests queued on the shard workers, and
+// cross-shard transfers go through the two-phase path.
+static bool benchmarkSharding(size_t count) {
+    const size_t TOTAL_OPS = 200000;
+    const unsigned CLIENTS = 8;
+    const size_t WINDOW = 64;
+    const unsigned SHARD_COUNTS[] = {1, 2, 4, 8};
+
+    bool conserved = true;
+    for (unsigned shardCount : SHARD_COUNTS) {
+        filesystem::remove_all("shards");
+        filesystem::create_directories("shards");
+        ofstream("shards/shards") << shardCount << "\n";
+        {
+            vector<ofstream> files;
+            for (unsigned i = 0; i < shardCount; i++) {
+                filesystem::create_directories("shards/shard_" + to_string(i));
+                files.emplace_back("shards/shard_" + to_string(i) + "/accounts.dat");
+            }
+            string opened = benchDate(BENCH_OPENED);
+            for (size_t i = 0; i < count; i++) {
+                AccountId id = parseAccountId(benchAccountNumber(i));
+                uint64_t key = accountSerial(id) ? accountSerial(id) : id;
+                files[key % shardCount] << benchAccountNumber(i) << "|Bench User " << i << "|pass" << i << "|"
+                                        << 1000 + (i % 5000) << "|" << (i % 2 ? "Current" : "Savings") << "|"
+                                        << opened << "|" << (i % 10 != 0) << "\n";
+            }
+        }
+
+        ShardedBank bank("shards", shardCount);
+        Money before = bank.totalBalance();
+        atomic<long long> netDeposits(0);
+        atomic<long long> succeeded(0);
+        atomic<long long> crossShard(0);
+
+        auto start = Clock::now();
+        vector<thread> clients;
+        for (unsigned c = 0; c < CLIENTS; c++) {
+            clients.emplace_back([&, c]() {
+                mt19937 gen(2000 + c);
+                uniform_int_distribution<size_t> pick(0, count - 1);
+                uniform_int_distribution<int64_t> amount(1, 50000);
+                vector<pair<future<Result>, int64_t>> window;
+                auto settle = [&](pair<future<Result>, int64_t>& pending) {
+                    if (pending.first.get().ok()) {
+                        succeeded++;
+                        netDeposits += pending.second;
+                    }
+                };
+                for (size_t op = 0; op < TOTAL_OPS / CLIENTS; op++) {
+                    size_t i = pick(gen);
+                    string from = benchAccountNumber(i);
+                    AccountId fromId = parseAccountId(from);
+                    int64_t paise = amount(gen);
+                    Money value = Money::fromPaise(paise);
+                    if (op % 20 == 19) {
+                        string to = benchAccountNumber(pick(gen));
+                        if (bank.shardOf(parseAccountId(to)) != bank.shardOf(fromId)) crossShard++;
+                        if (bank.transfer(from, to, value).ok()) succeeded++;
+                        continue;
+                    }
+                    // Same-shard partner for transfers
+                    size_t j = pick(gen);
+                    while (bank.shardOf(parseAccountId(benchAccountNumber(j))) != bank.shardOf(fromId)) {
+                        j = (j + 1) % count;
+                    }
+                    string to = benchAccountNumber(j);
+                    function<Result(BankingSystem&)> operation;
+                    int64_t net = 0;
+                    switch (op % 4) {
+                        case 0:
+                            operation = [from, value](BankingSystem& b) { return b.deposit(from, value); };
+                            net = paise;
+                            break;
+                        case 1:
+                            operation = [from, value](BankingSystem& b) { return b.withdraw(from, value); };
+                            net = -paise;
+                            break;
+                        default:
+                            operation = [from, to, value](BankingSystem& b) { return b.transfer(from, to, value); };
+                    }
+                    window.emplace_back(bank.submit(fromId, move(operation)), net);
+                    if (window.size() == WINDOW) {
+                        for (auto& pending : window) {
+                            settle(pending);
+                        }
+                        window.clear();
+                    }
+                }
+                for (auto& pending : window) {
+                    settle(pending);
+                }
+            });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        auto end = Clock::now();
+
+        Money after = bank.totalBalance();
+        bool ok = (after - before).toPaise() == netDeposits.load();
+        conserved = conserved && ok;
+
+        size_t ops = (TOTAL_OPS / CLIENTS) * CLIENTS;
+        double seconds = elapsedNs(start, end) / 1e9;
+        cout << setw(10) << shardCount << setw(14) << fixed << setprecision(0) << ops / seconds
+             << setw(12) << succeeded.load() << setw(12) << crossShard.load()
+             << setw(14) << (ok ? "conserved" : "MISMATCH") << "\n";
+        record("sharding", {{"accounts", count}, {"shards", shardCount}, {"clients", CLIENTS}},
+               {{"ops_per_sec", ops / seconds}, {"succeeded", succeeded.load()},
+                {"cross_shard_transfers", crossShard.load()}, {"conserved", ok}});
+    }
+    filesystem::remove_all("shards");
+    return conserved;
+}
+
+// Synthetic data set in the text formats, for loading into banking_system
+static int generateDataFiles(size_t accounts, size_t rows) {
+    if (accounts == 0) {
+        cerr << "At least one account is required\n";
+        return 1;
+    }
+    if (filesystem::exists("accounts.dat") || filesystem::exists("transactions.dat")) {
+        cerr << "accounts.dat or transactions.dat already exists; run --generate in an empty directory\n";
+        return 1;
+    }
+    writeAccountsFile(accounts);
+    writeTransactionsFile(accounts, rows);
+    cout << "Wrote " << accounts << " accounts to accounts.dat and " << rows
+         << " transactions to transactions.dat\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--ledger") {
+        benchmarkLedgerAppend(argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--generate") {
+        if (argc < 4) {
+            cerr << "Usage: ./banking_bench --generate <accounts> <transactions>\n";
+            return 1;
+        }
+        return generateDataFiles(strtoull(argv[2], nullptr, 10), strtoull(argv[3], nullptr, 10));
+    }
+
+    // The report path is resolved before moving into the scratch directory
+    string jsonPath;
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--json" && i + 1 < argc) {
+            jsonPath = filesystem::absolute(argv[++i]).string();
+        } else {
+            sizes.push_back(strtoull(argv[i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {10000, 100000, 1000000};
+    }
+
+    char scratch[] = "/tmp/banking_bench_XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0) {
+        cerr << "Unable to create scratch directory\n";
+        return 1;
+    }
+
+    cout << "findAccountIndex lookup latency\n";
+    cout << setw(10) << "accounts" << setw(14) << "load ms"
+         << setw(14) << "hit ns/op" << setw(14) << "miss ns/op" << setw(10) << "found" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkAccountLookup(count);
+        }
+    }
+
+    cout << "\nCore operations, single thread (ns/op; statement us/op; save and checkpoint ms)\n";
+    cout << setw(10) << "accounts" << setw(12) << "deposit" << setw(12) << "withdraw"
+         << setw(12) << "transfer" << setw(12) << "history" << setw(12) << "statement"
+         << setw(12) << "save text" << setw(12) << "checkpoint" << setw(10) << "rejected" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkOperations(count);
+        }
+    }
+
+    cout << "\nMetrics overhead (deposit ns/op with timing off and on)\n";
+    cout << setw(10) << "accounts" << setw(14) << "off" << setw(14) << "on"
+         << setw(12) << "delta" << setw(12) << "timed" << "\n";
+    benchmarkMetricsOverhead(sizes.front());
+
+    cout << "\nAuthentication (logins/sec per core)\n";
+    cout << setw(10) << "threads" << setw(8) << "log2 N" << setw(14) << "first login"
+         << setw(14) << "scrypt" << setw(14) << "cached" << setw(10) << "failed" << "\n";
+    benchmarkAuthentication(sizes.front());
+
+    cout << "\nStartup load time (text, binary checkpoint, lazy binary) and memory after startup\n";
+    cout << setw(10) << "accounts" << setw(12) << "rows"
+         << setw(14) << "text ms" << setw(14) << "binary ms" << setw(14) << "lazy ms"
+         << setw(14) << "1st req ms" << setw(12) << "binary MB" << setw(12) << "lazy MB" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkStartup(count);
+        }
+    }
+
+    cout << "\nText file load (ms), one parser thread against every core\n";
+    cout << setw(10) << "accounts" << setw(12) << "rows" << setw(10) << "threads"
+         << setw(14) << "accts 1 thr" << setw(14) << "accts par" << setw(14) << "ledger 1 thr"
+         << setw(14) << "ledger par" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkTextLoad(count);
+        }
+    }
+
+    cout << "\nAccount table layout (bytes per account, full scan ns per account)\n";
+    cout << setw(10) << "accounts" << setw(12) << "old B/acct" << setw(12) << "new B/acct"
+         << setw(14) << "old scan ns" << setw(14) << "new scan ns" << setw(10) << "total" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkAccountLayout(count);
+        }
+    }
+
+    cout << "\nCheckpoint under load (deposits keep running)\n";
+    cout << setw(10) << "accounts" << setw(14) << "checkpt ms" << setw(12) << "deposits"
+         << setw(14) << "worst us" << setw(10) << "segments" << setw(14) << "restart ms" << "\n";
+    for (size_t count : sizes) {
+        if (count > 0) {
+            benchmarkCheckpoint(count);
+        }
+    }
+
+    cout << "\nMonth-end statements (files/sec)\n";
+    cout << setw(10) << "accounts" << setw(10) << "threads" << setw(16) << "per-account"
+         << setw(16) << "bulk" << setw(10) << "text" << "\n";
+    benchmarkStatements(sizes.front());
+
+    cout << "\nReports (us per call)\n";
+    cout << setw(10) << "accounts" << setw(12) << "running" << setw(12) << "scan" << setw(12) << "below-min"
+         << setw(12) << "top-10" << setw(12) << "daily" << setw(12) << "last-week" << setw(10) << "totals" << "\n";
+    for (size_t count : sizes) {
+        benchmarkReports(count);
+    }
+
+    cout << "\n";
+    benchmarkLedgerAppend(10000000);
+
+    cout << "\nConcurrent operations on " << sizes.front() << " accounts\n";
+    cout << setw(10) << "threads" << setw(14) << "ops/sec"
+         << setw(12) << "succeeded" << setw(14) << "balance" << "\n";
+    bool conserved = benchmarkConcurrency(sizes.front());
+
+    cout << "\nDurable deposits (each waits for its log record to reach disk)\n";
+    cout << setw(10) << "threads" << setw(14) << "ops/sec" << setw(14) << "recs/fsync"
+         << setw(14) << "p50 us" << setw(14) << "p99 us" << "\n";
+    benchmarkDurableAppends(sizes.front());
+
+    cout << "\nPayout from one account (single transfers in a loop against one multi-leg transfer)\n";
+    cout << setw(10) << "legs" << setw(14) << "loop ms" << setw(14) << "multi ms" << setw(10) << "speedup"
+         << setw(14) << "legs/sec" << setw(12) << "retry us" << "\n";
+    conserved = benchmarkMultiTransfer(sizes.front()) && conserved;
+
+    cout << "\nSharded engine on " << sizes.front() << " accounts (5% of operations are cross-shard transfers)\n";
+    cout << setw(10) << "shards" << setw(14) << "ops/sec" << setw(12) << "succeeded"
+         << setw(12) << "cross" << setw(14) << "balance" << "\n";
+    conserved = benchmarkSharding(sizes.front()) && conserved;
+
+    removeDataFiles();
+    rmdir(scratch);
+    if (!jsonPath.empty()) {
+        if (!writeJsonReport(jsonPath)) {
+            cerr << "Unable to write " << jsonPath << "\n";
+            return 1;
+        }
+        cout << "\nResults written to " << jsonPath << "\n";
+    }
+    return conserved ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/*
+ * Load generator for ./banking_system --serve
+ *
+ * Opens accounts through the wire protocol, then drives a mix of
+ * deposits, balance checks, withdrawals and transfers from several
+ * connections, each keeping a fixed number of requests in flight
+ * (pipelining), and reports throughput and latency percentiles. When the
+ * server runs with BANKING_METRICS set, its own timing report follows.
+ *
+ * Usage: ./banking_loadgen [address] [connections] [depth] [requests] [accounts]
+ *        address is a port on 127.0.0.1 or unix:<path> (default 7878)
+ *        (defaults: 4 connections, depth 16, 200000 requests, 1000 accounts)
+ */
+
+#include "BankingProtocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using Clock = chrono::steady_clock;
+
+static const char* const LOAD_PASSWORD = "loadgen";
+
+// Blocking connection that reads whole reply frames
+class Client {
+private:
+    int fd;
+    string input;
+    size_t inputStart;
+
+public:
+    Client() : fd(-1), inputStart(0) {}
+    ~Client() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool connectTo(const string& address) {
+        if (address.compare(0, 5, "unix:") == 0) {
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            string path = address.substr(5);
+            if (path.size() >= sizeof(addr.sun_path)) return false;
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, path.c_str(), path.size());
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        }
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(stoul(address)));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        return fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    bool sendAll(const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    // Body of the next reply; valid until the next call
+    bool readFrame(string_view& body) {
+        if (inputStart > 0 && inputStart == input.size()) {
+            input.clear();
+            inputStart = 0;
+        }
+        for (;;) {
+            uint32_t length;
+            size_t available = input.size() - inputStart;
+            if (peekFrameLength(input.data() + inputStart, available, length) &&
+                available >= FRAME_HEADER_BYTES + length) {
+                body = string_view(input.data() + inputStart + FRAME_HEADER_BYTES, length);
+                inputStart += FRAME_HEADER_BYTES + length;
+                return true;
+            }
+            if (inputStart > 0) {
+                input.erase(0, inputStart);
+                inputStart = 0;
+            }
+            char buffer[64 * 1024];
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) return false;
+            input.append(buffer, n);
+        }
+    }
+};
+
+struct WorkerStats {
+    vector<double> latenciesUs;
+    size_t rejected;
+    bool failed;
+};
+
+// One random request against the opened accounts
+static void writeRandomRequest(string& out, uint32_t requestId, const vector<uint64_t>& accounts, mt19937& gen) {
+    uniform_int_distribution<size_t> pick(0, accounts.size() - 1);
+    uniform_int_distribution<int> mix(0, 9);
+    uniform_int_distribution<int64_t> amount(1, 50000);
+
+    FrameWriter request(out);
+    request.put32(requestId);
+    int kind = mix(gen);
+    if (kind < 4) {
+        request.put8(static_cast<uint8_t>(Opcode::Deposit));
+        request.put64(accounts[pick(gen)]);
+        request.putString(LOAD_PASSWORD);
+        request.put64(static_cast<uint64_t>(amount(gen)));
+    } else if (kind < 7) {
+        request.put8(static_cast<uint8_t>(Opcode::Balance));
+        request.put64(accounts[pick(gen)]);
+        request.putString(LOAD_PASSWORD);
+    } else if (kind < 9) {
+        request.put8(static_cast<uint8_t>(Opcode::Withdraw));
+        request.put64(accounts[pick(gen)]);
+        request.putString(LOAD_PASSWORD);
+        request.put64(static_cast<uint64_t>(amount(gen)));
+    } else {
+        request.put8(static_cast<uint8_t>(Opcode::Transfer));
+        request.put64(accounts[pick(gen)]);
+        request.putString(LOAD_PASSWORD);
+        request.put64(accounts[pick(gen)]);
+        request.put64(static_cast<uint64_t>(amount(gen)));
+    }
+    request.finish();
+}
+
+// Keeps depth requests in flight: a new one goes out as each reply arrives
+static void runWorker(const string& address, const vector<uint64_t>& accounts, size_t requests,
+                      size_t depth, unsigned seed, WorkerStats& stats) {
+    stats.rejected = 0;
+    stats.failed = true;
+    Client client;
+    if (!client.connectTo(address)) return;
+
+    mt19937 gen(seed);
+    deque<Clock::time_point> inFlight;
+    stats.latenciesUs.reserve(requests);
+    size_t sent = 0;
+    string out;
+    while (stats.latenciesUs.size() < requests) {
+        out.clear();
+        while (sent < requests && inFlight.size() < depth) {
+            writeRandomRequest(out, static_cast<uint32_t>(sent), accounts, gen);
+            inFlight.push_back(Clock::now());
+            sent++;
+        }
+        if (!out.empty() && !client.sendAll(out)) return;
+
+        string_view body;
+        if (!client.readFrame(body)) return;
+        FrameReader reply(body.data(), body.size());
+        reply.get32();
+        uint8_t status = reply.get8();
+        if (!reply.ok()) return;
+        if (status != 0) stats.rejected++;
+        stats.latenciesUs.push_back(chrono::duration<double, micro>(Clock::now() - inFlight.front()).count());
+        inFlight.pop_front();
+    }
+    stats.failed = false;
+}
+
+// Opens the accounts the load runs against, pipelined in batches
+static bool openAccounts(const string& address, size_t count, vector<uint64_t>& accounts) {
+    const size_t BATCH = 256;
+    Client client;
+    if (!client.connectTo(address)) return false;
+
+    for (size_t first = 0; first < count; first += BATCH) {
+        size_t last = min(first + BATCH, count);
+        string out;
+        for (size_t i = first; i < last; i++) {
+            FrameWriter request(out);
+            request.put32(static_cast<uint32_t>(i));
+            request.put8(static_cast<uint8_t>(Opcode::Create));
+            request.putString("Load User " + to_string(i));
+            request.putString(LOAD_PASSWORD);
+            request.put8(static_cast<uint8_t>(i % 2));
+            request.put64(10000000);
+            request.finish();
+        }
+        if (!client.sendAll(out)) return false;
+        for (size_t i = first; i < last; i++) {
+            string_view body;
+            if (!client.readFrame(body)) return false;
+            FrameReader reply(body.data(), body.size());
+            reply.get32();
+            uint8_t status = reply.get8();
+            reply.get64();
+            uint64_t id = reply.get64();
+            if (!reply.ok() || status != 0) return false;
+            accounts.push_back(id);
+        }
+    }
+    return true;
+}
+
+// The server's own timing report, or empty if it has metrics turned off
+static string fetchServerMetrics(const string& address) {
+    Client client;
+    if (!client.connectTo(address)) return string();
+    string out;
+    FrameWriter request(out);
+    request.put32(0);
+    request.put8(static_cast<uint8_t>(Opcode::Metrics));
+    request.finish();
+    string_view body;
+    if (!client.sendAll(out) || !client.readFrame(body)) return string();
+
+    FrameReader reply(body.data(), body.size());
+    reply.get32();
+    uint8_t status = reply.get8();
+    reply.get64();
+    string report(reply.getString());
+    if (!reply.ok() || status != 0 || report.find("(enabled)") == string::npos) return string();
+    return report;
+}
+
+static double percentile(const vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    string address = (argc > 1) ? argv[1] : "7878";
+    size_t connections = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 4;
+    size_t depth = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 16;
+    size_t requests = (argc > 4) ? strtoull(argv[4], nullptr, 10) : 200000;
+    size_t accountCount = (argc > 5) ? strtoull(argv[5], nullptr, 10) : 1000;
+    if (connections == 0 || depth == 0 || requests == 0 || accountCount == 0) {
+        cerr << "connections, depth, requests and accounts must be at least 1\n";
+        return 1;
+    }
+
+    vector<uint64_t> accounts;
+    auto setupStart = Clock::now();
+    if (!openAccounts(address, accountCount, accounts)) {
+        cerr << "Unable to open accounts on " << address << "\n";
+        return 1;
+    }
+    double setupSeconds = chrono::duration<double>(Clock::now() - setupStart).count();
+
+    vector<WorkerStats> stats(connections);
+    vector<thread> workers;
+    auto start = Clock::now();
+    for (size_t c = 0; c < connections; c++) {
+        size_t share = requests / connections + (c < requests % connections ? 1 : 0);
+        workers.emplace_back(runWorker, cref(address), cref(accounts), share, depth,
+                             static_cast<unsigned>(1000 + c), ref(stats[c]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    vector<double> latencies;
+    size_t rejected = 0;
+    for (const auto& s : stats) {
+        if (s.failed) {
+            cerr << "A connection failed before finishing its requests\n";
+            return 1;
+        }
+        latencies.insert(latencies.end(), s.latenciesUs.begin(), s.latenciesUs.end());
+        rejected += s.rejected;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    cout << "Accounts opened: " << accounts.size() << " in " << fixed << setprecision(3) << setupSeconds << " s\n";
+    cout << "Requests:        " << latencies.size() << " (" << connections << " connections x depth "
+         << depth << ")\n";
+    cout << "Rejected:        " << rejected << " (business errors, e.g. insufficient balance)\n";
+    cout << "Time:            " << seconds << " s\n";
+    cout << "Requests/sec:    " << setprecision(0) << latencies.size() / seconds << "\n";
+    cout << setprecision(1);
+    cout << "Latency p50:     " << percentile(latencies, 0.50) << " us\n";
+    cout << "Latency p99:     " << percentile(latencies, 0.99) << " us\n";
+    cout << "Latency p99.9:   " << percentile(latencies, 0.999) << " us\n";
+    cout << "Latency max:     " << latencies.back() << " us\n";
+
+    string serverMetrics = fetchServerMetrics(address);
+    if (!serverMetrics.empty()) {
+        cout << "\nServer metrics:\n" << serverMetrics;
+    }
+    return 0;
+}
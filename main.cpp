@@ -12,15 +12,224 @@
  * ╚══════════════════════════════════════════════════════════════╝
  */
 
-#include "BankSystem.h"
+#include "BankingConsole.h"
+#include "BatchIngest.h"
+#include "BankingServer.h"
+#include "Metrics.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 
-int main() {
+#ifndef _WIN32
+static BankingServer* activeServer = nullptr;
+
+static void stopServer(int) {
+    if (activeServer) activeServer->stop();
+}
+#endif
+
+// --timing anywhere on the command line prints where startup time went
+static bool showStartupTiming = false;
+
+static void reportStartup(const BankingSystem& bankSystem) {
+    if (!showStartupTiming) return;
+    const StartupTiming& timing = bankSystem.startupTiming();
+    cout << "⏱️  Startup: " << fixed << setprecision(3) << timing.totalSeconds << " s ("
+         << (timing.text ? "text files" : "binary files") << ", " << timing.threads << " parser threads)\n";
+    cout << "   Accounts:  " << timing.accountsSeconds << " s, " << timing.accounts << " accounts\n";
+    cout << "   Ledger:    " << timing.ledgerSeconds << " s, " << timing.rows << " rows\n";
+    cout << "   Log:       " << timing.replaySeconds << " s\n";
+    cout.unsetf(ios::floatfield);
+}
+
+int main(int argc, char* argv[]) {
     try {
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--timing") != 0) continue;
+            showStartupTiming = true;
+            copy(argv + i + 1, argv + argc, argv + i);
+            argc--;
+            break;
+        }
+        string mode = (argc > 1) ? argv[1] : "";
+        
+        // BANKING_METRICS=<file> turns on operation timing and rewrites the
+        // report to that file every BANKING_METRICS_INTERVAL seconds (10)
+        unique_ptr<MetricsFileWriter> metricsWriter;
+        const char* metricsFile = getenv("BANKING_METRICS");
+        if (metricsFile && *metricsFile) {
+            const char* interval = getenv("BANKING_METRICS_INTERVAL");
+            Metrics::enable(true);
+            metricsWriter.reset(new MetricsFileWriter(metricsFile, interval ? stoul(interval) : 10));
+        }
+        // BANKING_PASSWORD_COST=<log2 N> sets the scrypt cost of new password
+        // hashes; load tests that open many accounts lower it
+        const char* passwordCost = getenv("BANKING_PASSWORD_COST");
+        if (passwordCost && *passwordCost) {
+            setPasswordWorkFactor(stoi(passwordCost));
+        }
+        // BANKING_LOAD_THREADS=<n> caps the threads parsing the text data
+        // files (default: every core)
+        const char* loadThreads = getenv("BANKING_LOAD_THREADS");
+        if (loadThreads && *loadThreads) {
+            setLoadThreads(static_cast<unsigned>(stoul(loadThreads)));
+        }
+        // BANKING_LEDGER_CACHE_MB=<MB> starts without reading ledger history;
+        // sealed segments are paged in on first use, up to that many MB
+        const char* ledgerCache = getenv("BANKING_LEDGER_CACHE_MB");
+        if (ledgerCache && *ledgerCache) {
+            setLazyLoading(static_cast<size_t>(stoul(ledgerCache)) << 20);
+        }
+        
+        if (mode == "--convert") {
+            BankingSystem bankSystem;
+            reportStartup(bankSystem);
+            return bankSystem.convertToBinaryFormat() ? 0 : 1;
+        }
+        
+        if (mode == "--ingest" && argc > 2) {
+            string input = argv[2];
+            size_t batchSize = (argc > 3) ? stoul(argv[3]) : 8192;
+            string rejectFile = input + ".rejects";
+            ofstream rejects(rejectFile);
+            
+            BankingSystem bankSystem;
+            reportStartup(bankSystem);
+            BatchIngestor ingestor(bankSystem, batchSize);
+            IngestSummary summary = ingestor.ingestFile(input, rejects);
+            
+            cout << "📥 Ingested " << input << "\n";
+            cout << "   Rows:      " << summary.rows << "\n";
+            cout << "   Applied:   " << summary.applied << "\n";
+            cout << "   Rejected:  " << summary.rejected << " (see " << rejectFile << ")\n";
+            cout << "   Time:      " << fixed << setprecision(3) << summary.seconds << " s\n";
+            cout << "   Ops/sec:   " << setprecision(0)
+                 << (summary.seconds > 0 ? summary.rows / summary.seconds : 0.0) << "\n";
+            return 0;
+        }
+        
+        if (mode == "--statements") {
+            string directory = (argc > 2) ? argv[2] : "statements";
+            unsigned threads = (argc > 3) ? stoul(argv[3]) : 0;
+            // Optional: only postings from the last N days
+            time_t fromDate = (argc > 4) ? time(0) - stol(argv[4]) * 86400 : 0;
+            
+            BankingSystem bankSystem;
+            reportStartup(bankSystem);
+            StatementRunSummary summary;
+            Result result = bankSystem.writeAllStatements(directory, threads, summary, fromDate);
+            
+            cout << "📄 Statements written to " << directory << "/\n";
+            cout << "   Files:     " << summary.files << "\n";
+            cout << "   Rows:      " << summary.rows << "\n";
+            cout << "   Threads:   " << summary.threads << "\n";
+            cout << "   Time:      " << fixed << setprecision(3) << summary.seconds << " s\n";
+            cout << "   Files/sec: " << setprecision(0)
+                 << (summary.seconds > 0 ? summary.files / summary.seconds : 0.0) << "\n";
+            if (!result.ok()) {
+                cout << "❌ " << errorMessage(result.code) << "\n";
+                return 1;
+            }
+            return 0;
+        }
+        
+        if (mode == "--report") {
+            time_t days = (argc > 2) ? stol(argv[2]) : 30;
+            const size_t LISTED = 10;
+            
+            BankingSystem bankSystem;
+            reportStartup(bankSystem);
+            AccountTypeTotals totals = bankSystem.accountTypeTotals();
+            cout << "📊 Bank report\n";
+            cout << "   Balances by account type:\n";
+            for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+                cout << "     " << left << setw(10) << accountTypeName(static_cast<AccountType>(type)) << right
+                     << setw(10) << totals.accounts[type] << " accounts  ₹" << totals.balance[type] << "\n";
+            }
+            
+            vector<AccountBalance> below = bankSystem.accountsBelowMinimum();
+            cout << "   Below minimum balance: " << below.size() << "\n";
+            for (size_t i = 0; i < below.size() && i < LISTED; i++) {
+                cout << "     " << formatAccountId(below[i].id) << "  ₹" << below[i].balance << "\n";
+            }
+            cout << "   Top balances:\n";
+            for (const auto& top : bankSystem.topBalances(LISTED)) {
+                cout << "     " << formatAccountId(top.id) << "  ₹" << top.balance << "\n";
+            }
+            
+            cout << "   Daily flows, last " << days << " days:\n";
+            cout << "     " << left << setw(12) << "day" << right << setw(16) << "inflow" << setw(16) << "outflow"
+                 << setw(16) << "transfers" << setw(10) << "rows" << "\n";
+            for (const auto& flow : bankSystem.dailyFlows(time(0) - days * 86400, time(0))) {
+                char day[16];
+                tm local;
+#ifdef _WIN32
+                localtime_s(&local, &flow.day);
+#else
+                localtime_r(&flow.day, &local);
+#endif
+                strftime(day, sizeof(day), "%Y-%m-%d", &local);
+                cout << "     " << left << setw(12) << day << right << setw(16) << flow.inflow
+                     << setw(16) << flow.outflow << setw(16) << flow.transfers << setw(10) << flow.rows << "\n";
+            }
+            return 0;
+        }
+        
+        if (mode == "--serve") {
+#ifdef _WIN32
+            cout << "❌ --serve is not available on Windows\n";
+            return 1;
+#else
+            string address = (argc > 2) ? argv[2] : "7878";
+            unsigned threads = (argc > 3) ? stoul(argv[3]) : 0;
+            
+            // BANKING_SHARDS=<n> splits the accounts over n shards kept under
+            // shards/ (0: one per core); the first run fixes the count
+            const char* shardCount = getenv("BANKING_SHARDS");
+            unique_ptr<BankingSystem> bankSystem;
+            unique_ptr<ShardedBank> shardedBank;
+            unique_ptr<BankingServer> server;
+            if (shardCount && *shardCount) {
+                shardedBank.reset(new ShardedBank("shards", static_cast<unsigned>(stoul(shardCount))));
+                server.reset(new BankingServer(*shardedBank));
+                cout << "🧩 " << shardedBank->shardCount() << " shards under shards/\n";
+                if (shardedBank->heldTransferCount() > 0) {
+                    cout << "⚠️  " << shardedBank->heldTransferCount()
+                         << " cross-shard transfers could not be credited or returned; see shards/transfers.log\n";
+                }
+            } else {
+                bankSystem.reset(new BankingSystem());
+                reportStartup(*bankSystem);
+                server.reset(new BankingServer(*bankSystem));
+            }
+            bool listening = (address.compare(0, 5, "unix:") == 0)
+                ? server->listenUnix(address.substr(5))
+                : server->listenTcp(static_cast<uint16_t>(stoul(address)));
+            if (!listening) {
+                cout << "❌ Cannot listen on " << address << ": " << strerror(errno) << "\n";
+                return 1;
+            }
+            
+            activeServer = server.get();
+            signal(SIGINT, stopServer);
+            signal(SIGTERM, stopServer);
+            cout << "🌐 Serving on " << address << " (Ctrl+C to stop)\n";
+            server->run(threads);
+            activeServer = nullptr;
+            cout << "👋 Server stopped\n";
+            return 0;
+#endif
+        }
+        
         cout << "\nWelcome to Riddhi's Advanced Banking System!\n";
         cout << "Initializing system...\n";
         
         BankingSystem bankSystem;
-        bankSystem.runBankingSystem();
+        reportStartup(bankSystem);
+        BankingConsole console(bankSystem);
+        console.runBankingSystem();
     }
     catch (const exception& e) {
         cout << "System Error: " << e.what() << endl;
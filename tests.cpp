@@ -0,0 +1,1182 @@
+/*
+ * Behavioural tests for Riddhi's Banking System
+ *
+ * Each test works in its own directory under a scratch directory and
+ * checks what a user of the API would see: balances, ledger rows and what
+ * survives a restart.
+ *
+ * Usage: ./banking_tests   (or: make test)
+ */
+
+#include "BankSystem.h"
+#include "BatchIngest.h"
+#include "Credentials.h"
+#include "ShardedBank.h"
+#include <csignal>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool passed, const char* text, const char* file, int line) {
+    checks++;
+    if (passed) return;
+    failures++;
+    cout << "   ❌ " << file << ":" << line << ": " << text << "\n";
+}
+
+static string hex(const uint8_t* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    string text;
+    for (size_t i = 0; i < size; i++) {
+        text += digits[data[i] >> 4];
+        text += digits[data[i] & 15];
+    }
+    return text;
+}
+
+static string scryptHex(string_view password, string_view salt, int logN, int r, int p) {
+    vector<uint8_t> key(64);
+    if (!scrypt(password, salt, logN, r, p, key)) return "";
+    return hex(key.data(), key.size());
+}
+
+static void appendToFile(const string& path, const string& bytes) {
+    ofstream file(path, ios::binary | ios::app);
+    file << bytes;
+}
+
+static bool parsesTo(const string& text, int64_t paise) {
+    Money value;
+    return Money::parse(text, value) && value == Money::fromPaise(paise);
+}
+
+static bool throwsOverflow(Money a, Money b) {
+    try {
+        a += b;
+    } catch (const overflow_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Amounts are exact paise: parsing rounds once, formatting round-trips,
+// and sums that leave int64 are refused rather than wrapped
+static void testMoney() {
+    CHECK(parsesTo("123", 12300));
+    CHECK(parsesTo("123.4", 12340));
+    CHECK(parsesTo("123.45", 12345));
+    CHECK(parsesTo("0.1", 10));
+    CHECK(parsesTo(".5", 50));
+    CHECK(parsesTo("-0.05", -5));
+    CHECK(parsesTo("+7", 700));
+    CHECK(parsesTo("1.005", 101));
+    CHECK(parsesTo("1.004", 100));
+    CHECK(parsesTo("1.23457e+06", 123457000));
+    CHECK(parsesTo("92233720368547758.07", numeric_limits<int64_t>::max()));
+    Money value;
+    CHECK(!Money::parse("92233720368547758.08", value));
+    CHECK(!Money::parse("1000000000000000000000", value));
+    CHECK(!Money::parse("", value));
+    CHECK(!Money::parse("-", value));
+    CHECK(!Money::parse(".", value));
+    CHECK(!Money::parse("12a", value));
+    CHECK(!Money::parse("1.2.3", value));
+    CHECK(!Money::parse(" 5", value));
+
+    CHECK(Money::fromPaise(123450).toString() == "1234.50");
+    CHECK(Money::fromPaise(-5).toString() == "-0.05");
+    CHECK(Money::fromPaise(numeric_limits<int64_t>::min()).toString() == "-92233720368547758.08");
+    CHECK(Money::parse(Money::fromPaise(987654321).toString(), value) && value == Money::fromPaise(987654321));
+
+    Money most = Money::fromPaise(numeric_limits<int64_t>::max());
+    Money least = Money::fromPaise(numeric_limits<int64_t>::min());
+    Money sum;
+    CHECK(!Money::tryAdd(most, Money::fromPaise(1), sum));
+    CHECK(!Money::trySubtract(least, Money::fromPaise(1), sum));
+    CHECK(Money::tryAdd(most, Money::fromPaise(-1), sum) && sum == Money::fromPaise(numeric_limits<int64_t>::max() - 1));
+    CHECK(throwsOverflow(most, Money::fromPaise(1)));
+    CHECK(!throwsOverflow(most, Money()));
+
+    BankingSystem bank("money");
+    string account = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+    CHECK(bank.deposit(account, most).code == ErrorCode::AmountOverflow);
+    CHECK(bank.deposit(account, Money::fromPaise(-100)).code == ErrorCode::InvalidAmount);
+    CHECK(bank.getBalance(account).balance == Money::fromRupees(1000));
+}
+
+// A check digit catches a mistyped account number; only the old 6-digit
+// range is taken without one
+static void testAccountIds() {
+    CHECK(makeAccountId(FIRST_ACCOUNT_SERIAL) == 10000008);
+    CHECK(formatAccountId(makeAccountId(1234567)) == "RC12345674");
+    CHECK(parseAccountId("RC10000008") == 10000008);
+    CHECK(parseAccountId("RC12345674") == 12345674);
+    CHECK(accountSerial(12345674) == 1234567);
+    // One wrong digit, and two neighbours swapped
+    CHECK(parseAccountId("RC10000009") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC12345684") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC12346574") == NO_ACCOUNT);
+
+    CHECK(parseAccountId("RC100000") == 100000);
+    CHECK(parseAccountId("RC999999") == 999999);
+    CHECK(accountSerial(999999) == 0);
+    CHECK(parseAccountId("RC1") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC42") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC99999") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC1000000") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC9999999") == NO_ACCOUNT);
+
+    CHECK(parseAccountId("RC") == NO_ACCOUNT);
+    CHECK(parseAccountId("rc10000008") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC010000008") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC1000000 8") == NO_ACCOUNT);
+    CHECK(parseAccountId("RC99999999999999999999") == NO_ACCOUNT);
+
+    for (uint64_t serial = FIRST_ACCOUNT_SERIAL; serial < FIRST_ACCOUNT_SERIAL + 1000; serial++) {
+        AccountId id = makeAccountId(serial);
+        if (parseAccountId(formatAccountId(id)) != id || accountSerial(id) != serial) {
+            CHECK(false);
+            break;
+        }
+    }
+
+    BankingSystem bank("ids");
+    string account = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+    string mistyped = account;
+    mistyped.back() = mistyped.back() == '9' ? '0' : static_cast<char>(mistyped.back() + 1);
+    CHECK(bank.deposit(mistyped, Money::fromRupees(1)).code == ErrorCode::AccountNotFound);
+    CHECK(bank.deposit(account, Money::fromRupees(1)).ok());
+}
+
+static Transaction ledgerRow(AccountId account, TransactionType type, AccountId counterparty, int64_t timestamp,
+                             int64_t amount, int64_t balance, uint32_t transferId = 0) {
+    Transaction row;
+    row.accountId = account;
+    row.counterparty = counterparty;
+    row.timestamp = timestamp;
+    row.amount = Money::fromPaise(amount);
+    row.balanceAfter = Money::fromPaise(balance);
+    row.type = type;
+    row.transferId = transferId;
+    return row;
+}
+
+static bool sameRow(const Transaction& a, const Transaction& b) {
+    return a.accountId == b.accountId && a.counterparty == b.counterparty && a.timestamp == b.timestamp &&
+           a.amount == b.amount && a.balanceAfter == b.balanceAfter && a.type == b.type &&
+           a.transferId == b.transferId;
+}
+
+static bool sameRows(const vector<Transaction>& a, const vector<Transaction>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!sameRow(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+// Rows are fixed-width codes; their text form, written to the log and the
+// text ledger, parses back to the same row, and old ctime dates still read
+static void testLedgerRows() {
+    CHECK(sizeof(Transaction) == 48);
+    AccountId account = makeAccountId(FIRST_ACCOUNT_SERIAL);
+    AccountId other = makeAccountId(FIRST_ACCOUNT_SERIAL + 1);
+    const Transaction rows[] = {
+        ledgerRow(account, TransactionType::AccountOpening, NO_ACCOUNT, 1792285920, 100000, 100000),
+        ledgerRow(account, TransactionType::Deposit, NO_ACCOUNT, 1792285921, 5, 100005),
+        ledgerRow(account, TransactionType::Withdrawal, NO_ACCOUNT, 1792285922, 99905, 100),
+        ledgerRow(account, TransactionType::TransferOut, other, 1792285923, 1, 99),
+        ledgerRow(account, TransactionType::TransferIn, 123456, 1792285924, 250, 349, 4000000000u),
+        ledgerRow(account, TransactionType::AccountDeactivated, NO_ACCOUNT, 0, 0, -349),
+    };
+    for (const Transaction& row : rows) {
+        string record = BankingSystem::formatTransactionRecord(row);
+        CHECK(record.size() < BankingSystem::TRANSACTION_RECORD_MAX);
+        CHECK(sameRow(BankingSystem::parseTransactionRecord(record), row));
+    }
+    CHECK(BankingSystem::formatTransactionRecord(rows[3]) ==
+          "RC10000008|Transfer Out to RC10000016|0.01|1792285923|0.99");
+    CHECK(BankingSystem::formatTransactionRecord(rows[4]) ==
+          "RC10000008|Transfer In from RC123456|2.50|1792285924|3.49|4000000000");
+    CHECK(rows[0].description() == "Account Opening");
+    CHECK(rows[3].description() == "Transfer Out to RC10000016");
+
+    // Text ledgers from before epoch timestamps hold the ctime text
+    string date = rows[1].dateText();
+    Transaction legacy = BankingSystem::parseTransactionRecord("RC10000008|Deposit|0.05|" + date + "|1000.05");
+    CHECK(legacy.timestamp == rows[1].timestamp && legacy.type == TransactionType::Deposit);
+    TransactionType type;
+    AccountId counterparty;
+    CHECK(!BankingSystem::parseTransactionType("Refund", type, counterparty) && type == TransactionType::Other);
+
+    // The binary checkpoint holds the same rows as the log did
+    string first;
+    string second;
+    vector<Transaction> logged;
+    {
+        BankingSystem bank("rows");
+        first = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        second = bank.openAccount("Ravi", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        CHECK(bank.transfer(first, second, Money::fromPaise(12345)).ok());
+        CHECK(bank.withdraw(first, Money::fromPaise(1)).ok());
+        CHECK(bank.deactivate(first).ok());
+        bank.getTransactionHistory(first, logged);
+        CHECK(bank.checkpoint());
+    }
+    BankingSystem bank("rows");
+    vector<Transaction> loaded;
+    bank.getTransactionHistory(first, loaded);
+    CHECK(logged.size() == 4 && sameRows(logged, loaded));
+}
+
+// Rows keep their place and address as the ledger grows a chunk at a
+// time, and a bank whose ledger crosses a chunk boundary reloads intact
+static void testLedgerChunks() {
+    const size_t ROWS = LedgerStore::CHUNK_ROWS;
+    CHECK(ROWS == 65536);
+    LedgerStore ledger;
+    for (size_t i = 0; i < ROWS; i++) {
+        ledger.push_back(ledgerRow(makeAccountId(FIRST_ACCOUNT_SERIAL), TransactionType::Deposit, NO_ACCOUNT,
+                                   static_cast<int64_t>(i), static_cast<int64_t>(i), 0));
+    }
+    CHECK(ledger.chunkCount() == 1 && ledger.capacity() == ROWS);
+    const Transaction* first = &ledger[0];
+    const Transaction* last = &ledger[ROWS - 1];
+    ledger.push_back(ledgerRow(makeAccountId(FIRST_ACCOUNT_SERIAL), TransactionType::Deposit, NO_ACCOUNT,
+                               static_cast<int64_t>(ROWS), static_cast<int64_t>(ROWS), 0));
+    CHECK(ledger.size() == ROWS + 1 && ledger.chunkCount() == 2);
+    CHECK(&ledger[0] == first && &ledger[ROWS - 1] == last);
+    CHECK(&ledger[ROWS] == ledger.chunk(1));
+    CHECK(ledger[ROWS - 1].amount == Money::fromPaise(ROWS - 1) && ledger[ROWS].amount == Money::fromPaise(ROWS));
+    CHECK(ledger.dayPartitions().size() == 1 && ledger.dayPartitions()[0].end == ROWS + 1);
+    ledger.clear();
+    CHECK(ledger.empty() && ledger.chunkCount() == 0);
+
+    // Rows before startAt() live elsewhere; their chunks are never allocated
+    ledger.startAt(2 * ROWS - 1);
+    CHECK(ledger.size() == 2 * ROWS - 1 && ledger.firstResident() == 2 * ROWS - 1);
+    ledger.push_back(ledgerRow(1, TransactionType::Deposit, NO_ACCOUNT, 0, 1, 0));
+    ledger.push_back(ledgerRow(2, TransactionType::Deposit, NO_ACCOUNT, 0, 2, 0));
+    CHECK(ledger.chunkCount() == 3 && ledger.chunk(0) == nullptr && ledger.chunk(1) != nullptr);
+    CHECK(ledger[2 * ROWS - 1].accountId == 1 && ledger[2 * ROWS].accountId == 2);
+    ledger.clear();
+    ledger.reserve(ROWS + 1);
+    CHECK(ledger.chunkCount() == 2 && ledger.empty());
+
+    // One batch posts rows straddling the first boundary; they come back
+    // from the log, then from a checkpoint
+    const int ACCOUNTS = 50;
+    vector<string> accounts;
+    Money expected;
+    {
+        BankingSystem bank("chunks");
+        vector<BatchOperation> batch;
+        for (int i = 0; i < ACCOUNTS; i++) {
+            accounts.push_back(bank.openAccount("Holder", "pw", "Savings", Money::fromRupees(1000)).accountNo);
+        }
+        for (size_t i = 0; i < ROWS + 100; i++) {
+            batch.push_back({BatchOperationType::Deposit, parseAccountId(accounts[i % ACCOUNTS]), NO_ACCOUNT,
+                             Money::fromPaise(static_cast<int64_t>(i % 7 + 1))});
+        }
+        vector<Result> results;
+        bank.applyBatch(batch, results);
+        CHECK(results.size() == batch.size() && results.back().ok());
+        expected = bank.totalBalance();
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        BankingSystem bank("chunks");
+        CHECK(bank.totalBalance() == expected);
+        size_t rows = 0;
+        bool ordered = true;
+        for (const string& account : accounts) {
+            vector<Transaction> history;
+            bank.getTransactionHistory(account, history);
+            rows += history.size();
+            for (size_t i = 1; i < history.size(); i++) {
+                ordered = ordered && history[i].balanceAfter == history[i - 1].balanceAfter + history[i].amount;
+            }
+        }
+        CHECK(rows == ROWS + 100 + ACCOUNTS && ordered);
+        if (pass == 0) CHECK(bank.checkpoint());
+    }
+}
+
+static string readFile(const string& path) {
+    ifstream file(path, ios::binary);
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+// Statement text without its "Statement Generated" line, which changes
+// from run to run
+static string withoutGeneratedLine(const string& text) {
+    size_t start = text.find("Statement Generated: ");
+    if (start == string::npos) return text;
+    return text.substr(0, start) + text.substr(text.find('\n', start) + 1);
+}
+
+// One account's statement lists every row with its running balance, and
+// the bulk run writes the same file for every active account
+static void testStatements() {
+    BankingSystem bank("statements");
+    string asha = bank.openAccount("Asha Rao", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+    string ravi = bank.openAccount("Ravi", "pw", "Current", Money::fromRupees(500)).accountNo;
+    string closed = bank.openAccount("Closed", "pw", "Savings", Money::fromRupees(500)).accountNo;
+    CHECK(bank.deposit(asha, Money::fromPaise(1050)).ok());
+    CHECK(bank.transfer(asha, ravi, Money::fromRupees(200)).ok());
+    CHECK(bank.deactivate(closed).ok());
+
+    string filename;
+    CHECK(bank.writeAccountStatement(asha, filename).ok());
+    CHECK(filename == "statement_" + asha + ".txt");
+    string text = readFile(filename);
+    vector<Transaction> history;
+    bank.getTransactionHistory(asha, history);
+    CHECK(history.size() == 3);
+    string expected = "RIDDHI'S BANKING SYSTEM - ACCOUNT STATEMENT\n"
+                      "==========================================\n\n"
+                      "Account Number: " + asha + "\n"
+                      "Account Holder: Asha Rao\n"
+                      "Account Type: Savings\n"
+                      "Current Balance: ₹810.50\n"
+                      "\nTRANSACTION HISTORY:\n"
+                      "-------------------\n";
+    const char* lines[] = {" | Account Opening | ₹1000.00 | Balance: ₹1000.00\n",
+                           " | Deposit | ₹10.50 | Balance: ₹1010.50\n",
+                           " | Transfer Out to RC10000016 | ₹200.00 | Balance: ₹810.50\n"};
+    for (size_t i = 0; i < history.size() && i < 3; i++) {
+        expected += history[i].dateText() + lines[i];
+    }
+    CHECK(withoutGeneratedLine(text) == expected);
+    CHECK(text.find("\nStatement Generated: ") != string::npos);
+    CHECK(bank.writeAccountStatement("RC10000009", filename).code == ErrorCode::AccountNotFound);
+
+    StatementRunSummary summary;
+    CHECK(bank.writeAllStatements("statements/all", 3, summary).ok());
+    CHECK(summary.files == 2 && summary.rows == 5);
+    CHECK(withoutGeneratedLine(readFile("statements/all/statement_" + asha + ".txt")) == expected);
+    CHECK(bank.writeAccountStatement(ravi, filename).ok());
+    CHECK(withoutGeneratedLine(readFile("statements/all/statement_" + ravi + ".txt")) ==
+          withoutGeneratedLine(readFile(filename)));
+    CHECK(!filesystem::exists("statements/all/statement_" + closed + ".txt"));
+
+    // A period with no postings still writes every statement, with no rows
+    time_t now = time(0);
+    CHECK(bank.writeAllStatements("statements/later", 1, summary, now + 2 * 86400, now + 3 * 86400).ok());
+    CHECK(summary.files == 2 && summary.rows == 0);
+    string later = readFile("statements/later/statement_" + asha + ".txt");
+    CHECK(later.find("\nStatement Period: ") != string::npos);
+    CHECK(later.substr(later.size() - 21) == "\n-------------------\n");
+    CHECK(bank.writeAllStatements("statements/recent", 2, summary, now - 86400, now + 86400).ok());
+    CHECK(summary.rows == 5);
+}
+
+// FIPS 180-4 and RFC 7914 section 12 test vectors
+static void testCredentials() {
+    Digest abc = sha256("abc");
+    CHECK(hex(abc.data(), abc.size()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    CHECK(scryptHex("", "", 4, 1, 1) ==
+          "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+          "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906");
+    CHECK(scryptHex("password", "NaCl", 10, 8, 16) ==
+          "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+          "2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+    CHECK(scryptHex("pleaseletmein", "SodiumChloride", 14, 8, 1) ==
+          "7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2"
+          "d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887");
+
+    string stored = hashPassword("secret");
+    CHECK(isPasswordHash(stored));
+    CHECK(verifyPassword("secret", stored));
+    CHECK(!verifyPassword("Secret", stored));
+    CHECK(hashPassword("secret") != stored);
+    // Plaintext passwords from older data files still verify
+    CHECK(!isPasswordHash("secret"));
+    CHECK(verifyPassword("secret", "secret"));
+    CHECK(!verifyPassword("secreT", "secret"));
+}
+
+// Every acknowledged change comes back from the log after a restart, and a
+// record cut off by a crash is dropped without losing later ones
+static void testLogReplay() {
+    string account;
+    string other;
+    {
+        BankingSystem bank("replay");
+        account = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        other = bank.openAccount("Ravi", "pw", "Current", Money::fromRupees(500)).accountNo;
+        CHECK(bank.deposit(account, Money::fromRupees(250)).ok());
+        CHECK(bank.withdraw(account, Money::fromRupees(100)).ok());
+        CHECK(bank.transfer(account, other, Money::fromRupees(50)).ok());
+        CHECK(bank.withdraw(other, Money::fromRupees(1000)).code == ErrorCode::InsufficientBalance);
+    }
+    {
+        BankingSystem bank("replay");
+        CHECK(bank.getBalance(account).balance == Money::fromRupees(1100));
+        CHECK(bank.getBalance(other).balance == Money::fromRupees(550));
+        vector<Transaction> rows;
+        CHECK(bank.getTransactionHistory(account, rows).ok());
+        CHECK(rows.size() == 4);
+        CHECK(!rows.empty() && rows.back().type == TransactionType::TransferOut &&
+              rows.back().counterparty == parseAccountId(other));
+        CHECK(bank.totalBalance() == Money::fromRupees(1650));
+    }
+
+    // A crash part-way through a record leaves a torn final line
+    appendToFile("replay/banking.wal", "T|99|" + account + "|Deposit|5");
+    {
+        BankingSystem bank("replay");
+        CHECK(bank.getBalance(account).balance == Money::fromRupees(1100));
+        CHECK(bank.deposit(account, Money::fromRupees(1)).ok());
+    }
+    {
+        BankingSystem bank("replay");
+        CHECK(bank.getBalance(account).balance == Money::fromRupees(1101));
+        CHECK(bank.totalBalance() == Money::fromRupees(1651));
+        CHECK(bank.checkpoint());
+    }
+    {
+        BankingSystem bank("replay");
+        CHECK(bank.getBalance(account).balance == Money::fromRupees(1101));
+        vector<Transaction> rows;
+        bank.getTransactionHistory(account, rows);
+        CHECK(rows.size() == 5);
+    }
+}
+
+// A garbled record ends the valid log: replay keeps what came before it,
+// and the bank starts and takes new changes instead of failing to load
+static void testDamagedLog() {
+    string account;
+    {
+        BankingSystem bank("damaged");
+        account = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        CHECK(bank.deposit(account, Money::fromRupees(10)).ok());
+        CHECK(bank.deposit(account, Money::fromRupees(20)).ok());
+        CHECK(bank.deposit(account, Money::fromRupees(40)).ok());
+    }
+    vector<string> records = WriteAheadLog::readRecords("damaged/banking.wal");
+    CHECK(records.size() == 5);
+    {
+        // One flipped digit in the last deposit's amount
+        fstream file("damaged/banking.wal", ios::in | ios::out | ios::binary);
+        string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        size_t pos = text.rfind("|40.00|");
+        CHECK(pos != string::npos);
+        file.seekp(static_cast<streamoff>(pos + 1));
+        file.put('9');
+    }
+    bool complete = true;
+    CHECK(WriteAheadLog::readRecords("damaged/banking.wal", complete).size() == 4);
+    CHECK(!complete);
+    {
+        BankingSystem bank("damaged");
+        CHECK(bank.getBalance(account).balance == Money::fromRupees(1030));
+        CHECK(bank.deposit(account, Money::fromRupees(1)).ok());
+    }
+    {
+        // A record whose checksum holds but whose position is not a number
+        WriteAheadLog log("damaged/banking.wal");
+        log.open();
+        log.append("T|x1|" + account + "|Deposit|5.00|0|1036.00");
+        log.append("T|99|" + account + "|Deposit|5.00|0|1041.00");
+    }
+    BankingSystem bank("damaged");
+    CHECK(bank.getBalance(account).balance == Money::fromRupees(1031));
+    vector<Transaction> rows;
+    bank.getTransactionHistory(account, rows);
+    CHECK(rows.size() == 4);
+}
+
+// Settlement rows apply only when every field is where it should be
+static void testBatchIngest() {
+    BatchOperation op;
+    CHECK(BatchIngestor::parseLine("deposit,RC100001,100", op) && op.type == BatchOperationType::Deposit &&
+          op.amount == Money::fromRupees(100));
+    CHECK(BatchIngestor::parseLine("withdrawal,RC100001,2.50", op) && op.type == BatchOperationType::Withdraw);
+    CHECK(BatchIngestor::parseLine("transfer,RC100001,1,RC100002", op) && op.type == BatchOperationType::Transfer &&
+          op.toAccount == parseAccountId("RC100002"));
+    CHECK(!BatchIngestor::parseLine("deposit,RC100001,100,junk", op));
+    CHECK(!BatchIngestor::parseLine("withdraw,RC100001,100,RC100002", op));
+    CHECK(!BatchIngestor::parseLine("transfer,RC100001,1,RC100002,5", op));
+    CHECK(!BatchIngestor::parseLine("transfer,RC100001,1", op));
+    CHECK(!BatchIngestor::parseLine("deposit,RC100001", op));
+    CHECK(!BatchIngestor::parseLine("deposit,RC100001,abc", op));
+
+    BankingSystem bank("ingest");
+    string from = bank.openAccount("From", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+    string to = bank.openAccount("To", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+    {
+        ofstream file("ingest/settlement.csv");
+        file << "type,account,amount,to\n# comment\n"
+             << "deposit," << from << ",10\n"
+             << "deposit," << from << ",10," << to << "\n"
+             << "transfer," << from << ",5," << to << "\n"
+             << "transfer," << from << ",5," << to << ",1\n"
+             << "withdraw," << to << ",2000\n";
+    }
+    ostringstream rejects;
+    IngestSummary summary = BatchIngestor(bank, 2).ingestFile("ingest/settlement.csv", rejects);
+    CHECK(summary.rows == 5 && summary.applied == 2 && summary.rejected == 3);
+    CHECK(bank.getBalance(from).balance == Money::fromRupees(1005));
+    CHECK(bank.getBalance(to).balance == Money::fromRupees(1005));
+    CHECK(rejects.str().find("line 4: Malformed row") != string::npos);
+}
+
+#ifndef _WIN32
+// Once the log cannot be written, operations are refused rather than
+// acknowledged, and a restart shows exactly what was acknowledged
+static void testLogFailure() {
+    string account;
+    Money acknowledged = Money::fromRupees(500);
+    {
+        BankingSystem bank("failing");
+        account = bank.openAccount("Asha", "pw", "Savings", acknowledged).accountNo;
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit limit;
+        getrlimit(RLIMIT_FSIZE, &limit);
+        rlimit capped = limit;
+        capped.rlim_cur = filesystem::file_size("failing/banking.wal") + 300;
+        setrlimit(RLIMIT_FSIZE, &capped);
+
+        int refused = 0;
+        for (int i = 0; i < 20; i++) {
+            Result result = bank.deposit(account, Money::fromRupees(1));
+            if (result.ok()) {
+                acknowledged += Money::fromRupees(1);
+            } else {
+                CHECK(result.code == ErrorCode::IoError);
+                refused++;
+            }
+        }
+        CHECK(refused > 0);
+        CHECK(!bank.syncLog());
+        CHECK(bank.withdraw(account, Money::fromRupees(1)).code == ErrorCode::IoError);
+        setrlimit(RLIMIT_FSIZE, &limit);
+        signal(SIGXFSZ, SIG_DFL);
+    }
+    BankingSystem bank("failing");
+    CHECK(bank.getBalance(account).balance == acknowledged);
+}
+#endif
+
+// A retried multi-leg transfer posts once, before and after a restart;
+// reusing its key for other legs is refused
+static void testIdempotentTransfers() {
+    string source;
+    string first;
+    string second;
+    string closed;
+    vector<TransferLeg> legs;
+    {
+        BankingSystem bank("idempotent");
+        source = bank.openAccount("Source", "pw", "Savings", Money::fromRupees(10000)).accountNo;
+        first = bank.openAccount("First", "pw", "Savings", Money::fromRupees(500)).accountNo;
+        second = bank.openAccount("Second", "pw", "Current", Money::fromRupees(500)).accountNo;
+        closed = bank.openAccount("Closed", "pw", "Savings", Money::fromRupees(500)).accountNo;
+        CHECK(bank.deactivate(closed).ok());
+        legs = {{parseAccountId(first), Money::fromRupees(100)},
+                {parseAccountId(second), Money::fromRupees(200)},
+                {parseAccountId(first), Money::fromRupees(50)}};
+
+        Result posted = bank.transferToMany(source, legs, "payroll-1");
+        CHECK(posted.ok() && posted.balance == Money::fromRupees(9650));
+        Result retried = bank.transferToMany(source, legs, "payroll-1");
+        CHECK(retried.ok() && retried.balance == Money::fromRupees(9650));
+        CHECK(bank.getBalance(first).balance == Money::fromRupees(650));
+
+        vector<TransferLeg> changed = legs;
+        changed[0].amount = Money::fromRupees(1);
+        CHECK(bank.transferToMany(source, changed, "payroll-1").code == ErrorCode::IdempotencyConflict);
+
+        // All or nothing: a bad leg leaves every balance as it was
+        vector<TransferLeg> bad = legs;
+        bad.push_back({parseAccountId(closed), Money::fromRupees(1)});
+        Result refused = bank.transferToMany(source, bad, "payroll-2");
+        CHECK(refused.code == ErrorCode::AccountInactive && refused.accountNo == closed);
+        CHECK(bank.getBalance(source).balance == Money::fromRupees(9650));
+        CHECK(bank.getBalance(first).balance == Money::fromRupees(650));
+    }
+    {
+        BankingSystem bank("idempotent");
+        CHECK(bank.transferToMany(source, legs, "payroll-1").ok());
+        CHECK(bank.getBalance(source).balance == Money::fromRupees(9650));
+        CHECK(bank.checkpoint());
+    }
+    {
+        BankingSystem bank("idempotent");
+        CHECK(bank.transferToMany(source, legs, "payroll-1").ok());
+        CHECK(bank.getBalance(source).balance == Money::fromRupees(9650));
+        // Without a key every call posts
+        CHECK(bank.transferToMany(source, legs).ok());
+        CHECK(bank.getBalance(source).balance == Money::fromRupees(9300));
+        CHECK(bank.getBalance(second).balance == Money::fromRupees(900));
+        // A closed source is refused even for a key it used before
+        CHECK(bank.transferToMany(first, {{parseAccountId(second), Money::fromRupees(10)}}, "own").ok());
+        CHECK(bank.deactivate(first).ok());
+        CHECK(bank.transferToMany(first, {{parseAccountId(second), Money::fromRupees(10)}}, "own").code ==
+              ErrorCode::AccountInactive);
+    }
+}
+
+// A lazily loaded bank, paging sealed segments through a small cache,
+// answers every query the way a fully loaded one does
+static void testLazyLoading() {
+    vector<string> accounts;
+    {
+        BankingSystem bank("lazy");
+        for (int i = 0; i < 20; i++) {
+            accounts.push_back(bank.openAccount("Holder " + to_string(i), "pw", i % 2 ? "Current" : "Savings",
+                                                Money::fromRupees(1000 + i)).accountNo);
+        }
+        mt19937 gen(7);
+        uniform_int_distribution<size_t> pick(0, accounts.size() - 1);
+        for (int round = 0; round < 4; round++) {
+            for (int i = 0; i < 200; i++) {
+                string from = accounts[pick(gen)];
+                string to = accounts[pick(gen)];
+                if (i % 3 == 0) {
+                    bank.deposit(from, Money::fromPaise(100 + i));
+                } else if (from != to) {
+                    bank.transfer(from, to, Money::fromPaise(50 + i));
+                }
+            }
+            CHECK(bank.checkpoint());
+        }
+        CHECK(bank.deposit(accounts[0], Money::fromRupees(5)).ok());
+        CHECK(bank.ledgerSegmentCount() > 1);
+    }
+
+    setLazyLoading(0);
+    BankingSystem eager("lazy");
+    setLazyLoading(4096);
+    BankingSystem lazy("lazy");
+    setLazyLoading(0);
+
+    CHECK(eager.totalBalance() == lazy.totalBalance());
+    time_t now = time(0);
+    for (const auto& account : accounts) {
+        vector<Transaction> eagerRows;
+        vector<Transaction> lazyRows;
+        eager.getTransactionHistory(account, eagerRows);
+        lazy.getTransactionHistory(account, lazyRows);
+        CHECK(!eagerRows.empty() && sameRows(eagerRows, lazyRows));
+        eager.getTransactionHistory(account, eagerRows, now - 86400, now + 86400, 5);
+        lazy.getTransactionHistory(account, lazyRows, now - 86400, now + 86400, 5);
+        CHECK(sameRows(eagerRows, lazyRows));
+        CHECK(eager.getBalance(account).balance == lazy.getBalance(account).balance);
+    }
+    vector<DailyFlow> eagerFlows = eager.dailyFlows();
+    vector<DailyFlow> lazyFlows = lazy.dailyFlows();
+    CHECK(eagerFlows.size() == lazyFlows.size());
+    for (size_t i = 0; i < eagerFlows.size() && i < lazyFlows.size(); i++) {
+        CHECK(eagerFlows[i].inflow == lazyFlows[i].inflow && eagerFlows[i].outflow == lazyFlows[i].outflow &&
+              eagerFlows[i].rows == lazyFlows[i].rows);
+    }
+
+    // The bulk statement run reads cold segments without the table locks
+    StatementRunSummary eagerSummary;
+    StatementRunSummary lazySummary;
+    for (time_t from : {time_t(0), now - 86400}) {
+        time_t to = from ? now + 86400 : 0;
+        CHECK(eager.writeAllStatements("lazy/eager", 2, eagerSummary, from, to).ok());
+        CHECK(lazy.writeAllStatements("lazy/lazy", 3, lazySummary, from, to).ok());
+        CHECK(eagerSummary.files == accounts.size() && lazySummary.files == accounts.size());
+        CHECK(eagerSummary.rows > 0 && eagerSummary.rows == lazySummary.rows);
+        for (const auto& account : accounts) {
+            string eagerText = readFile("lazy/eager/statement_" + account + ".txt");
+            CHECK(!eagerText.empty() &&
+                  withoutGeneratedLine(eagerText) ==
+                      withoutGeneratedLine(readFile("lazy/lazy/statement_" + account + ".txt")));
+        }
+    }
+}
+
+// Money moved between shards by many threads is neither created nor lost,
+// including across a restart and a transfer cut off between its phases
+static void testShardedRecovery() {
+    const unsigned SHARDS = 3;
+    const int ACCOUNTS = 12;
+    vector<string> accounts;
+    Money opened;
+    {
+        ShardedBank bank("sharded", SHARDS);
+        for (int i = 0; i < ACCOUNTS; i++) {
+            Result result = bank.openAccount("Holder " + to_string(i), "pw", "Savings", Money::fromRupees(1000));
+            CHECK(result.ok());
+            accounts.push_back(result.accountNo);
+            opened += Money::fromRupees(1000);
+        }
+        CHECK(bank.authenticate(accounts[0], "pw").ok());
+        CHECK(bank.authenticate(accounts[0], "wrong").code == ErrorCode::AuthenticationFailed);
+
+        vector<thread> clients;
+        for (int t = 0; t < 4; t++) {
+            clients.emplace_back([&bank, &accounts, t]() {
+                mt19937 gen(t);
+                uniform_int_distribution<size_t> pick(0, accounts.size() - 1);
+                for (int i = 0; i < 300; i++) {
+                    bank.transfer(accounts[pick(gen)], accounts[pick(gen)], Money::fromRupees(1 + i % 40));
+                }
+            });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        CHECK(bank.totalBalance() == opened);
+    }
+
+    // Debited, then cut off before the credit: the journal still holds the
+    // transfer open, and an identical finished transfer shares its second
+    string from;
+    string to;
+    int64_t now = time(0);
+    uint32_t cutOff = 0;
+    {
+        ShardedBank bank("sharded", SHARDS);
+        CHECK(bank.totalBalance() == opened);
+        from = accounts[0];
+        for (const auto& account : accounts) {
+            if (bank.shardOf(parseAccountId(account)) != bank.shardOf(parseAccountId(from))) to = account;
+        }
+        CHECK(bank.transfer(from, to, Money::fromRupees(10)).ok());
+        vector<Transaction> rows;
+        bank.getTransactionHistory(from, rows);
+        CHECK(!rows.empty() && rows.back().transferId != 0);
+        cutOff = rows.empty() ? 1 : rows.back().transferId + 1;
+        Result debit = bank.submit(parseAccountId(from), [&](BankingSystem& shard) {
+            return shard.debitTransfer(from, parseAccountId(to), Money::fromRupees(10), now, cutOff);
+        }).get();
+        CHECK(debit.ok());
+    }
+    {
+        WriteAheadLog journal("sharded/transfers.log");
+        journal.open();
+        journal.append("B|" + to_string(cutOff) + "|" + to_string(parseAccountId(from)) + "|" +
+                       to_string(parseAccountId(to)) + "|1000|" + to_string(now), true);
+        CHECK(journal.sync());
+    }
+    {
+        ShardedBank bank("sharded", SHARDS);
+        CHECK(bank.totalBalance() == opened);
+        vector<Transaction> rows;
+        bank.getTransactionHistory(to, rows);
+        CHECK(!rows.empty() && rows.back().transferId == cutOff && rows.back().type == TransactionType::TransferIn);
+        // Transfer IDs are not reused after a restart
+        CHECK(bank.transfer(from, to, Money::fromRupees(1)).ok());
+        bank.getTransactionHistory(to, rows);
+        CHECK(!rows.empty() && rows.back().transferId > cutOff);
+    }
+    ShardedBank bank("sharded", SHARDS);
+    CHECK(bank.totalBalance() == opened);
+}
+
+// The destination and then the source are closed while a cross-shard
+// transfer is in flight, so neither the credit nor the refund can post:
+// the money is held, stays counted, and survives restarts in the journal
+static void testHeldTransfer() {
+    string from;
+    string to;
+    {
+        ShardedBank bank("held", 2);
+        from = bank.openAccount("From", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        to = bank.openAccount("To", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        CHECK(bank.shardOf(parseAccountId(from)) != bank.shardOf(parseAccountId(to)));
+
+        // The source's worker is held up first, so the debit, and with it
+        // the credit, waits until the destination has its own blocker
+        promise<void> releaseSource;
+        promise<void> releaseDestination;
+        shared_future<void> sourceReleased = releaseSource.get_future().share();
+        shared_future<void> destinationReleased = releaseDestination.get_future().share();
+        future<Result> sourceBlocked = bank.submit(parseAccountId(from), [sourceReleased](BankingSystem&) {
+            sourceReleased.wait();
+            return Result();
+        });
+        uintmax_t journalSize = filesystem::file_size("held/transfers.log");
+        Result result;
+        thread client([&]() { result = bank.transfer(from, to, Money::fromRupees(300)); });
+        // The journal entry is written once the destination has been checked
+        while (filesystem::file_size("held/transfers.log") == journalSize) {
+            this_thread::yield();
+        }
+        // Queued ahead of the credit: closes the destination on its worker
+        future<Result> closeDestination =
+            bank.submit(parseAccountId(to), [destinationReleased, to](BankingSystem& shard) {
+                destinationReleased.wait();
+                return shard.deactivate(to);
+            });
+        releaseSource.set_value();
+        CHECK(sourceBlocked.get().ok());
+        while (bank.getBalance(from).balance != Money::fromRupees(700)) {
+            this_thread::yield();
+        }
+        CHECK(bank.deactivate(from).ok());
+        releaseDestination.set_value();
+        client.join();
+        CHECK(closeDestination.get().ok());
+
+        CHECK(result.code == ErrorCode::TransferHeld);
+        CHECK(bank.heldTransferCount() == 1);
+        vector<Transaction> rows;
+        bank.getTransactionHistory(from, rows);
+        CHECK(!rows.empty() && rows.back().balanceAfter == Money::fromRupees(700));
+        bank.getTransactionHistory(to, rows);
+        CHECK(!rows.empty() && rows.back().balanceAfter == Money::fromRupees(1000));
+        // Closed accounts are not counted; the held money still is
+        CHECK(bank.totalBalance() == Money::fromRupees(300));
+    }
+    for (int restart = 0; restart < 2; restart++) {
+        ShardedBank bank("held", 2);
+        CHECK(bank.heldTransferCount() == 1);
+        CHECK(bank.totalBalance() == Money::fromRupees(300));
+        bool open = false;
+        for (const string& record : WriteAheadLog::readRecords("held/transfers.log")) {
+            open = open || record.compare(0, 2, "B|") == 0;
+        }
+        CHECK(open);
+    }
+}
+
+static bool sameBalances(const vector<AccountBalance>& a, const vector<AccountBalance>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].id != b[i].id || a[i].balance != b[i].balance) return false;
+    }
+    return true;
+}
+
+static time_t localDayStart(time_t when) {
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &when);
+#else
+    localtime_r(&when, &local);
+#endif
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_isdst = -1;
+    return mktime(&local);
+}
+
+// Checks dailyFlows over rows [from, to] against per-day sums taken one
+// row at a time; days without rows must come back empty
+static void checkDailyFlows(const LedgerStore& ledger, time_t from, time_t to, unsigned threads) {
+    struct Sums {
+        int64_t inflow = 0;
+        int64_t outflow = 0;
+        int64_t transfers = 0;
+        size_t rows = 0;
+    };
+    map<time_t, Sums> expected;
+    for (size_t i = 0; i < ledger.size(); i++) {
+        const Transaction& row = ledger[i];
+        if (row.timestamp < from || row.timestamp > to) continue;
+        Sums& sums = expected[localDayStart(static_cast<time_t>(row.timestamp))];
+        int64_t amount = row.amount.toPaise();
+        if (row.type == TransactionType::Deposit || row.type == TransactionType::AccountOpening) sums.inflow += amount;
+        if (row.type == TransactionType::Withdrawal) sums.outflow += amount;
+        if (row.type == TransactionType::TransferOut) sums.transfers += amount;
+        sums.rows++;
+    }
+    vector<const Transaction*> chunks;
+    for (size_t i = 0; i < ledger.chunkCount(); i++) {
+        chunks.push_back(ledger.chunk(i));
+    }
+    vector<DailyFlow> flows =
+        ReportEngine::dailyFlows(chunks, ledger.partitionsBetween(from, to), from, to, threads);
+    CHECK(!flows.empty() && flows.front().day == localDayStart(from) && flows.back().day == localDayStart(to));
+    size_t matched = 0;
+    for (const DailyFlow& flow : flows) {
+        auto it = expected.find(flow.day);
+        Sums sums = (it == expected.end()) ? Sums() : it->second;
+        matched += flow.rows;
+        CHECK(flow.inflow == Money::fromPaise(sums.inflow) && flow.outflow == Money::fromPaise(sums.outflow) &&
+              flow.transfers == Money::fromPaise(sums.transfers) && flow.rows == sums.rows);
+    }
+    size_t rows = 0;
+    for (const auto& day : expected) {
+        rows += day.second.rows;
+    }
+    CHECK(matched == rows && rows > 0);
+}
+
+// The branch-free, multi-threaded report scans give the same answers as
+// a plain loop over every account and row, whatever the thread count
+static void testReports() {
+    const size_t ACCOUNTS = 200000;
+    const int64_t THRESHOLD = 50000;
+    AccountStore store;
+    mt19937 gen(21);
+    int64_t balances[ACCOUNT_TYPES] = {0, 0};
+    size_t counts[ACCOUNT_TYPES] = {0, 0};
+    vector<AccountBalance> below;
+    vector<AccountBalance> active;
+    for (size_t i = 0; i < ACCOUNTS; i++) {
+        AccountId id = makeAccountId(FIRST_ACCOUNT_SERIAL + i);
+        AccountType type = (gen() % 3 == 0) ? AccountType::Current : AccountType::Savings;
+        Money balance = Money::fromPaise(static_cast<int64_t>(gen() % 10000000));
+        bool open = gen() % 5 != 0;
+        store.add(id, AccountStore::ColdFields{"Holder", "pw", "today"}, type, balance, open);
+        if (!open) continue;
+        balances[static_cast<size_t>(type)] += balance.toPaise();
+        counts[static_cast<size_t>(type)]++;
+        active.push_back({id, balance});
+        if (balance < Money::fromPaise(THRESHOLD)) below.push_back({id, balance});
+    }
+    // Equal balances are ordered by account ID
+    sort(below.begin(), below.end(), [](const AccountBalance& a, const AccountBalance& b) {
+        return a.balance != b.balance ? a.balance < b.balance : a.id < b.id;
+    });
+    sort(active.begin(), active.end(), [](const AccountBalance& a, const AccountBalance& b) {
+        return a.balance != b.balance ? a.balance > b.balance : a.id < b.id;
+    });
+    vector<AccountBalance> top(active.begin(), active.begin() + 100);
+
+    CHECK(store.totalActiveBalance() == Money::fromPaise(balances[0] + balances[1]));
+    for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+        size_t accounts;
+        Money balance;
+        store.activeTotals(static_cast<AccountType>(type), accounts, balance);
+        CHECK(accounts == counts[type] && balance == Money::fromPaise(balances[type]));
+    }
+    for (unsigned threads : {1u, 3u, 8u}) {
+        AccountTypeTotals totals = ReportEngine::typeTotals(store.columns(), threads);
+        for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+            CHECK(totals.accounts[type] == counts[type] && totals.balance[type] == Money::fromPaise(balances[type]));
+        }
+        CHECK(sameBalances(ReportEngine::balancesBelow(store.columns(), Money::fromPaise(THRESHOLD), threads), below));
+        CHECK(sameBalances(ReportEngine::topBalances(store.columns(), 100, threads), top));
+    }
+    CHECK(ReportEngine::topBalances(store.columns(), active.size() + 10, 3).size() == active.size());
+
+    // Rows over about twelve days, a few of them posted late with an
+    // earlier date
+    const time_t START = 1792285920;
+    LedgerStore ledger;
+    time_t now = START;
+    for (size_t i = 0; i < 300000; i++) {
+        now += static_cast<time_t>(gen() % 7);
+        time_t when = (gen() % 1000 == 0) ? now - static_cast<time_t>(gen() % 200000) : now;
+        TransactionType type = static_cast<TransactionType>(gen() % 6);
+        ledger.push_back(ledgerRow(makeAccountId(FIRST_ACCOUNT_SERIAL + gen() % 1000), type, NO_ACCOUNT,
+                                   static_cast<int64_t>(when), static_cast<int64_t>(gen() % 1000000), 0));
+    }
+    for (unsigned threads : {1u, 3u, 8u}) {
+        checkDailyFlows(ledger, START, now, threads);
+        checkDailyFlows(ledger, START + 3 * 86400 + 1234, START + 7 * 86400, threads);
+    }
+
+    BankingSystem bank("reports");
+    for (int i = 0; i < 30; i++) {
+        string account = bank.openAccount("Holder", "pw", i % 3 ? "Savings" : "Current",
+                                          Money::fromRupees(1000 + i)).accountNo;
+        if (i % 4 == 0) CHECK(bank.deactivate(account).ok());
+    }
+    AccountTypeTotals running = bank.accountTypeTotals();
+    AccountTypeTotals scanned = bank.scanAccountTypeTotals(2);
+    for (size_t type = 0; type < ACCOUNT_TYPES; type++) {
+        CHECK(running.accounts[type] == scanned.accounts[type] && running.balance[type] == scanned.balance[type]);
+    }
+    CHECK(running.balance[0] + running.balance[1] == bank.totalBalance());
+}
+
+// Rows at the very edges of UTC days land in the right partition, a late
+// row with an earlier date widens its partition's range instead of
+// reopening an old one, and every date range is inclusive at both ends
+static void testDayPartitions() {
+    const int64_t DAY = LedgerStore::SECONDS_PER_DAY;
+    const int64_t D = 20000;
+    const int64_t times[] = {D * DAY - 1, D * DAY, D * DAY + DAY - 1, D * DAY - 5000, (D + 1) * DAY,
+                             (D + 3) * DAY + 10};
+    LedgerStore ledger;
+    for (int64_t when : times) {
+        ledger.push_back(ledgerRow(1, TransactionType::Deposit, NO_ACCOUNT, when, 100, 0));
+    }
+    const vector<LedgerPartition>& partitions = ledger.dayPartitions();
+    CHECK(partitions.size() == 4);
+    if (partitions.size() == 4) {
+        CHECK(partitions[0].day == D - 1 && partitions[0].first == 0 && partitions[0].end == 1);
+        CHECK(partitions[1].day == D && partitions[1].first == 1 && partitions[1].end == 4);
+        CHECK(partitions[1].minTimestamp == times[3] && partitions[1].maxTimestamp == times[2]);
+        CHECK(partitions[2].day == D + 1 && partitions[3].day == D + 3 && partitions[3].end == 6);
+    }
+    auto days = [&ledger](int64_t from, int64_t to) {
+        vector<int64_t> found;
+        for (const LedgerPartition& partition : ledger.partitionsBetween(from, to)) {
+            found.push_back(partition.day);
+        }
+        return found;
+    };
+    // The late row in day D is older than the last second of day D - 1
+    CHECK(days(times[0], times[0]) == vector<int64_t>({D - 1, D}));
+    CHECK(days(times[1], times[1]) == vector<int64_t>({D}));
+    CHECK(days(times[2], times[2]) == vector<int64_t>({D}));
+    CHECK(days(times[2] + 1, times[4]) == vector<int64_t>({D + 1}));
+    CHECK(days(times[2] + 1, times[4] - 1).empty());
+    CHECK(days(times[4] + 1, times[5] - 1).empty());
+    CHECK(days(times[5], times[5]) == vector<int64_t>({D + 3}));
+    CHECK(days(times[5] + 1, INT64_MAX).empty());
+    CHECK(days(INT64_MIN, times[0] - 5001).empty());
+    CHECK(days(INT64_MIN, INT64_MAX).size() == 4);
+
+    // The same rows posted to an account, plus one either side of a local
+    // midnight, read back through the bank from the log and a checkpoint
+    const time_t midnight = localDayStart(static_cast<time_t>((D + 5) * DAY + DAY / 2));
+    string account;
+    {
+        BankingSystem bank("partitions");
+        account = bank.openAccount("Asha", "pw", "Savings", Money::fromRupees(1000)).accountNo;
+        uint32_t transferId = 1;
+        for (int64_t when : times) {
+            CHECK(bank.creditTransfer(account, 123456, Money::fromRupees(1), when, transferId++).ok());
+        }
+        CHECK(bank.creditTransfer(account, 123456, Money::fromRupees(1), midnight - 1, transferId++).ok());
+        CHECK(bank.creditTransfer(account, 123456, Money::fromRupees(1), midnight, transferId++).ok());
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        BankingSystem bank("partitions");
+        auto rows = [&bank, &account](time_t from, time_t to) {
+            vector<Transaction> history;
+            bank.getTransactionHistory(account, history, from, to);
+            vector<int64_t> found;
+            for (const Transaction& row : history) {
+                found.push_back(row.timestamp);
+            }
+            return found;
+        };
+        CHECK(rows(times[1], times[2]) == vector<int64_t>({times[1], times[2]}));
+        CHECK(rows(times[0], times[1]) == vector<int64_t>({times[0], times[1]}));
+        CHECK(rows(times[3], times[3]) == vector<int64_t>({times[3]}));
+        CHECK(rows(times[2] + 1, times[4] - 1).empty());
+        CHECK(rows(times[5], times[5]) == vector<int64_t>({times[5]}));
+        CHECK(rows(midnight - 1, midnight) == vector<int64_t>({midnight - 1, midnight}));
+
+        vector<DailyFlow> flows = bank.dailyFlows(midnight, midnight);
+        CHECK(flows.size() == 1 && flows[0].day == midnight && flows[0].rows == 1);
+        flows = bank.dailyFlows(midnight - 1, midnight);
+        CHECK(flows.size() == 2 && flows[0].day == localDayStart(midnight - 1) && flows[1].day == midnight);
+        CHECK(flows.size() == 2 && flows[0].rows == 1 && flows[1].rows == 1);
+        if (pass == 0) CHECK(bank.checkpoint());
+    }
+}
+
+// Text files big enough to be cut into several ranges parse to the same
+// accounts and ledger on four threads as on one
+static void testParallelLoad() {
+    const int ACCOUNTS = 20000;
+    const int ROWS = 80000;
+    mt19937 gen(24);
+    vector<string> accounts;
+    string accountText;
+    for (int i = 0; i < ACCOUNTS; i++) {
+        accounts.push_back(formatAccountId(makeAccountId(FIRST_ACCOUNT_SERIAL + i)));
+        BankAccount account(accounts.back(), "Holder " + to_string(gen() % 100000), "salt$" + to_string(gen()),
+                            Money::fromPaise(static_cast<int64_t>(gen() % 10000000)),
+                            i % 3 ? "Savings" : "Current");
+        account.setCreationDate("Sat Oct 17 10:00:00 2026");
+        account.setActiveStatus(gen() % 10 != 0);
+        accountText += BankingSystem::formatAccountRecord(account) + "\n";
+    }
+    string ledgerText;
+    for (int i = 0; i < ROWS; i++) {
+        AccountId account = makeAccountId(FIRST_ACCOUNT_SERIAL + gen() % ACCOUNTS);
+        TransactionType type = (i % 5 == 0) ? TransactionType::TransferOut : TransactionType::Deposit;
+        AccountId counterparty =
+            (type == TransactionType::TransferOut) ? makeAccountId(FIRST_ACCOUNT_SERIAL) : NO_ACCOUNT;
+        ledgerText += BankingSystem::formatTransactionRecord(
+                          ledgerRow(account, type, counterparty, 1792285920 + i, gen() % 100000, gen() % 10000000)) +
+                      "\n";
+    }
+    CHECK(accountText.size() > 1000000 && ledgerText.size() > 2000000);
+    // A torn final row is dropped either way
+    ledgerText += "RC10000008|Deposit|1.00|17922";
+    for (const char* directory : {"text1", "text4"}) {
+        filesystem::create_directories(directory);
+        appendToFile(string(directory) + "/accounts.dat", accountText);
+        appendToFile(string(directory) + "/transactions.dat", ledgerText);
+    }
+
+    setLoadThreads(1);
+    BankingSystem serial("text1");
+    setLoadThreads(4);
+    BankingSystem parallel("text4");
+    setLoadThreads(0);
+
+    CHECK(serial.startupTiming().text && serial.startupTiming().threads == 1);
+    CHECK(parallel.startupTiming().text && parallel.startupTiming().threads > 1);
+    CHECK(serial.startupTiming().accounts == ACCOUNTS && parallel.startupTiming().accounts == ACCOUNTS);
+    CHECK(serial.startupTiming().rows == ROWS && parallel.startupTiming().rows == ROWS);
+    CHECK(serial.totalBalance() == parallel.totalBalance());
+    bool same = true;
+    for (const string& account : accounts) {
+        BankAccount a;
+        BankAccount b;
+        // Closed accounts give AccountInactive on both
+        Result first = serial.getAccountDetails(account, a);
+        Result second = parallel.getAccountDetails(account, b);
+        same = same && first.code == second.code &&
+               (!first.ok() || BankingSystem::formatAccountRecord(a) == BankingSystem::formatAccountRecord(b));
+        vector<Transaction> serialRows;
+        vector<Transaction> parallelRows;
+        serial.getTransactionHistory(account, serialRows);
+        parallel.getTransactionHistory(account, parallelRows);
+        same = same && sameRows(serialRows, parallelRows);
+    }
+    CHECK(same);
+}
+
+int main() {
+    setPasswordWorkFactor(10);
+    error_code error;
+    filesystem::path scratch = filesystem::temp_directory_path(error) /
+                               ("banking_tests_" + to_string(random_device()()));
+    filesystem::create_directories(scratch, error);
+    filesystem::current_path(scratch, error);
+    if (error) {
+        cerr << "Unable to create scratch directory\n";
+        return 1;
+    }
+
+    const pair<const char*, void (*)()> tests[] = {
+        {"money", testMoney},
+        {"account IDs", testAccountIds},
+        {"ledger rows", testLedgerRows},
+        {"ledger chunks", testLedgerChunks},
+        {"statements", testStatements},
+        {"credentials", testCredentials},
+        {"log replay", testLogReplay},
+        {"damaged log", testDamagedLog},
+        {"batch ingest", testBatchIngest},
+#ifndef _WIN32
+        {"log failure", testLogFailure},
+#endif
+        {"idempotent transfers", testIdempotentTransfers},
+        {"lazy loading", testLazyLoading},
+        {"sharded recovery", testShardedRecovery},
+        {"held transfer", testHeldTransfer},
+        {"reports", testReports},
+        {"day partitions", testDayPartitions},
+        {"parallel load", testParallelLoad},
+    };
+    for (const auto& test : tests) {
+        int failed = failures;
+        test.second();
+        cout << (failures == failed ? "✅ " : "❌ ") << test.first << "\n";
+    }
+
+    filesystem::current_path(scratch.parent_path(), error);
+    filesystem::remove_all(scratch, error);
+    cout << checks - failures << "/" << checks << " checks passed\n";
+    return failures == 0 ? 0 : 1;
+}